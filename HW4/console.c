@@ -0,0 +1,411 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "main.h"
+#include "serial_debug.h"
+#include "galaga.h"
+#include "telemetry.h"
+#include "lcd_mirror.h"
+#include "name_entry.h"
+#include "high_scores.h"
+#include "console.h"
+
+// A gameplay value that can be read and changed from the console
+typedef struct {
+	const char *name;
+	int32_t *value;
+	int32_t min;
+	int32_t max;
+	int32_t multiple;				// values must be a multiple of this
+} tunable_t;
+
+// timer_a_cycles must stay a multiple of 5: main.c runs the enemies and
+// sends telemetry frames when counterA%5 == 0 and 4, so any other value
+// makes the last frame of each cycle shorter than the rest
+static const tunable_t tunables[] = {
+	{ "bullet_speed",			&bullet_speed,			1,		25,		1 },
+	{ "tracking_speed",		&tracking_speed,		0,		10,		1 },
+	{ "step",							&enemy_step,				1,		25,		1 },
+	{ "fire_base",				&fire_base,					0,		100,	1 },
+	{ "fire_level_step",	&fire_level_step,		0,		50,		1 },
+	{ "timer_a_cycles",		&timer_a_cycles,		5,		100,	5 },
+	{ "delay_small",			&delay_small,				-100,	0,		1 },
+	{ "delay_large",			&delay_large,				-200,	0,		1 },
+};
+#define NUM_TUNABLES	(sizeof(tunables)/sizeof(tunables[0]))
+
+static const char * const help_lines[] = {
+	"get [name]",
+	"set name value",
+	"pause | run | step [n]",
+	"dump",
+	"tlm on|off",
+	"mirror on|off",
+	"name ABC",
+	"flush",
+};
+#define NUM_HELP_LINES	(sizeof(help_lines)/sizeof(help_lines[0]))
+
+// Replies that are more than one line are sent by a job, one line per poll
+typedef enum {
+	JOB_NONE,
+	JOB_HELP,
+	JOB_GET,
+	JOB_DUMP
+} console_job_t;
+
+// Line being received
+static char line[CONSOLE_LINE_SIZE];
+static uint8_t line_len = 0;
+static bool line_overflow = false;
+
+// Reply line waiting for room in the TX ring
+static char out[CONSOLE_OUT_SIZE];
+static uint8_t out_len = 0;
+
+static console_job_t job = JOB_NONE;
+static uint8_t job_index = 0;
+
+static bool paused = false;
+static uint32_t steps = 0;
+
+//*****************************************************************************
+// Function Name: out_str
+//*****************************************************************************
+//	Summary: Appends a string to the reply line, cutting it at the end
+//
+//*****************************************************************************
+static void out_str(const char *s){
+	while(*s && out_len < CONSOLE_OUT_SIZE - 2) out[out_len++] = *s++;
+}
+
+//*****************************************************************************
+// Function Name: out_int
+//*****************************************************************************
+//	Summary: Appends a signed decimal number to the reply line
+//
+//*****************************************************************************
+static void out_int(int32_t v){
+	char digits[12];
+	int i = sizeof(digits) - 1;
+	uint32_t u = v < 0 ? -(uint32_t)v : v;
+	
+	digits[i] = '\0';
+	do{
+		digits[--i] = '0' + u % 10;
+		u /= 10;
+	} while(u);
+	if(v < 0) digits[--i] = '-';
+	out_str(&digits[i]);
+}
+
+//*****************************************************************************
+// Function Name: out_tunable
+//*****************************************************************************
+//	Summary: Sets the reply line to a parameter's name, value and range
+//
+//*****************************************************************************
+static void out_tunable(const tunable_t *t){
+	out_str(t->name);
+	out_str(" = ");
+	out_int(*t->value);
+	out_str(" (");
+	out_int(t->min);
+	out_str("..");
+	out_int(t->max);
+	if(t->multiple > 1){
+		out_str(" step ");
+		out_int(t->multiple);
+	}
+	out_str(")");
+}
+
+//*****************************************************************************
+// Function Name: out_flush
+//*****************************************************************************
+//	Summary: Queues the reply line if the TX ring has room for all of it
+//
+//	Returns: true if nothing is left waiting
+//
+//*****************************************************************************
+static bool out_flush(void){
+	if(out_len == 0) return true;
+	if(ring_space(&UART0_Tx_Buffer) < out_len + 2) return false;
+	out[out_len++] = '\n';
+	out[out_len++] = '\r';
+	serial_debug_write(UART0_BASE, &UART0_Tx_Buffer, out, out_len);
+	out_len = 0;
+	return true;
+}
+
+//*****************************************************************************
+// Function Name: find_tunable
+//*****************************************************************************
+//	Summary: Looks up a parameter by name, NULL if there is none
+//
+//*****************************************************************************
+static const tunable_t *find_tunable(const char *name){
+	int i;
+	
+	for(i = 0; i < NUM_TUNABLES; i++){
+		if(strcmp(tunables[i].name, name) == 0) return &tunables[i];
+	}
+	return NULL;
+}
+
+//*****************************************************************************
+// Function Name: parse_int
+//*****************************************************************************
+//	Summary: Parses a whole token as a signed decimal number
+//
+//*****************************************************************************
+static bool parse_int(const char *s, int32_t *value){
+	char *end;
+	
+	if(s == NULL || *s == '\0') return false;
+	*value = strtol(s, &end, 10);
+	return *end == '\0';
+}
+
+//*****************************************************************************
+// Function Name: parse_on_off
+//*****************************************************************************
+//	Summary: Parses "on" or "off", anything else is rejected
+//
+//*****************************************************************************
+static bool parse_on_off(const char *s, bool *on){
+	if(s == NULL) return false;
+	if(strcmp(s, "on") == 0) *on = true;
+	else if(strcmp(s, "off") == 0) *on = false;
+	else return false;
+	return true;
+}
+
+//*****************************************************************************
+// Function Name: job_step
+//*****************************************************************************
+//	Summary: Builds the next line of a multi-line reply
+//
+//*****************************************************************************
+static void job_step(void){
+	entity_info_t info;
+	
+	switch(job){
+		case JOB_HELP:
+			if(job_index < NUM_HELP_LINES){
+				out_str(help_lines[job_index++]);
+				return;
+			}
+			break;
+		case JOB_GET:
+			if(job_index < NUM_TUNABLES){
+				out_tunable(&tunables[job_index++]);
+				return;
+			}
+			break;
+		case JOB_DUMP:
+			// Inactive bullets are skipped, units are always listed
+			while(get_entity(job_index++, &info)){
+				if(info.kind != 'U' && !info.active) continue;
+				out[out_len++] = info.kind;
+				out_int(info.num);
+				out_str(info.active ? " on  x=" : " off x=");
+				out_int(info.x);
+				out_str(" y=");
+				out_int(info.y);
+				if(info.kind == 'U'){
+					out_str(" hp=");
+					out_int(info.health);
+					out_str(" st=");
+					out_int(info.move_state);
+				}
+				return;
+			}
+			break;
+		default:
+			break;
+	}
+	job = JOB_NONE;
+}
+
+//*****************************************************************************
+// Function Name: start_job
+//*****************************************************************************
+//	Summary: Starts a multi-line reply
+//
+//*****************************************************************************
+static void start_job(console_job_t next){
+	job = next;
+	job_index = 0;
+}
+
+//*****************************************************************************
+// Function Name: console_execute
+//*****************************************************************************
+//	Summary: Splits a command line into up to three words and runs it
+//
+//*****************************************************************************
+static void console_execute(char *cmd){
+	char *argv[3] = { NULL, NULL, NULL };
+	int argc = 0;
+	const tunable_t *t;
+	int32_t value;
+	bool on;
+	
+	while(*cmd && argc < 3){
+		while(*cmd == ' ') *cmd++ = '\0';
+		if(*cmd == '\0') break;
+		argv[argc++] = cmd;
+		while(*cmd && *cmd != ' ') cmd++;
+	}
+	while(*cmd == ' ') *cmd++ = '\0';
+	if(argc == 0) return;
+	
+	if(strcmp(argv[0], "help") == 0){
+		start_job(JOB_HELP);
+	}
+	else if(strcmp(argv[0], "get") == 0){
+		if(argv[1] == NULL) start_job(JOB_GET);
+		else if((t = find_tunable(argv[1]))) out_tunable(t);
+		else out_str("unknown parameter");
+	}
+	else if(strcmp(argv[0], "set") == 0){
+		t = find_tunable(argv[1] ? argv[1] : "");
+		if(t == NULL) out_str("unknown parameter");
+		else if(!parse_int(argv[2], &value) || value < t->min || value > t->max || value % t->multiple != 0){
+			out_str("out of range, ");
+			out_tunable(t);
+		}
+		else{
+			*t->value = value;
+			out_tunable(t);
+		}
+	}
+	else if(strcmp(argv[0], "pause") == 0){
+		paused = true;
+		steps = 0;
+		out_str("paused");
+	}
+	else if(strcmp(argv[0], "run") == 0){
+		paused = false;
+		out_str("running");
+	}
+	else if(strcmp(argv[0], "step") == 0){
+		if(argv[1] == NULL) value = 1;
+		else if(!parse_int(argv[1], &value) || value < 1) value = 0;
+		paused = true;
+		steps += value;
+		out_str("step ");
+		out_int(value);
+	}
+	else if(strcmp(argv[0], "dump") == 0){
+		start_job(JOB_DUMP);
+	}
+	else if(strcmp(argv[0], "tlm") == 0){
+		if(!parse_on_off(argv[1], &on)) out_str("tlm on|off");
+		else{
+			telemetry_enabled = on;
+			out_str(on ? "telemetry on" : "telemetry off");
+		}
+	}
+	else if(strcmp(argv[0], "mirror") == 0){
+		if(!parse_on_off(argv[1], &on)) out_str("mirror on|off");
+		else{
+			lcd_mirror_enable(on);
+			out_str(on ? "mirror on" : "mirror off");
+		}
+	}
+	else if(strcmp(argv[0], "name") == 0 && argv[1]){
+		// Only accepted while the new record screen is waiting for a name
+		if(name_entry_type(argv[1])){
+			out_str("name ");
+			out_str(name_entry_text());
+		}
+		else out_str("no name wanted, or not 3 letters");
+	}
+	else if(strcmp(argv[0], "flush") == 0){
+		// Waits for the EEPROM, so the game loop stalls for a few ms
+		out_str(hs_flush() ? "scores saved" : "flush failed, scores still dirty");
+	}
+	else{
+		out_str("? try help");
+	}
+}
+
+//*****************************************************************************
+// Function Name: console_poll
+//*****************************************************************************
+//	Summary: Parses the bytes received on UART0 since the last call and runs
+//					 any complete command.  A reply is finished before the next
+//					 command is read, so a long reply holds input in the RX ring.
+//
+//*****************************************************************************
+void console_poll(void){
+	int c, i;
+	
+	if(!out_flush()) return;
+	if(job != JOB_NONE){
+		job_step();
+		out_flush();
+		return;
+	}
+	
+	for(i = 0; i < CONSOLE_RX_PER_POLL; i++){
+		c = serial_debug_rx(&UART0_Rx_Buffer, false);
+		if(c < 0) return;
+		
+		if(c == '\r' || c == '\n'){
+			if(line_overflow) out_str("line too long");
+			else if(line_len > 0){
+				line[line_len] = '\0';
+				console_execute(line);
+			}
+			line_len = 0;
+			line_overflow = false;
+			out_flush();
+			return;
+		}
+		else if(c == '\b' || c == 0x7F){
+			if(line_len > 0) line_len--;
+		}
+		else if(line_len < CONSOLE_LINE_SIZE - 1){
+			line[line_len++] = c;
+		}
+		else{
+			line_overflow = true;
+		}
+	}
+}
+
+//*****************************************************************************
+// Function Name: console_hold
+//*****************************************************************************
+//	Summary: Returns true if the game tick should be skipped because the game
+//					 is paused from the console.  Each call that returns false while
+//					 paused uses up one step.
+//
+//*****************************************************************************
+bool console_hold(void){
+	if(!paused) return false;
+	if(steps == 0) return true;
+	steps--;
+	return false;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef __CONSOLE_H__
+#define __CONSOLE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DEFINE CONSOLE VARS ========================================================
+// Longest command line, longer lines are discarded
+#define CONSOLE_LINE_SIZE						40
+
+// Longest reply line
+#define CONSOLE_OUT_SIZE						64
+
+// Received bytes parsed per call to console_poll
+#define CONSOLE_RX_PER_POLL					16
+
+//*****************************************************************************
+// Function Name: console_poll
+//*****************************************************************************
+//	Summary: Parses the bytes received on UART0 since the last call and runs
+//					 any complete command.  Never waits: replies are queued one
+//					 line at a time as the TX ring has room.  Call from the main
+//					 loop.
+//
+//	Commands:
+//					 help								list the commands
+//					 get [name]					show one or all tunable parameters
+//					 set name value			change a tunable parameter
+//					 pause / run				stop or restart the game ticks
+//					 step [n]						run n game ticks, then pause again
+//					 dump								print the unit and bullet tables
+//					 tlm on|off					start or stop the telemetry stream
+//					 mirror on|off				start or stop sending the LCD drawing
+//					 name ABC						enter the high score name on the new
+//															record screen
+//
+//*****************************************************************************
+void console_poll(void);
+
+//*****************************************************************************
+// Function Name: console_hold
+//*****************************************************************************
+//	Summary: Returns true if the game tick should be skipped because the game
+//					 is paused from the console.  Each call that returns false while
+//					 paused uses up one step.
+//
+//*****************************************************************************
+bool console_hold(void);
+
+#endif
@@ -0,0 +1,206 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include <stddef.h>
+
+#include "main.h"
+#include "i2c.h"
+#include "eeprom.h"
+#include "validate.h"
+#include "crc16.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "fault.h"
+
+// The record has to fit in its EEPROM region
+typedef char fault_record_fits[(sizeof(fault_record_t) <= FAULT_SIZE) ? 1 : -1];
+
+volatile uint32_t fault_state = 0;
+
+// Built here rather than on the stack, which may be what went wrong
+static fault_record_t fault_record;
+
+//*****************************************************************************
+// Function Name: fault_send
+//*****************************************************************************
+//	Summary: Sends the registers of a fault record as a TLM_FAULT record
+//
+//*****************************************************************************
+static void fault_send(const fault_record_t *rec, bool polled){
+	uint32_t words[TLM_FAULT_SIZE / 4];
+	uint8_t payload[TLM_FAULT_SIZE];
+	uint32_t i;
+	
+	words[0] = rec->frame.pc;
+	words[1] = rec->frame.lr;
+	words[2] = rec->frame.xpsr;
+	words[3] = rec->sp;
+	words[4] = rec->cfsr;
+	words[5] = rec->hfsr;
+	words[6] = rec->mmfar;
+	words[7] = rec->bfar;
+	words[8] = rec->frame.r0;
+	words[9] = rec->frame.r1;
+	words[10] = rec->frame.r2;
+	words[11] = rec->frame.r3;
+	words[12] = rec->frame.r12;
+	words[13] = rec->exc_return;
+	words[14] = rec->state;
+	for(i = 0; i < TLM_FAULT_SIZE; i++) payload[i] = words[i / 4] >> (8 * (i % 4));
+	telemetry_record(TLM_FAULT, payload, TLM_FAULT_SIZE, polled);
+}
+
+//*****************************************************************************
+// Function Name: fault_capture
+//*****************************************************************************
+//	Summary: Called by HardFault_Handler with the stack the core pushed the
+//					 fault frame on and the EXC_RETURN value.  Never returns.
+//
+//*****************************************************************************
+void fault_capture(uint32_t *stack, uint32_t exc_return){
+	uint32_t head = trace_head;
+	uint32_t i;
+	
+	fault_record.magic = FAULT_MAGIC;
+	fault_record.frame = *(fault_frame_t *)stack;
+	fault_record.exc_return = exc_return;
+	
+	// xPSR bit 9 says the core padded the frame to align the stack
+	fault_record.sp = (uint32_t)stack + sizeof(fault_frame_t) + ((fault_record.frame.xpsr & (1UL << 9)) ? 4 : 0);
+	fault_record.cfsr = SCB->CFSR;
+	fault_record.hfsr = SCB->HFSR;
+	fault_record.mmfar = SCB->MMFAR;
+	fault_record.bfar = SCB->BFAR;
+	fault_record.state = fault_state;
+	fault_record.trace_head = head;
+	for(i = 0; i < FAULT_TRACE_ENTRIES; i++){
+		fault_record.trace[i] = trace_ring[(head - FAULT_TRACE_ENTRIES + i) & (TRACE_DEPTH - 1)];
+	}
+	fault_record.crc = crc16(CRC16_INIT, (uint8_t *)&fault_record, offsetof(fault_record_t, crc));
+	
+	// The EEPROM copy matters most.  A transfer that was cut off by the
+	// fault may still hold the bus, so free it first.  Queued transactions
+	// are dropped beforehand so the recovery does not run their callbacks,
+	// whose state may be what faulted.
+	i2cAsyncDrop(I2C1_BASE);
+	i2cBusRecover(I2C1_BASE, EEPROM_GPIO_BASE, EEPROM_I2C_SCL_PIN, EEPROM_I2C_SDA_PIN);
+	eeprom_write(I2C1_BASE, FAULT_ADDR, (uint8_t *)&fault_record, sizeof(fault_record));
+	
+	// Interrupts cannot run from here, so the UART is written directly.  The
+	// whole trace ring goes out, not just the entries saved, even if a pause
+	// dump already sent some of it.
+	fault_send(&fault_record, true);
+	trace_rewind();
+	trace_dump(true);
+	
+	NVIC_SystemReset();
+	while(1);
+}
+
+//*****************************************************************************
+// Function Name: HardFault_Handler
+//*****************************************************************************
+//	Summary: Bit 2 of EXC_RETURN says whether the fault frame is on the main
+//					 or the process stack.  The configurable faults are not enabled,
+//					 so they arrive here too; CFSR says which it was.
+//
+//*****************************************************************************
+#if defined(__CC_ARM)
+__asm void HardFault_Handler(void)
+{
+	IMPORT	fault_capture
+	TST			LR, #4
+	ITE			EQ
+	MRSEQ		R0, MSP
+	MRSNE		R0, PSP
+	MOV			R1, LR
+	B				fault_capture
+}
+#else
+__attribute__((naked)) void HardFault_Handler(void)
+{
+	__asm volatile(
+		"tst lr, #4\n"
+		"ite eq\n"
+		"mrseq r0, msp\n"
+		"mrsne r0, psp\n"
+		"mov r1, lr\n"
+		"b fault_capture\n"
+	);
+}
+#endif
+
+//*****************************************************************************
+// Function Name: print_hex
+//*****************************************************************************
+//	Summary: Prints a label followed by a 32-bit value in hex
+//
+//*****************************************************************************
+static void print_hex(char *label, uint32_t value){
+	char hex[11] = "0x";
+	int i;
+	
+	for(i = 0; i < 8; i++) hex[2 + i] = "0123456789ABCDEF"[(value >> (28 - 4 * i)) & 0xF];
+	hex[10] = '\0';
+	put_string(label);
+	put_string(hex);
+	put_string("\n\r");
+}
+
+//*****************************************************************************
+// Function Name: fault_report
+//*****************************************************************************
+//	Summary: Prints the fault record saved before the last reset, if there is
+//					 one, and clears it.  The text is for a terminal, the telemetry
+//					 records that follow are for tools/fault_symbolize.
+//
+//	Returns: true if a fault was reported
+//
+//*****************************************************************************
+bool fault_report(void){
+	uint32_t clear = 0;
+	uint32_t i, n;
+	
+	if(eeprom_read(I2C1_BASE, FAULT_ADDR, (uint8_t *)&fault_record, sizeof(fault_record)) != I2C_OK) return false;
+	if(fault_record.magic != FAULT_MAGIC) return false;
+	if(fault_record.crc != crc16(CRC16_INIT, (uint8_t *)&fault_record, offsetof(fault_record_t, crc))) return false;
+	
+	put_string("\n\rHARD FAULT before the last reset\n\r");
+	print_hex("  pc    ", fault_record.frame.pc);
+	print_hex("  lr    ", fault_record.frame.lr);
+	print_hex("  sp    ", fault_record.sp);
+	print_hex("  xpsr  ", fault_record.frame.xpsr);
+	print_hex("  cfsr  ", fault_record.cfsr);
+	print_hex("  hfsr  ", fault_record.hfsr);
+	print_hex("  mmfar ", fault_record.mmfar);
+	print_hex("  bfar  ", fault_record.bfar);
+	print_hex("  state ", fault_record.state);
+	fault_send(&fault_record, false);
+	
+	// Entries before the first one logged were never written
+	n = fault_record.trace_head < FAULT_TRACE_ENTRIES ? fault_record.trace_head : FAULT_TRACE_ENTRIES;
+	for(i = FAULT_TRACE_ENTRIES - n; i < FAULT_TRACE_ENTRIES; i++) trace_send(&fault_record.trace[i], false);
+	put_string("\n\r");
+	
+	// Report it once
+	eeprom_write(I2C1_BASE, FAULT_ADDR, (uint8_t *)&clear, sizeof(clear));
+	return true;
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef __FAULT_H__
+#define __FAULT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "trace.h"
+
+// DEFINE FAULT VARS ==========================================================
+#define FAULT_MAGIC									0x464C5421		// "!TLF"
+
+// Newest trace entries saved with a fault, sized to fill the EEPROM region
+#define FAULT_TRACE_ENTRIES					15
+
+// Registers the core pushed on entry to the fault, in stack order
+typedef struct {
+	uint32_t r0;
+	uint32_t r1;
+	uint32_t r2;
+	uint32_t r3;
+	uint32_t r12;
+	uint32_t lr;
+	uint32_t pc;
+	uint32_t xpsr;
+} fault_frame_t;
+
+// Saved to FAULT_ADDR in the EEPROM.  crc covers everything before it.
+typedef struct {
+	uint32_t magic;
+	fault_frame_t frame;
+	uint32_t exc_return;						// LR on entry, says which stack was in use
+	uint32_t sp;										// stack pointer before the frame was pushed
+	uint32_t cfsr;
+	uint32_t hfsr;
+	uint32_t mmfar;
+	uint32_t bfar;
+	uint32_t state;									// fault_state when it happened
+	uint32_t trace_head;
+	trace_entry_t trace[FAULT_TRACE_ENTRIES];
+	uint16_t crc;
+} fault_record_t;
+
+// What the program is doing, saved with a fault.  main.c keeps the current
+// game state here.
+extern volatile uint32_t fault_state;
+
+//*****************************************************************************
+// Function Name: HardFault_Handler
+//*****************************************************************************
+//	Summary: Replaces the startup file's endless loop.  Saves a fault record
+//					 to the EEPROM, sends it and the trace ring over UART0 without
+//					 interrupts and resets the board.
+//
+//*****************************************************************************
+void HardFault_Handler(void);
+
+//*****************************************************************************
+// Function Name: fault_report
+//*****************************************************************************
+//	Summary: Prints the fault record saved before the last reset, if there is
+//					 one, and clears it.  Call once at boot after the serial port
+//					 and the I2C bus are up.
+//
+//	Returns: true if a fault was reported
+//
+//*****************************************************************************
+bool fault_report(void);
+
+#endif
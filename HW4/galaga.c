@@ -28,6 +28,8 @@
 #include "galaga_bitmaps.h"
 #include "galaga.h"
 #include "eeprom.h"
+#include "telemetry.h"
+#include "trace.h"
 
 typedef enum direction {
 	DIR_U,
@@ -78,10 +80,16 @@ short player_lives = PLAYER_START_LIVES;
 uint32_t high_score = 0, player_score=0;
 uint32_t level;
 
-uint32_t high_scores[5];
 
-uint32_t hs_initials[5];
-uint32_t high_scores[5];
+// Gameplay constants, start at the defaults in galaga.h and can be changed
+// from the serial console while the game runs
+int32_t bullet_speed = BULLET_SPEED;
+int32_t tracking_speed = TRACKING_SPEED;
+int32_t enemy_step = STEP;
+int32_t fire_base = FIRE_BASE;
+int32_t fire_level_step = FIRE_LEVEL_STEP;
+int32_t delay_small = DELAY_SMALL;
+int32_t delay_large = DELAY_LARGE;
 
 unit_t units[NUM_UNITS];
 bullet_t player_bullets[NUM_PLAYER_BULLETS];
@@ -167,11 +175,11 @@ void initialize_units(){
 			units[i].pos.x						= FORMATION_1_LEFT_START_X;
 			units[i].pos.y 						= FORMATION_1_START_Y;
 			if(i==7)
-				units[i].formation_index 	= 0 + DELAY_SMALL*(3);
+				units[i].formation_index 	= 0 + delay_small*(3);
 			else if(i==13)
-				units[i].formation_index 	= 0 + DELAY_SMALL*(4);
+				units[i].formation_index 	= 0 + delay_small*(4);
 			else
-				units[i].formation_index 	= 0 + DELAY_SMALL*(i-1);
+				units[i].formation_index 	= 0 + delay_small*(i-1);
 		} 
 		// First wave - right
 		else if(i==3 || i==4|| i==8 || i==14)
@@ -180,11 +188,11 @@ void initialize_units(){
 			units[i].pos.x						= FORMATION_1_RIGHT_START_X;
 			units[i].pos.y 						= FORMATION_1_START_Y;
 			if(i==8)
-				units[i].formation_index 	= 0 + DELAY_SMALL*(3);
+				units[i].formation_index 	= 0 + delay_small*(3);
 			else if(i==14)
-				units[i].formation_index 	= 0 + DELAY_SMALL*(4);
+				units[i].formation_index 	= 0 + delay_small*(4);
 			else
-			units[i].formation_index 	= 0 + DELAY_SMALL*(i-3);
+			units[i].formation_index 	= 0 + delay_small*(i-3);
 		} 
 		// Second wave
 		else if (i == 5 || i==6 || i==11 || i==12) 
@@ -192,7 +200,7 @@ void initialize_units(){
 			units[i].dir 							= DIR_UR; 
 			units[i].pos.x						= FORMATION_2_LEFT_START_X;
 			units[i].pos.y 						= FORMATION_2_START_Y;
-			units[i].formation_index 	= DELAY_LARGE*2  + DELAY_SMALL*(i-5);
+			units[i].formation_index 	= delay_large*2  + delay_small*(i-5);
 		} 
 		// Third wave
 		else if (i == 9 || i==10 || i==15 || i==16) 
@@ -200,7 +208,7 @@ void initialize_units(){
 			units[i].dir 							= DIR_UL; 
 			units[i].pos.x						= FORMATION_2_RIGHT_START_X;
 			units[i].pos.y 						= FORMATION_2_START_Y;
-			units[i].formation_index 	= DELAY_LARGE*2 + DELAY_SMALL*(i-9);
+			units[i].formation_index 	= delay_large*2 + delay_small*(i-9);
 		} 
 	}
 };
@@ -276,21 +284,14 @@ bool update_LCD () {
 //*****************************************************************************
 void game_init() {
 	short i;
-	lcd_clear_screen(LCD_COLOR_BLACK);
 	initialize_units();
 	player_lives = PLAYER_START_LIVES;
 	update_LCD();
 	level = 1;
 	player_score = 0;
 	
-	// Make sure high scores is up to date
-	pull_high_scores();
-	
-	// Get the highest scores
+	// The leaderboard is sorted, the first entry is the highest score
 	high_score = high_scores[0];
-	for(i=1; i<NUM_HIGH_SCORES; i++) {
-		if(high_score < high_scores[i]) high_score = high_scores[i];
-	}
 	
 	// Initialize all bullets to inactive
 	for(i=0;i<NUM_PLAYER_BULLETS;i++) player_bullets[i].active = false;
@@ -304,6 +305,7 @@ void level_up(){
 	initialize_units();
 	update_LCD();
 	level++;
+	TRACE1(LEVEL_UP, level);
 	
 	// Initialize all bullets to inactive
 	for(i=0;i<NUM_PLAYER_BULLETS;i++) player_bullets[i].active = false;
@@ -333,7 +335,7 @@ void level_up(){
 bool move_to_destination(int unit_num, uint16_t x, uint16_t y){
 	bool x_reached = false;
 	bool y_reached = false;
-	int step = STEP;
+	int step = enemy_step;
 	
 	if((x - units[unit_num].pos.x) < step && (units[unit_num].pos.x - x) < step) {
 			units[unit_num].pos.x = x;
@@ -381,7 +383,8 @@ void fire_bullet (bool player_bullet, uint32_t rand_num) {
 				}
 			}
 		} else{
-			fire = (int)(((rand_num)%100)/(95 - level*5));
+			// Fire when a roll of 0-99 reaches a threshold that drops each level
+			fire = (int)(rand_num%100) >= fire_base - (int32_t)level*fire_level_step;
 			j = rand_num %(NUM_UNITS-1) + 1;
 			if(fire && units[j].active){
 				for(i=0;i<NUM_ENEMY_BULLETS;i++){
@@ -543,6 +546,78 @@ void update_player_score
 	
 	// update player_score
 	player_score += points;
+	telemetry_score(player_score, points, type);
+}
+
+
+//*****************************************************************************
+// Function Name: count_entities
+//*****************************************************************************
+//	Summary: Counts the active enemies and bullets for telemetry
+//
+//*****************************************************************************
+void count_entities(tlm_entities_t *counts){
+	short i;
+	
+	counts->units = 0;
+	counts->player_bullets = 0;
+	counts->enemy_bullets = 0;
+	for(i=1; i<NUM_UNITS; i++){
+		if(units[i].active) counts->units++;
+	}
+	for(i=0; i<NUM_PLAYER_BULLETS; i++){
+		if(player_bullets[i].active) counts->player_bullets++;
+	}
+	for(i=0; i<NUM_ENEMY_BULLETS; i++){
+		if(enemy_bullets[i].active) counts->enemy_bullets++;
+	}
+	counts->lives = player_lives;
+	counts->level = level;
+}
+
+
+//*****************************************************************************
+// Function Name: get_entity
+//*****************************************************************************
+//	Summary: Fills info with one entry of the unit and bullet tables.  The
+//					 units come first, then the player's and the enemies' bullets.
+//
+//	Returns: false once index is past the last bullet
+//
+//*****************************************************************************
+bool get_entity(uint8_t index, entity_info_t *info){
+	bullet_t *bullet;
+	
+	if(index < NUM_UNITS){
+		info->kind = 'U';
+		info->num = index;
+		info->active = units[index].active;
+		info->x = units[index].pos.x;
+		info->y = units[index].pos.y;
+		info->health = units[index].health;
+		info->move_state = units[index].move_state;
+		return true;
+	}
+	index -= NUM_UNITS;
+	if(index < NUM_PLAYER_BULLETS){
+		info->kind = 'P';
+		bullet = &player_bullets[index];
+	}
+	else if(index - NUM_PLAYER_BULLETS < NUM_ENEMY_BULLETS){
+		index -= NUM_PLAYER_BULLETS;
+		info->kind = 'E';
+		bullet = &enemy_bullets[index];
+	}
+	else{
+		return false;
+	}
+	info->num = index;
+	info->active = bullet->active;
+	info->x = bullet->pos.x;
+	info->y = bullet->pos.y;
+	info->health = 0;
+	info->move_state = 0;
+	return true;
 }
 
 
@@ -559,8 +634,8 @@ void update_bullets(){
 			//Reset the previous position to the background color
 			lcd_draw_bullet(player_bullets[i].pos.x, BULLET_WIDTH, player_bullets[i].pos.y, BULLET_HEIGHT, LCD_COLOR_BLACK);
 			
-			//Update the position of the bullet based on BULLET_SPEED
-			player_bullets[i].pos.y += BULLET_SPEED;
+			//Update the position of the bullet based on bullet_speed
+			player_bullets[i].pos.y += bullet_speed;
 			
 			//If the bullet has reached the top, set to inactive.
 			if(player_bullets[i].pos.y>=BOUNDRY_Y_TOP){
@@ -581,6 +656,7 @@ void update_bullets(){
 							player_bullets[i].active = false;
 							
 							units[j].health--;
+							TRACE2(ENEMY_HIT, j, units[j].health);
 							if(units[j].health == 0){
 								// Change to an explosion and set formation_index to leave the explosion for 2 cycles
 								units[j].move_state = EXPLOSION;
@@ -606,7 +682,7 @@ void update_bullets(){
 			lcd_draw_bullet(enemy_bullets[i].pos.x, BULLET_WIDTH, enemy_bullets[i].pos.y, BULLET_HEIGHT,LCD_COLOR_BLACK);
 			
 			
-			enemy_bullets[i].pos.y -= BULLET_SPEED;
+			enemy_bullets[i].pos.y -= bullet_speed;
 			
 			
 			if(level>2){
@@ -614,8 +690,8 @@ void update_bullets(){
 				dY = enemy_bullets[i].pos.y-UNIT_SIZE/2 - units[0].pos.y;
 				track_index++;
 				if(track_index<=5-level){
-					if(dX>0) enemy_bullets[i].pos.x 			-= TRACKING_SPEED;
-					else if(dX<0) enemy_bullets[i].pos.x 	+= TRACKING_SPEED;
+					if(dX>0) enemy_bullets[i].pos.x 			-= tracking_speed;
+					else if(dX<0) enemy_bullets[i].pos.x 	+= tracking_speed;
 					track_index = 0;
 				}
 			}
@@ -627,6 +703,7 @@ void update_bullets(){
 				enemy_bullets[i].active = false;
 			} else if((dX>=HITBOX_BUFFER) && (dY>=HITBOX_BUFFER) && (dX<=UNIT_SIZE - HITBOX_BUFFER) && (dY<=UNIT_SIZE - HITBOX_BUFFER)){
 				units[0].health--;
+				TRACE2(PLAYER_HIT, i, units[0].health);
 				if(units[0].health == 0){
 					lcd_clear_Image(units[0].pos.x, units[0].pos.y);
 					units[0].move_state = EXPLOSION;
@@ -645,9 +722,11 @@ void update_bullets(){
 // Function Name: update_player
 //*****************************************************************************
 //	Summary: Updates the position of player
+//
+//	Returns: true once the player has been redrawn on the LCD
 // 
 //*****************************************************************************
-void update_player(bool left) {
+bool update_player(bool left) {
 
 	if((units[0].active)){
 		lcd_clear_Image(units[0].pos.x, units[0].pos.y);
@@ -655,7 +734,9 @@ void update_player(bool left) {
 		else if(!left &&units[0].pos.x>=5)		units[0].pos.x -= 5;
 		
 		lcd_print_Image(units[0].pos.x, units[0].pos.y, units[0].type, units[0].dir);
+		return true;
 	}
+	return false;
 }
 
 
@@ -724,10 +805,6 @@ void print_high_scores(){
 	lcd_print_stringXY(banner, 1, 5, GALAGA_COLOR_1, LCD_COLOR_BLACK );
 	lcd_print_stringXY(msg, 2,18, GALAGA_COLOR_2, LCD_COLOR_BLACK );
 
-	// Update scores before printing
-	pull_high_scores();
-	
-	
 	// For each score
 	for (i = 0; i < NUM_HIGH_SCORES; i++){
 		
@@ -752,109 +829,6 @@ void print_high_scores(){
 	
 }
 
-//*****************************************************************************
-// Function Name: pull_high_scores
-//*****************************************************************************
-//	Summary: Reads high scores and names from EEPROM to highscores[] and
-//					 initials[] respectively
-// 
-//*****************************************************************************	
-void pull_high_scores(){
-	uint8_t read_val;
-	uint16_t addr;
-	char* initials;
-	int i,j;
-	
-	// set start address
-	addr = ADDR_START;
-	
-	// for each high score slot
-	for( i = 0; i < NUM_HIGH_SCORES; i++){
-		
-		// clear old data
-		high_scores[i] = 0;
-		
-		// write each byte the correct location within the uint32
-		for( j = 0; j < 4; j++){	
-			eeprom_byte_read(I2C1_BASE,addr, &read_val);
-			high_scores[i] |= read_val << (j*8);
-			addr++;
-		}
-		
-		// wipe old name data (sets all to null terminator)
-		hs_initials[i] = 0;
-		
-		// cast hs_initials[i] to char array for easier access
-		initials = (char*)&hs_initials[i];
-		
-		// write name data (initials) to first three indexes
-		for( j = 0; j < 3; j++){
-			eeprom_byte_read(I2C1_BASE,addr, &read_val);
-			initials[j] = (char)read_val;
-			addr++;
-		}
-	}
-	
-}
-
-//*****************************************************************************
-// Function Name: push_high_scores
-//*****************************************************************************
-//	Summary: writes player score and name to EEPROM to after verifying
-//					 player's score is highest than lowest on leaderboard
-//
-//	Params:
-//					 initials - the playser's entered initials
-//
-//	Returns:
-//					 true - score written
-//					 false - score not high enough to be written
-//
-//*****************************************************************************	
-bool push_high_scores(char* initials){
-	uint32_t low_score = 0xFFFFFFFF; //value of lowest high score
-	int low_index = 0; //index of lowest high score
-	uint8_t write_val;
-	uint16_t addr;
-	int i,j;
-	
-	// Upadate high scores before making changes
-	pull_high_scores();
-	
-	// Search for value and index of lowest high score
-	for(i = 0; i < NUM_HIGH_SCORES; i++){
-		if( high_scores[i] < low_score){
-			low_index = i;
-			low_score = high_scores[i];
-		}
-	}
-
-	// Only update if player score is greater than lowest score on list
-	if ( player_score > low_score ){
-		
-		// Calculate address and offset of lowest score
-		addr = ADDR_START;
-		addr += 7*low_index;
-		
-		// send each byte of the uint32_t to the EEPROM
-		for(i = 0; i < 4; i++){
-			write_val = ( player_score >> (8*i) ) & 0xFF;
-			eeprom_byte_write(I2C1_BASE,addr, write_val);
-			addr++;
-		}
-		
-		// send the first three bytes of name containing char data to EEPROM
-		for(i = 0; i < 3; i++){
-			write_val = (uint8_t) initials[i];
-			eeprom_byte_write(I2C1_BASE,addr, (int)initials[i]);
-			addr++;
-		}
-		return true;
-	} else {
-		return false;
-	}
-	
-}
 //*****************************************************************************
 // Function Name: print_new_record
 //*****************************************************************************
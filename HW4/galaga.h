@@ -29,9 +29,11 @@
 
 #include "TM4C123.h"
 #include "galaga_bitmaps.h"
+#include "high_scores.h"
+#include "telemetry.h"
 
 
-#define STEP	5;
+#define STEP	5
 
 #define FORMATION_1_LEFT_START_X		150
 #define FORMATION_1_RIGHT_START_X		60
@@ -56,10 +58,7 @@
 #define ROW_2_START									180
 #define ROW_3_START									180
 
-#define NUM_HIGH_SCORES							5
-
 extern uint32_t player_score;
-extern uint32_t high_scores[5];
 
 
 #define DELAY_SMALL									-5
@@ -78,6 +77,32 @@ extern uint32_t high_scores[5];
 #define TRACKING_SPEED							1
 #define HITBOX_BUFFER								1
 
+// An enemy fires when a roll of 0-99 is at least
+// FIRE_BASE - level*FIRE_LEVEL_STEP
+#define FIRE_BASE										95
+#define FIRE_LEVEL_STEP							5
+
+// Runtime copies of the constants above, tuned from the serial console.
+// The delays take effect when the next wave is set up.
+extern int32_t bullet_speed;
+extern int32_t tracking_speed;
+extern int32_t enemy_step;
+extern int32_t fire_base;
+extern int32_t fire_level_step;
+extern int32_t delay_small;
+extern int32_t delay_large;
+
+// One row of the entity table dump
+typedef struct {
+	char kind;											// 'U' unit, 'P' player bullet, 'E' enemy bullet
+	uint8_t num;										// index in its own table
+	bool active;
+	uint16_t x;
+	uint16_t y;
+	int16_t health;									// units only
+	uint8_t move_state;							// units only
+} entity_info_t;
+
 
 
 
@@ -134,13 +159,42 @@ void fire_bullet (
 //*****************************************************************************
 bool update_enemies();
 
+//*****************************************************************************
+// Function Name: level_up
+//*****************************************************************************
+//	Summary: Starts the next level once every enemy is gone
+// 
+//*****************************************************************************
+void level_up();
+
 //*****************************************************************************
 // Function Name: update_player
 //*****************************************************************************
 //	Summary: Updates the position of player
+//
+//	Returns: true once the player has been redrawn on the LCD
 // 
 //*****************************************************************************	
-void update_player(bool left);
+bool update_player(bool left);
+
+//*****************************************************************************
+// Function Name: count_entities
+//*****************************************************************************
+//	Summary: Counts the active enemies and bullets for telemetry
+//
+//*****************************************************************************
+void count_entities(tlm_entities_t *counts);
+
+//*****************************************************************************
+// Function Name: get_entity
+//*****************************************************************************
+//	Summary: Fills info with one entry of the unit and bullet tables.  The
+//					 units come first, then the player's and the enemies' bullets.
+//
+//	Returns: false once index is past the last bullet
+//
+//*****************************************************************************
+bool get_entity(uint8_t index, entity_info_t *info);
 
 	
 	
@@ -168,27 +222,6 @@ void print_game_over();
 //*****************************************************************************	
 void print_high_scores();
 
-//*****************************************************************************
-// Function Name: pull_high_scores
-//*****************************************************************************
-//	Summary: Reads high scores and names from EEPROM to highscores[] and
-//					 initials[] respectively
-// 
-//*****************************************************************************	
-void pull_high_scores();
-
-//*****************************************************************************
-// Function Name: push_high_scores
-//*****************************************************************************
-//	Summary: writes player score and name to EEPROM to after verifying
-//					 player's score is highest than lowest on leaderboard
-//
-//	Returs:	true - score written
-//					false - score not high enough to be written
-//
-//*****************************************************************************	
-bool push_high_scores(char* initials);
-
 //*****************************************************************************
 // Function Name: print_new_record
 //*****************************************************************************
@@ -0,0 +1,259 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "main.h"
+#include "i2c.h"
+#include "eeprom.h"
+#include "record_log.h"
+#include "high_scores.h"
+#include "trace.h"
+
+uint32_t high_scores[NUM_HIGH_SCORES];
+uint32_t hs_initials[NUM_HIGH_SCORES];
+
+// One bit per entry that differs from the EEPROM
+static uint8_t hs_dirty = 0;
+
+//*****************************************************************************
+// Function Name: hs_unpack
+//*****************************************************************************
+//	Summary: Loads entry index from its EEPROM form: the score, least
+//					 significant byte first, then three initials.
+//
+//*****************************************************************************
+static void hs_unpack(int index, const uint8_t *entry){
+	char* initials;
+	int i;
+	
+	high_scores[index] = 0;
+	for( i = 0; i < 4; i++){	
+		high_scores[index] |= (uint32_t)entry[i] << (i*8);
+	}
+	
+	// wipe old name data (sets all to null terminator)
+	hs_initials[index] = 0;
+	
+	// cast hs_initials[index] to char array for easier access
+	initials = (char*)&hs_initials[index];
+	for( i = 0; i < 3; i++){
+		initials[i] = (char)entry[4+i];
+	}
+}
+
+//*****************************************************************************
+// Function Name: hs_pack
+//*****************************************************************************
+//	Summary: Stores entry index in its EEPROM form
+//
+//*****************************************************************************
+static void hs_pack(int index, uint8_t *entry){
+	char *initials = (char*)&hs_initials[index];
+	int i;
+	
+	for(i = 0; i < 4; i++){
+		entry[i] = ( high_scores[index] >> (8*i) ) & 0xFF;
+	}
+	for(i = 0; i < 3; i++){
+		entry[4+i] = (uint8_t) initials[i];
+	}
+}
+
+//*****************************************************************************
+// Function Name: hs_load_legacy
+//*****************************************************************************
+//	Summary: Reads the old fixed table at ADDR_START in one sequential read
+//					 and marks every entry dirty so the write-back moves it into
+//					 the record log
+//
+//*****************************************************************************
+static bool hs_load_legacy(void){
+	uint8_t table[HS_ENTRY_SIZE*NUM_HIGH_SCORES];
+	int i;
+	
+	if(eeprom_read(I2C1_BASE, ADDR_START, table, sizeof(table)) != I2C_OK){
+		return false;
+	}
+	
+	for( i = 0; i < NUM_HIGH_SCORES; i++){
+		hs_unpack(i, table + HS_ENTRY_SIZE*i);
+		if(high_scores[i] != 0) hs_dirty |= 1 << i;
+	}
+	return true;
+}
+
+//*****************************************************************************
+// Function Name: hs_sort
+//*****************************************************************************
+//	Summary: Insertion sorts the table highest score first.  Tables written
+//					 before it was kept sorted are in slot order; every entry that
+//					 moves is marked dirty so the EEPROM copy ends up sorted too.
+//
+//*****************************************************************************
+static void hs_sort(void){
+	uint32_t score, initials;
+	int i, j;
+	
+	for(i = 1; i < NUM_HIGH_SCORES; i++){
+		score = high_scores[i];
+		initials = hs_initials[i];
+		for(j = i; j > 0 && high_scores[j-1] < score; j--){
+			high_scores[j] = high_scores[j-1];
+			hs_initials[j] = hs_initials[j-1];
+			hs_dirty |= 1 << j;
+		}
+		if(j != i){
+			high_scores[j] = score;
+			hs_initials[j] = initials;
+			hs_dirty |= 1 << j;
+		}
+	}
+}
+
+//*****************************************************************************
+// Function Name: hs_init
+//*****************************************************************************
+//	Summary: Recovers the table from the record log.  An empty log means
+//					 this board still has the old fixed table, which is migrated.
+//					 Log index i holds the entry ranked i.
+//
+//*****************************************************************************
+bool hs_init(void){
+	uint8_t records[NUM_HIGH_SCORES][RLOG_DATA_SIZE];
+	uint8_t found;
+	int i;
+	
+	hs_dirty = 0;
+	for(i = 0; i < NUM_HIGH_SCORES; i++){
+		high_scores[i] = 0;
+		hs_initials[i] = 0;
+	}
+	
+	found = rlog_mount(records, NUM_HIGH_SCORES);
+	if(found == 0){
+		if(!hs_load_legacy()) return false;
+	}
+	else{
+		for(i = 0; i < NUM_HIGH_SCORES; i++){
+			if(found & (1 << i)) hs_unpack(i, records[i]);
+		}
+	}
+	
+	hs_sort();
+	return true;
+}
+
+//*****************************************************************************
+// Function Name: hs_qualifies
+//*****************************************************************************
+//	Summary: The table is sorted so the last entry is the lowest
+//
+//*****************************************************************************
+bool hs_qualifies(uint32_t score){
+	return score > high_scores[NUM_HIGH_SCORES-1];
+}
+
+//*****************************************************************************
+// Function Name: hs_submit
+//*****************************************************************************
+//	Summary: Binary searches for the first entry lower than score, shifts the
+//					 entries below it down one and marks that suffix dirty.  A
+//					 score equal to an existing one goes below it.
+//
+//*****************************************************************************
+bool hs_submit(uint32_t score, char *initials){
+	int lo = 0, hi = NUM_HIGH_SCORES - 1, mid;
+	char *dest;
+	int i;
+	
+	// Only update if player score is greater than lowest score on list
+	if(!hs_qualifies(score)) return false;
+	
+	// high_scores[hi] < score, find the first such entry
+	while(lo < hi){
+		mid = (lo + hi) / 2;
+		if(high_scores[mid] < score) hi = mid;
+		else lo = mid + 1;
+	}
+	
+	// Drop the lowest entry and make room
+	for(i = NUM_HIGH_SCORES - 1; i > lo; i--){
+		high_scores[i] = high_scores[i-1];
+		hs_initials[i] = hs_initials[i-1];
+	}
+	
+	high_scores[lo] = score;
+	hs_initials[lo] = 0;
+	dest = (char*)&hs_initials[lo];
+	for(i = 0; i < 3; i++) dest[i] = initials[i];
+	
+	hs_dirty |= ((1 << NUM_HIGH_SCORES) - 1) & ~((1 << lo) - 1);
+	TRACE2(HS_SUBMIT, score, lo + 1);
+	return true;
+}
+
+//*****************************************************************************
+// Function Name: hs_write_entry
+//*****************************************************************************
+//	Summary: Appends one entry of the RAM table to the record log
+//
+//*****************************************************************************
+static bool hs_write_entry(int index){
+	uint8_t entry[RLOG_DATA_SIZE] = {0};
+	
+	hs_pack(index, entry);
+	return rlog_append(index, entry) == I2C_OK;
+}
+
+//*****************************************************************************
+// Function Name: hs_flush_step
+//*****************************************************************************
+//	Summary: Queues the lowest numbered dirty entry.  A failure leaves the
+//					 entry dirty so it is retried on the next call.
+//
+//*****************************************************************************
+bool hs_flush_step(void){
+	int i;
+	
+	for(i = 0; i < NUM_HIGH_SCORES; i++){
+		if(hs_dirty & (1 << i)){
+			if(hs_write_entry(i)) hs_dirty &= ~(1 << i);
+			break;
+		}
+	}
+	return hs_dirty != 0;
+}
+
+//*****************************************************************************
+// Function Name: hs_flush
+//*****************************************************************************
+//	Summary: Queues every dirty entry and waits for the EEPROM queue to
+//					 drain.  Each entry gets a second try before giving up, so a
+//					 missing EEPROM cannot hang the caller.
+//
+//*****************************************************************************
+bool hs_flush(void){
+	int tries = 2 * NUM_HIGH_SCORES;
+	
+	while(hs_flush_step() && --tries > 0);
+	if(eeprom_queue_flush() != I2C_OK) return false;
+	return hs_dirty == 0;
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef __HIGH_SCORES_H__
+#define __HIGH_SCORES_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NUM_HIGH_SCORES							5
+
+// RAM shadow of the table in the EEPROM, highest score first.  Read these
+// directly, change them only through hs_submit() so the table stays sorted
+// and the EEPROM copy is kept in step.
+extern uint32_t high_scores[NUM_HIGH_SCORES];
+extern uint32_t hs_initials[NUM_HIGH_SCORES];
+
+//*****************************************************************************
+// Function Name: hs_init
+//*****************************************************************************
+//	Summary: Loads the high score table from the EEPROM into RAM.  Call once
+//					 at boot after the I2C bus is up.
+//
+//	Returns:
+//					 true - the table was loaded
+//					 false - the read failed and the table is empty
+//
+//*****************************************************************************
+bool hs_init(void);
+
+//*****************************************************************************
+// Function Name: hs_qualifies
+//*****************************************************************************
+//	Summary: Checks if score would make the leaderboard
+//
+//	Returns:
+//					 true - score beats the lowest high score
+//
+//*****************************************************************************
+bool hs_qualifies(uint32_t score);
+
+//*****************************************************************************
+// Function Name: hs_submit
+//*****************************************************************************
+//	Summary: Inserts score in order if it qualifies, dropping the lowest
+//					 entry.  Only RAM is changed; the entries that moved are
+//					 written back to the EEPROM later by hs_flush_step() or
+//					 hs_flush().
+//
+//	Params:
+//					 score - the player's score
+//					 initials - the player's three initials
+//
+//	Returns:
+//					 true - score entered in the table
+//					 false - score not high enough
+//
+//*****************************************************************************
+bool hs_submit(uint32_t score, char *initials);
+
+//*****************************************************************************
+// Function Name: hs_flush_step
+//*****************************************************************************
+//	Summary: Queues at most one changed entry for the EEPROM, which
+//					 eeprom_queue_step() writes out later.  Usually this does not
+//					 touch the bus, but an entry that fills the log's active bank
+//					 first compacts it, and the compaction reads every live record
+//					 back from the EEPROM with blocking reads.
+//
+//	Returns:
+//					 true - entries are still waiting to be written
+//
+//*****************************************************************************
+bool hs_flush_step(void);
+
+//*****************************************************************************
+// Function Name: hs_flush
+//*****************************************************************************
+//	Summary: Writes every changed entry back to the EEPROM before returning.
+//					 The console's flush command calls it.
+//
+//	Returns:
+//					 true - every entry was written
+//					 false - the EEPROM stopped responding, entries are still dirty
+//
+//*****************************************************************************
+bool hs_flush(void);
+
+#endif
@@ -0,0 +1,284 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "main.h"
+#include "i2c.h"
+#include "launchpad_io.h"
+#include "ft6x06.h"
+#include "input.h"
+#include "trace.h"
+
+input_buttons_t input_buttons;
+
+// Two bit vertical counter, one bit per button in each byte
+static uint8_t count0 = 0xFF;
+static uint8_t count1 = 0xFF;
+
+// Ticks each button has been held down for
+static uint8_t hold_ticks[8];
+
+// Last good port expander read.  Only refreshed when INTB signals a change.
+static volatile uint8_t pexp_raw = 0;
+static volatile bool pexp_ok = true;
+
+// Asynchronous reads, at most one of each in flight
+static i2c_xfer_t pexp_xfer;
+static uint8_t pexp_buf;
+static volatile bool pexp_busy = false;
+
+static i2c_xfer_t touch_xfer;
+static uint8_t touch_buf[FT6X06_TOUCH_BYTES];
+static volatile bool touch_busy = false;
+static volatile bool touch_ready = false;
+
+// Launchpad switch levels, only refreshed while the device sharing the
+// switch's pin is not holding its interrupt line low
+static bool sw1_down = false;
+static bool sw2_down = false;
+
+// Ticks the reads above have been outstanding
+static uint8_t stall_ticks = 0;
+
+// Set by GPIOF_Handler when a device pulls its interrupt line low.  The
+// expander starts dirty so the first sample picks up the power-on levels.
+static volatile bool pexp_irq = true;
+static volatile bool touch_irq = false;
+
+// Touch router state
+static const input_region_t *touch_regions = NULL;
+static uint8_t touch_num_regions = 0;
+static bool touch_down = false;
+static uint8_t touch_idle_ticks = 0;
+
+// Every report received, newest last
+static ft6x06_history_t touch_history;
+
+//*****************************************************************************
+// Function Name: input_init
+//*****************************************************************************
+//	Summary: Arms the falling edge interrupts for the port expander's INTB
+//					 and the touch controller's INT line.
+//
+//*****************************************************************************
+void input_init(void){
+	// Both lines share GPIOF with the launchpad switches, which already
+	// provide the pull-ups.  A switch press only costs one spare I2C read.
+	// See port_expander.h and ft6x06.h for the wiring.
+	gpio_config_falling_edge_irq(GPIOF_BASE, PEXP_IRQ_PIN_NUM | FT6X06_IRQ_PIN_NUM);
+	
+	NVIC_SetPriority(GPIOF_IRQn, 1);
+	NVIC_EnableIRQ(GPIOF_IRQn);
+}
+
+//*****************************************************************************
+// GPIOF Interrupt Service handler
+//*****************************************************************************
+void GPIOF_Handler(void)
+{
+	uint32_t mis = GPIOF->MIS;
+	
+	TRACE1(GPIOF_IRQ, mis);
+	
+	// SIGNAL MAIN() WHICH DEVICE HAS NEW DATA ==================================
+	if(mis & PEXP_IRQ_PIN_NUM) pexp_irq = true;
+	if(mis & FT6X06_IRQ_PIN_NUM) touch_irq = true;
+	
+	// CLEAR THE GPIOF INTERRUPT ================================================
+	GPIOF->ICR = mis;
+}
+
+//*****************************************************************************
+// I2C completion callbacks, run from the I2C ISR
+//*****************************************************************************
+static void pexp_read_done(i2c_xfer_t *xfer){
+	pexp_ok = (xfer->status == I2C_OK);
+	
+	// GPIOB is active low.  Retry on the next tick if the read failed.
+	if(pexp_ok) pexp_raw = ~pexp_buf & PEXP_BUTTON_M;
+	else{
+		pexp_irq = true;
+		TRACE1(PEXP_READ_FAIL, xfer->status);
+	}
+	pexp_busy = false;
+}
+
+static void touch_read_done(i2c_xfer_t *xfer){
+	touch_busy = false;
+	touch_ready = true;
+}
+
+//*****************************************************************************
+// Function Name: input_sample
+//*****************************************************************************
+//	Summary: Reads the port expander buttons and the launchpad switches once,
+//					 debounces all of them in parallel and refreshes input_buttons.
+//					 A button has to read the same for 4 samples in a row before
+//					 its debounced state flips.
+//
+//	Returns:
+//					 true - the last port expander read succeeded
+//					 false - the last I2C read failed, the last known levels are kept
+//
+//*****************************************************************************
+bool input_sample(void){
+	uint8_t raw, changed, held = 0;
+	int i;
+
+	// A read that never completes means a device is holding the bus.  The
+	// abort fails both reads, which are retried once the bus is recovered.
+	if(pexp_busy || touch_busy){
+		if(++stall_ticks >= INPUT_I2C_STALL_TICKS){
+			stall_ticks = 0;
+			TRACE(I2C_STALL);
+			i2cAsyncAbort(I2C1_BASE);
+		}
+	}
+	else{
+		stall_ticks = 0;
+	}
+
+	// One queued I2C read for all of the port expander buttons, and only when
+	// INTB has fired.  Clearing the flag first means a change that lands
+	// during the read raises it again.  The read also releases INTB.  The
+	// result lands in pexp_raw in time for the next sample.
+	if(pexp_irq && !pexp_busy){
+		pexp_irq = false;
+		pexp_busy = true;
+		if(pexp_read_buttons_async(I2C1_BASE, &pexp_xfer, &pexp_buf, pexp_read_done) != I2C_OK){
+			pexp_busy = false;
+			pexp_irq = true;
+		}
+	}
+
+	// Launchpad switches are active low.  SW2 shares PF0 with INTB and SW1
+	// shares PF4 with the touch INT, so each keeps its last level while its
+	// device may be pulling the pin low.  A stalled read cannot latch a press.
+	if(!pexp_irq && !pexp_busy) sw2_down = !lp_io_read_pin(SW2_BIT);
+	if(!touch_irq && !touch_busy) sw1_down = !lp_io_read_pin(SW1_BIT);
+	
+	raw = pexp_raw;
+	if(sw1_down) raw |= INPUT_BTN_SW1;
+	if(sw2_down) raw |= INPUT_BTN_SW2;
+
+	// Count every button that differs from its debounced state, reset the rest
+	changed = raw ^ input_buttons.state;
+	count0 = ~(count0 & changed);
+	count1 = count0 ^ (count1 & changed);
+
+	// Buttons whose counter rolled over have been stable for 4 samples
+	changed &= count0 & count1;
+	input_buttons.state ^= changed;
+
+	input_buttons.pressed = changed & input_buttons.state;
+	input_buttons.released = changed & ~input_buttons.state;
+
+	// Send a single hold edge once a button has been down long enough
+	for(i = 0; i < 8; i++){
+		if(!(input_buttons.state & (1 << i))){
+			hold_ticks[i] = 0;
+		} else if(hold_ticks[i] < INPUT_HOLD_TICKS){
+			hold_ticks[i]++;
+			if(hold_ticks[i] == INPUT_HOLD_TICKS) held |= (1 << i);
+		}
+	}
+	input_buttons.held = held;
+
+	return pexp_ok;
+}
+
+//*****************************************************************************
+// Function Name: input_touch_set_regions
+//*****************************************************************************
+//	Summary: Replaces the touch regions the router checks presses against
+//
+//*****************************************************************************
+void input_touch_set_regions(const input_region_t *regions, uint8_t num_regions){
+	touch_regions = regions;
+	touch_num_regions = num_regions;
+}
+
+//*****************************************************************************
+// Function Name: input_touch_route
+//*****************************************************************************
+//	Summary: Queues a read of the touch controller only if it has pulsed INT
+//					 since the last call, so an idle screen costs no I2C traffic.
+//					 The report is routed on the tick after it arrives.  A press only
+//					 fires on its first sample and only if that sample is inside a
+//					 region.  It is released by a lift-off report or by
+//					 INPUT_TOUCH_RELEASE_TICKS without any report.
+//
+//*****************************************************************************
+void input_touch_route(void){
+	ft6x06_touch_t report;
+	uint16_t x, y;
+	int i;
+	
+	// Queue a read for the new report, it is handled on a later tick
+	if(touch_irq && !touch_busy){
+		touch_irq = false;
+		touch_busy = true;
+		if(ft6x06_read_touch_async(&touch_xfer, touch_buf, touch_read_done) != I2C_OK){
+			touch_busy = false;
+			touch_irq = true;
+		}
+	}
+	
+	if(!touch_ready){
+		if(touch_down && ++touch_idle_ticks >= INPUT_TOUCH_RELEASE_TICKS) touch_down = false;
+		return;
+	}
+	touch_ready = false;
+	touch_idle_ticks = 0;
+	
+	if(touch_xfer.status != I2C_OK) return;
+	ft6x06_decode_touch(touch_buf, &report);
+	ft6x06_history_push(&touch_history, &report);
+	
+	if(report.touches == 0 || report.point[0].event == FT6X06_EVENT_LIFT_UP){
+		touch_down = false;
+		return;
+	}
+	x = report.point[0].x;
+	y = report.point[0].y;
+	
+	// Still the same press, it has already been routed
+	if(touch_down) return;
+	touch_down = true;
+	
+	for(i = 0; i < touch_num_regions; i++){
+		if((x >= touch_regions[i].x_min) && (x <= touch_regions[i].x_max) &&
+			 (y >= touch_regions[i].y_min) && (y <= touch_regions[i].y_max)){
+			touch_regions[i].hit();
+			return;
+		}
+	}
+}
+
+//*****************************************************************************
+// Function Name: input_touch_history
+//*****************************************************************************
+//	Summary: Returns the history of touch reports for smoothing and gestures
+//
+//*****************************************************************************
+const ft6x06_history_t *input_touch_history(void){
+	return &touch_history;
+}
@@ -0,0 +1,129 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "port_expander.h"
+#include "ft6x06.h"
+
+// DEFINE BUTTON BITS =========================================================
+// The lower nibble matches the port expander's GPIOB so that a read can be
+// used without remapping.  The launchpad switches are packed above it.
+#define INPUT_BTN_UP								PEXP_BUTTON_UP
+#define INPUT_BTN_DOWN							PEXP_BUTTON_DOWN
+#define INPUT_BTN_LEFT							PEXP_BUTTON_LEFT
+#define INPUT_BTN_RIGHT							PEXP_BUTTON_RIGHT
+#define INPUT_BTN_SW1								0x10
+#define INPUT_BTN_SW2								0x20
+
+// Number of sample ticks a button must stay down before a hold edge is sent
+#define INPUT_HOLD_TICKS						50
+
+// Ticks without a touch report before the screen counts as released.  The
+// FT6x06 reports well inside this while a finger is down.
+#define INPUT_TOUCH_RELEASE_TICKS		5
+
+// Ticks an I2C read may stay outstanding before the bus is treated as stuck.
+// A read normally completes within a millisecond.
+#define INPUT_I2C_STALL_TICKS				10
+
+// A touch rectangle in LCD coordinates (inclusive) and the handler to run when
+// a press lands inside it
+typedef struct {
+	uint16_t x_min;
+	uint16_t x_max;
+	uint16_t y_min;
+	uint16_t y_max;
+	void (*hit)(void);
+} input_region_t;
+
+// Debounced state of every button, updated once per input_sample()
+typedef struct {
+	uint8_t state;			// 1 = button is down
+	uint8_t pressed;		// buttons that went down on the last sample
+	uint8_t released;		// buttons that went up on the last sample
+	uint8_t held;				// buttons that reached INPUT_HOLD_TICKS on the last sample
+} input_buttons_t;
+
+extern input_buttons_t input_buttons;
+
+//*****************************************************************************
+// Function Name: input_init
+//*****************************************************************************
+//	Summary: Arms the falling edge interrupts for the port expander's INTB
+//					 and the touch controller's INT line.  Call after both devices
+//					 and the launchpad switches have been configured.
+//
+//*****************************************************************************
+void input_init(void);
+
+//*****************************************************************************
+// Function Name: input_sample
+//*****************************************************************************
+//	Summary: Reads the port expander buttons and the launchpad switches once,
+//					 debounces all of them in parallel and refreshes input_buttons.
+//					 Call once per tick; the edge fields only live for one tick.
+//
+//	Returns:
+//					 true - the last port expander read succeeded
+//					 false - the last I2C read failed, the last known levels are kept
+//
+//*****************************************************************************
+bool input_sample(void);
+
+//*****************************************************************************
+// Function Name: input_touch_set_regions
+//*****************************************************************************
+//	Summary: Replaces the touch regions the router checks presses against.
+//					 A press that is already down when the regions change does not
+//					 trigger the new regions until it is released.
+//
+//	Parameters:
+//					 regions - array of regions, checked in order, may be NULL
+//					 num_regions - number of entries in regions
+//
+//*****************************************************************************
+void input_touch_set_regions(const input_region_t *regions, uint8_t num_regions);
+
+//*****************************************************************************
+// Function Name: input_touch_route
+//*****************************************************************************
+//	Summary: Reads the touch controller if it has signalled a new report and
+//					 runs the handler of the region the press landed in.  Each press
+//					 triggers at most once, on its first sample.  Call once per tick.
+//
+//*****************************************************************************
+void input_touch_route(void);
+
+//*****************************************************************************
+// Function Name: input_touch_history
+//*****************************************************************************
+//	Summary: Returns the ring of the most recent touch reports, one entry per
+//					 report the controller sent, for smoothing and gesture detection
+//
+//*****************************************************************************
+const ft6x06_history_t *input_touch_history(void);
+
+#endif
@@ -0,0 +1,168 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "main.h"
+#include "timers.h"
+#include "i2c.h"
+#include "validate.h"
+#include "galaga_bitmaps.h"
+#include "latency.h"
+
+//*****************************************************************************
+// Function Name: latency_print_count
+//*****************************************************************************
+//	Summary: Prints a label followed by a count
+//
+//*****************************************************************************
+void latency_print_count(char *label, uint32_t count){
+	char value[9];
+	
+	itoa(count, value);
+	put_string(label);
+	put_string(value);
+	put_string("\n\r");
+}
+
+#ifdef LATENCY_TRACE
+
+// Ring of the most recent samples, in system clock ticks
+static uint32_t samples[LATENCY_NUM_SAMPLES];
+static uint32_t num_samples = 0;
+
+//*****************************************************************************
+// Function Name: latency_init
+//*****************************************************************************
+//	Summary: Starts Timer1 as a free running 32-bit up counter
+//
+//*****************************************************************************
+void latency_init(void){
+	TIMER0_Type *timer = (TIMER0_Type *)LATENCY_TIMER_BASE;
+	
+	gp_timer_config_32(LATENCY_TIMER_BASE, TIMER_TAMR_TAMR_PERIOD, true, false);
+	timer->TAILR = 0xFFFFFFFF;
+	timer->CTL |= TIMER_CTL_TAEN;
+	
+	// Time every I2C transaction against the same clock
+	i2cStatsSetClock(latency_now);
+}
+
+//*****************************************************************************
+// Function Name: latency_now
+//*****************************************************************************
+//	Summary: Returns the current trace timestamp in system clock ticks
+//
+//*****************************************************************************
+uint32_t latency_now(void){
+	return ((TIMER0_Type *)LATENCY_TIMER_BASE)->TAV;
+}
+
+//*****************************************************************************
+// Function Name: latency_record
+//*****************************************************************************
+//	Summary: Records one sample from stamp until now.  Unsigned subtraction
+//					 keeps the result correct across a timer wrap.
+//
+//*****************************************************************************
+void latency_record(uint32_t stamp){
+	samples[num_samples & (LATENCY_NUM_SAMPLES - 1)] = latency_now() - stamp;
+	num_samples++;
+}
+
+//*****************************************************************************
+// Function Name: print_us
+//*****************************************************************************
+//	Summary: Prints a label followed by a tick count converted to microseconds
+//
+//*****************************************************************************
+static void print_us(char *label, uint32_t ticks){
+	char value[9];
+	
+	itoa(ticks / LATENCY_TICKS_PER_US, value);
+	put_string(label);
+	put_string(value);
+	put_string("us\n\r");
+}
+
+//*****************************************************************************
+// Function Name: latency_report
+//*****************************************************************************
+//	Summary: Sorts a copy of the samples and prints the percentiles
+//
+//*****************************************************************************
+void latency_report(void){
+	uint32_t sorted[LATENCY_NUM_SAMPLES];
+	uint32_t i, n, tmp;
+	char count[9];
+	int j;
+	
+	n = num_samples < LATENCY_NUM_SAMPLES ? num_samples : LATENCY_NUM_SAMPLES;
+	if(n == 0){
+		put_string("LATENCY: no samples\n\r");
+		return;
+	}
+	
+	// Insertion sort, the ring is small
+	for(i = 0; i < n; i++){
+		tmp = samples[i];
+		for(j = i; j > 0 && sorted[j-1] > tmp; j--) sorted[j] = sorted[j-1];
+		sorted[j] = tmp;
+	}
+	
+	itoa(n, count);
+	put_string("LATENCY input to photon, samples ");
+	put_string(count);
+	put_string("\n\r");
+	print_us("  p50 ", sorted[(n * 50) / 100]);
+	print_us("  p90 ", sorted[(n * 90) / 100]);
+	print_us("  p99 ", sorted[(n * 99) / 100]);
+	print_us("  max ", sorted[n - 1]);
+}
+
+//*****************************************************************************
+// Function Name: latency_i2c_report
+//*****************************************************************************
+//	Summary: Prints the counters, the average transaction time and the
+//					 longest one
+//
+//*****************************************************************************
+void latency_i2c_report(uint32_t i2c_base){
+	const i2c_stats_t *stats = i2cGetStats(i2c_base);
+	uint32_t count;
+	
+	if(stats == NULL) return;
+	count = stats->transfers + stats->async_xfers;
+	
+	put_string("I2C\n\r");
+	latency_print_count("  blocking   ", stats->transfers);
+	latency_print_count("  queued     ", stats->async_xfers);
+	latency_print_count("  bytes wr   ", stats->bytes_written);
+	latency_print_count("  bytes rd   ", stats->bytes_read);
+	latency_print_count("  nacks      ", stats->nacks);
+	latency_print_count("  timeouts   ", stats->timeouts);
+	latency_print_count("  wait polls ", stats->wait_polls);
+	if(count > 0) print_us("  avg        ", stats->ticks / count);
+	print_us("  max        ", stats->max_ticks);
+	
+	i2cStatsReset(i2c_base);
+}
+
+#endif
@@ -0,0 +1,103 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DEFINE LATENCY TRACE VARS ==================================================
+// Timer1 free-runs at the 50MHz system clock as the trace timebase
+#define LATENCY_TIMER_BASE					TIMER1_BASE
+#define LATENCY_TICKS_PER_US				50
+
+// Number of samples kept for the percentile report.  Must be a power of 2.
+#define LATENCY_NUM_SAMPLES					128
+
+//*****************************************************************************
+// Function Name: latency_print_count
+//*****************************************************************************
+//	Summary: Prints a label followed by a count to the serial debug port.
+//					 Built with or without LATENCY_TRACE, for the reports of
+//					 other modules too.
+//
+//*****************************************************************************
+void latency_print_count(char *label, uint32_t count);
+
+#ifdef LATENCY_TRACE
+
+//*****************************************************************************
+// Function Name: latency_init
+//*****************************************************************************
+//	Summary: Starts Timer1 as a free running 32-bit up counter
+//
+//*****************************************************************************
+void latency_init(void);
+
+//*****************************************************************************
+// Function Name: latency_now
+//*****************************************************************************
+//	Summary: Returns the current trace timestamp in system clock ticks.
+//					 Safe to call from an ISR.
+//
+//*****************************************************************************
+uint32_t latency_now(void);
+
+//*****************************************************************************
+// Function Name: latency_record
+//*****************************************************************************
+//	Summary: Records one input-to-photon sample that started at stamp and
+//					 ends now, once the LCD write for that input has completed
+//
+//*****************************************************************************
+void latency_record(uint32_t stamp);
+
+//*****************************************************************************
+// Function Name: latency_report
+//*****************************************************************************
+//	Summary: Prints p50/p90/p99/max of the recorded samples in microseconds
+//					 to the serial debug port
+//
+//*****************************************************************************
+void latency_report(void);
+
+//*****************************************************************************
+// Function Name: latency_i2c_report
+//*****************************************************************************
+//	Summary: Prints the transaction counters of an I2C peripheral to the
+//					 serial debug port and clears them, so each report covers the
+//					 time since the last one
+//
+//*****************************************************************************
+void latency_i2c_report(uint32_t i2c_base);
+
+#else
+
+#define latency_init()
+#define latency_now()								0
+#define latency_record(stamp)
+#define latency_report()
+#define latency_i2c_report(i2c_base)
+
+#endif
+
+#endif
@@ -0,0 +1,226 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "lcd.h"
+#include "telemetry.h"
+#include "lcd_mirror.h"
+
+// Window being drawn and the pixels written to it so far
+static uint16_t win_x0, win_x1, win_y0, win_y1;
+static uint32_t win_pixels = 0;
+static bool win_open = false;
+
+// Record being built, it starts at chunk_offset pixels into the window
+static uint8_t chunk[TLM_MAX_PAYLOAD];
+static uint8_t chunk_len = TLM_RECT_HEADER_SIZE;
+static uint32_t chunk_offset = 0;
+static uint32_t chunk_pixels = 0;
+
+// Run not yet added to the record
+static uint16_t run_color;
+static uint16_t run_len = 0;
+
+// Area covered by dropped records
+static bool stale = false;
+static uint16_t stale_x0, stale_x1, stale_y0, stale_y1;
+static uint16_t stale_drops = 0;
+
+//*****************************************************************************
+// Function Name: put16
+//*****************************************************************************
+//	Summary: Stores v least significant byte first, returns the next byte
+//
+//*****************************************************************************
+static uint8_t *put16(uint8_t *p, uint16_t v){
+	*p++ = v & 0xFF;
+	*p++ = v >> 8;
+	return p;
+}
+
+//*****************************************************************************
+// Function Name: mark_stale
+//*****************************************************************************
+//	Summary: Grows the stale area to cover the current window
+//
+//*****************************************************************************
+static void mark_stale(void){
+	if(!stale){
+		stale = true;
+		stale_x0 = win_x0;
+		stale_x1 = win_x1;
+		stale_y0 = win_y0;
+		stale_y1 = win_y1;
+	}
+	else{
+		if(win_x0 < stale_x0) stale_x0 = win_x0;
+		if(win_x1 > stale_x1) stale_x1 = win_x1;
+		if(win_y0 < stale_y0) stale_y0 = win_y0;
+		if(win_y1 > stale_y1) stale_y1 = win_y1;
+	}
+	if(stale_drops < 0xFFFF) stale_drops++;
+}
+
+//*****************************************************************************
+// Function Name: send_chunk
+//*****************************************************************************
+//	Summary: Sends the runs collected so far as one TLM_RECT record
+//
+//*****************************************************************************
+static void send_chunk(void){
+	uint8_t *p;
+	
+	if(chunk_len == TLM_RECT_HEADER_SIZE) return;
+	
+	p = put16(chunk, win_x0);
+	p = put16(p, win_x1);
+	p = put16(p, win_y0);
+	p = put16(p, win_y1);
+	put16(p, chunk_offset);
+	if(!telemetry_offer(TLM_RECT, chunk, chunk_len, MIRROR_RESERVE)) mark_stale();
+	
+	chunk_offset += chunk_pixels;
+	chunk_pixels = 0;
+	chunk_len = TLM_RECT_HEADER_SIZE;
+}
+
+//*****************************************************************************
+// Function Name: end_run
+//*****************************************************************************
+//	Summary: Adds the open run to the record, sending the record first if the
+//					 run does not fit
+//
+//*****************************************************************************
+static void end_run(void){
+	if(run_len == 0) return;
+	
+	if(chunk_len + 4 > TLM_MAX_PAYLOAD) send_chunk();
+	if(run_len < 0x80){
+		chunk[chunk_len++] = run_len;
+	}
+	else{
+		chunk[chunk_len++] = 0x80 | (run_len >> 8);
+		chunk[chunk_len++] = run_len & 0xFF;
+	}
+	chunk[chunk_len++] = run_color & 0xFF;
+	chunk[chunk_len++] = run_color >> 8;
+	chunk_pixels += run_len;
+	run_len = 0;
+}
+
+//*****************************************************************************
+// Function Name: mirror_pixel
+//*****************************************************************************
+//	Summary: Counts one pixel into the open run
+//
+//*****************************************************************************
+static void mirror_pixel(uint16_t color){
+	if(run_len && color == run_color && run_len < MIRROR_MAX_RUN){
+		run_len++;
+	}
+	else{
+		end_run();
+		run_color = color;
+		run_len = 1;
+	}
+	win_pixels++;
+}
+
+//*****************************************************************************
+// Function Name: mirror_window
+//*****************************************************************************
+//	Summary: Starts a new window, or extends the current one if both are one
+//					 row high, the new one starts right after it and the current
+//					 one has been filled
+//
+//*****************************************************************************
+static void mirror_window(uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1){
+	if(win_open && y0 == y1 && win_y0 == y0 && win_y1 == y1 && x0 == win_x1 + 1 &&
+		 win_pixels == (uint32_t)(win_x1 - win_x0 + 1)){
+		win_x1 = x1;
+		return;
+	}
+	
+	lcd_mirror_flush();
+	win_x0 = x0;
+	win_x1 = x1;
+	win_y0 = y0;
+	win_y1 = y1;
+	win_pixels = 0;
+	win_open = true;
+	chunk_offset = 0;
+}
+
+static const lcd_mirror_t lcd_mirror = { mirror_window, mirror_pixel };
+
+//*****************************************************************************
+// Function Name: lcd_mirror_enable
+//*****************************************************************************
+//	Summary: Starts or stops copying what is drawn on the LCD to UART0
+//
+//*****************************************************************************
+void lcd_mirror_enable(bool enable){
+	if(!enable) lcd_mirror_flush();
+	win_open = false;
+	lcd_set_mirror(enable ? &lcd_mirror : NULL);
+	
+	// The LCD cannot be read back, so what is on it now was never sent.
+	// The whole screen is reported stale with no dropped records until it
+	// has been drawn again.
+	if(enable){
+		stale = true;
+		stale_x0 = 0;
+		stale_x1 = ROWS - 1;
+		stale_y0 = 0;
+		stale_y1 = COLS - 1;
+		stale_drops = 0;
+		lcd_mirror_flush();
+	}
+}
+
+//*****************************************************************************
+// Function Name: lcd_mirror_flush
+//*****************************************************************************
+//	Summary: Sends the pixels of the window being drawn, and the stale area if
+//					 records were dropped.  A window that is still being drawn
+//					 carries on in the next record.
+//
+//*****************************************************************************
+void lcd_mirror_flush(void){
+	uint8_t payload[TLM_STALE_SIZE];
+	uint8_t *p;
+	
+	if(win_open){
+		end_run();
+		send_chunk();
+	}
+	
+	if(stale){
+		p = put16(payload, stale_x0);
+		p = put16(p, stale_x1);
+		p = put16(p, stale_y0);
+		p = put16(p, stale_y1);
+		put16(p, stale_drops);
+		if(telemetry_offer(TLM_STALE, payload, TLM_STALE_SIZE, MIRROR_RESERVE)){
+			stale = false;
+			stale_drops = 0;
+		}
+	}
+}
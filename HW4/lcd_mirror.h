@@ -0,0 +1,63 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef __LCD_MIRROR_H__
+#define __LCD_MIRROR_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DEFINE LCD MIRROR VARS =====================================================
+// Each window drawn on the LCD is sent as TLM_RECT telemetry records.  The
+// payload is the window, the index of the record's first pixel in the
+// window, then runs of one color:
+//   count (1 byte if < 0x80, else 2 bytes big endian with 0x8000 set), color u16
+// A window of one pixel row that continues the last one is merged into it,
+// so lines drawn a pixel at a time cost one record.
+#define MIRROR_RUN_BYTES						(TLM_MAX_PAYLOAD - TLM_RECT_HEADER_SIZE)
+#define MIRROR_MAX_RUN							0x7FFF
+
+// Bytes left free in the TX ring for telemetry and the console.  A record
+// that does not fit is dropped and its window is reported in a TLM_STALE
+// record, merged with any others, once there is room.
+#define MIRROR_RESERVE							128
+
+//*****************************************************************************
+// Function Name: lcd_mirror_enable
+//*****************************************************************************
+//	Summary: Starts or stops copying what is drawn on the LCD to UART0.
+//					 Starting sends a TLM_STALE record for the whole screen with
+//					 zero dropped records, since what is already on the LCD is not
+//					 known to the host.
+//
+//*****************************************************************************
+void lcd_mirror_enable(bool enable);
+
+//*****************************************************************************
+// Function Name: lcd_mirror_flush
+//*****************************************************************************
+//	Summary: Sends the pixels of the window being drawn, and the stale area if
+//					 records were dropped.  Call once drawing for a tick is done.
+//
+//*****************************************************************************
+void lcd_mirror_flush(void);
+
+#endif
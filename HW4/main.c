@@ -21,6 +21,7 @@
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "main.h"
+#include "serial_debug.h"
 #include "timers.h"
 #include "ps2.h"
 #include "launchpad_io.h"
@@ -30,7 +31,16 @@
 #include "eeprom.h"
 #include "galaga.h"
 #include "ft6x06.h"
-#include "port_expander.h"
+#include "input.h"
+#include "latency.h"
+#include "record_log.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "console.h"
+#include "lcd_mirror.h"
+#include "fault.h"
+#include "name_entry.h"
+#include "main_game.h"
 
 // Game states used in main program loop
 typedef enum {
@@ -39,27 +49,59 @@ typedef enum {
 	MAIN_GAME,
 	GAME_OVER,
 	NEW_RECORD,
-	PAUSE
+	PAUSE,
+	NUM_STATES
 } gameState_t;
 
+// Everything main() needs to run one game state.  Any handler may be NULL.
+typedef struct {
+	void (*enter)(gameState_t from);
+	void (*exit)(gameState_t to);
+	void (*tick_a)(void);												// every Timer A interrupt
+	void (*tick_b)(void);												// every Timer B interrupt
+	void (*joystick)(uint32_t x, uint32_t y);		// every ADC0SS2 sample
+	const input_region_t *regions;					// touch regions routed by input.c
+	uint8_t num_regions;
+} state_desc_t;
+
+// Screen regions a transition leaves stale.  Transitions that are not in
+// the transition table repaint the whole screen.
+typedef struct {
+	gameState_t from;
+	gameState_t to;
+	uint32_t invalidate;
+} transition_t;
+
+// DEFINE SCREEN REGIONS ======================================================
+// Regions are the 20 text rows used by lcd_print_stringXY, one bit per row.
+// The per-screen masks must match the rows printed by galaga.c.
+#define TEXT_ROW(n)					(1UL << (n))
+#define TEXT_ROWS_NONE			0
+#define TEXT_ROWS_ALL				0xFFFFF
+
+#define MAIN_MENU_ROWS			(TEXT_ROW(5) | TEXT_ROW(11) | TEXT_ROW(14))
+#define HIGH_SCORE_ROWS			(TEXT_ROW(5) | TEXT_ROW(7) | TEXT_ROW(8) | TEXT_ROW(9) | \
+														 TEXT_ROW(10) | TEXT_ROW(11) | TEXT_ROW(13) | TEXT_ROW(18))
+#define GAME_OVER_ROWS			(TEXT_ROW(5) | TEXT_ROW(11) | TEXT_ROW(16))
+#define NEW_RECORD_ROWS			(TEXT_ROW(3) | TEXT_ROW(5) | TEXT_ROW(6) | TEXT_ROW(7) | \
+														 TEXT_ROW(8) | TEXT_ROW(11) | TEXT_ROW(15))
+#define PAUSE_ROWS					(TEXT_ROW(5) | TEXT_ROW(11) | TEXT_ROW(14))
+
 // Var to keep track of game state
 gameState_t state;
 
-// True if entering a new state
-bool new_state = true;
+// State requested by a handler, applied at the top of the main loop
+static gameState_t next_state;
+static bool state_pending = false;
 
 char group[] = "Group27";
 char individual_1[] = "Justin Essert";
 char individual_2[] = "James Mai";
 
 // Global Vars ================================================================
-static ADC0_Type* myADC = ((ADC0_Type *)PS2_ADC_BASE);
-					
-
 // Booleans to allow the handlers to communicate with main()
 volatile bool interrupt_timerA = false;
 volatile bool interrupt_timerB = false;
-volatile bool interrupt_adc0ss2 = false;
 
 
 
@@ -79,7 +121,9 @@ uint8_t placeholder_image[20] = {
 void initialize_hardware(void)
 {
   // INITIALIZE SERIAL DEBUG ==================================================
-	initialize_serial_debug();
+	// Output is sent from the TX interrupt so debug prints do not stall, and
+	// console input is buffered by the RX interrupt
+	init_serial_debug(true, true);
 
 	
 	// INITIALIZE PS2 ===========================================================
@@ -121,121 +165,15 @@ void initialize_hardware(void)
 	
 	port_expander_init();
 	
-}
-
-//*****************************************************************************
-//*****************************************************************************
-// INTERRUPT FLOW FUNCTIONS
-//*****************************************************************************
-//*****************************************************************************
-
-
-//*****************************************************************************
-// Function Name: sw1_debounce
-//*****************************************************************************
-//	Summary: This function tests if SW1 has been pressed for 6 cycles
-//
-//	Returns:
-//
-//	true				SW1 lifted after pressed for 6 cycles
-//	false				All other states
-//
-//*****************************************************************************
-__INLINE static bool sw1_debounce()
-{
-  // Counter to determine the length of time that SW1 has been pressed
-	static volatile long long cycle = 0;
-  
-	// If SW1 is pressed, increment cycle, return false
-  if(!lp_io_read_pin(SW1_BIT)){
-		cycle++;
-		return false;
-	}
-	// If the button is lifted and has been pressed for > 8 cycles, return true
-  else if(cycle > 6){
-		cycle = 0;
-		return true;
-	}
-	// If SW1 is not pressed, set cycle to 0
-	else {
-		cycle = 0;
-		return false;
-	}
-	
+	// Buttons and touch are read when their interrupt lines fire
+	input_init();
 	
-}
-//*****************************************************************************
-// Function Name: pbRight_debounce
-//*****************************************************************************
-//	Summary: This function tests if PB right has been pressed for 6 cycles
-//
-//	Returns:
-//
-//	true				Pushbutton (R) has been released after being pressed for 6 cycles
-//	false				all other states
-//
-//*****************************************************************************
-__INLINE static bool pbRight_debounce()
-{
-  // Counter to determine the length of time that PBR has been pressed
-	static int cycle = 0;
-	uint8_t data;
+	// Load the high score table, all later reads come from RAM
+	hs_init();
 	
-	// read data
-  pexp_read_buttons(I2C1_BASE, &data);
+	// Timebase for LATENCY_TRACE, compiled out otherwise
+	latency_init();
 	
-	// If right PB is pressed, increment cycle and return false
-  if(data & PEXP_BUTTON_RIGHT){
-		cycle = (cycle+1);
-		return false;
-	}
-	// If right PB is not pressed, but cycle is greater than 6, return true
-	else if ( cycle > 6 ){
-		cycle = 0;
-		return true;
-	}
-	// reset cycleelse return false
-	else {
-		cycle = 0;
-		return false;
-	}
-}
-//*****************************************************************************
-// Function Name: pbDown_debounce
-//*****************************************************************************
-//	Summary: This function tests if PB down has been pressed for 6 cycles
-//
-//	Returns:
-//
-//	true				Pushbutton (D) has been released after being pressed for 6 cycles
-//	false				all other states
-//
-//*****************************************************************************
-
-__INLINE static bool pbDown_debounce()
-{
-  // Counter to determine the length of time that PBD has been pressed
-	static int cycle = 0;
-	uint8_t data;
-	
-	// read data
-  pexp_read_buttons(I2C1_BASE, &data);
-	
-	// If down PB is pressed, increment cycle and return false
-  if(data & PEXP_BUTTON_DOWN){
-		cycle = (cycle+1);
-		return false;
-	}
-	// If down PB is not pressed, but cycle is greater than 6, return true
-	else if ( cycle > 6 ){
-		cycle = 0;
-		return true;
-	}
-	// else reset cycle and return false
-	else {
-		cycle = 0;
-		return false;
-	}
 }
 
 //*****************************************************************************
@@ -252,6 +190,7 @@ void TIMER0A_Handler(void)
 {
 	// SIGNAL MAIN() THAT THE INTERRUPT OCCURRED ================================
 	interrupt_timerA = true;
+	trace_tick();
 	
 	// CLEAR THE TIMER A INTERRUPT ==============================================
 	TIMER0->ICR |= TIMER_ICR_TATOCINT;
@@ -272,19 +211,223 @@ void TIMER0B_Handler(void)
 
 
 //*****************************************************************************
-// ADC0 Sample Sequencer 2 Interrupt Service handler
 //*****************************************************************************
-void ADC0SS2_Handler(void)
-{
-	// SIGNAL MAIN() THAT THE INTERRUPT OCCURRED ================================
-	interrupt_adc0ss2 = true;
+// GAME STATE HANDLERS
+//*****************************************************************************
+//*****************************************************************************
+
+// Timer interrupt counters, shared by the tick handlers
+int32_t timer_a_cycles = TIMER_A_CYCLES;
+static int counterA = 0;		// Counter for TimerA's Interrupt Handler
+static int counterB = 0;		// Counter for TimerB's Interrupt Handler
+
+static void set_state(gameState_t next);
+
+// Touch handlers =============================================================
+static void go_main_menu(void)	{ set_state(MAIN_MENU); }
+static void go_high_score(void)	{ set_state(HIGH_SCORE); }
+static void go_main_game(void)	{ set_state(MAIN_GAME); }
+
+static void game_over_touch(void){
+	// Go to name entry if the score beat anything on the leaderboard
+	if(hs_qualifies(player_score)) set_state(NEW_RECORD);
+	else set_state(HIGH_SCORE);
+}
+
+// Enter and exit handlers ====================================================
+static void main_menu_enter(gameState_t from)		{ print_main_menu(); }
+static void high_score_enter(gameState_t from)	{ print_high_scores(); }
+static void game_over_enter(gameState_t from)		{ print_game_over(); }
+
+static void main_game_enter(gameState_t from){
+	// Resuming keeps the game that is already on the screen
+	if(from != PAUSE) game_init();
+}
+
+static void pause_enter(gameState_t from){
+	// The pause menu is drawn over the game field
+	print_pause();
+	trace_dump(false);
+	latency_report();
+	latency_i2c_report(I2C1_BASE);
+	rlog_report();
+}
+
+static void new_record_enter(gameState_t from){
+	print_new_record();
+	name_entry_start();
+}
+
+static void new_record_exit(gameState_t to){
+	// Enter the name once it has been submitted, it is saved in the background
+	hs_submit(player_score, name_entry_text());
+	name_entry_stop();
+}
+
+// Tick handlers ==============================================================
+static void main_game_tick_a(void){
+	if(input_buttons.pressed & INPUT_BTN_SW1){
+		set_state(PAUSE);
+		return;
+	}
+	// The game itself is in main_game.c, which the host harness runs too
+	if(!main_game_tick(counterA)) set_state(GAME_OVER);
+}
+
+static void pause_tick_a(void){
+	// if SW1 is pressed whiled paused, resume MAIN_GAME
+	if(input_buttons.pressed & INPUT_BTN_SW1) set_state(MAIN_GAME);
+}
+
+static void new_record_tick_a(void){
+	// Right keeps the letter, down deletes it.  The name can also be typed
+	// on the console.
+	if(input_buttons.pressed & INPUT_BTN_RIGHT) name_entry_key(NAME_KEY_NEXT);
+	else if(input_buttons.pressed & INPUT_BTN_DOWN) name_entry_key(NAME_KEY_BACK);
 	
-	// CLEAR THE ADC0SS2 INTERRUPT ==============================================
-	myADC->ISC |= ADC_ISC_IN2;
-  return;	
+	// Submitting the last letter saves the score and shows the table
+	if(name_entry_done()){
+		set_state(HIGH_SCORE);
+		return;
+	}
 	
+	// Only letters that changed since the last tick are redrawn
+	name_entry_draw();
 }
 
+static void main_game_tick_b(void){
+	if(counterB==0) update_LCD();
+}
+
+static void new_record_tick_b(void){
+	joystick_start();
+}
+
+// Joystick handlers ==========================================================
+static void new_record_joystick(uint32_t x_value, uint32_t y_value){
+	// Stick up past 75% selects the next letter, down past 25% the one before
+	if(y_value >= 0xBFD) name_entry_key(NAME_KEY_UP);
+	else if(y_value <= 0x3FF) name_entry_key(NAME_KEY_DOWN);
+}
+
+//*****************************************************************************
+//*****************************************************************************
+// GAME STATE TABLES
+//*****************************************************************************
+//*****************************************************************************
+
+// Each region covers its text plus one character on either side
+static const input_region_t main_menu_regions[] = {
+	//x_min	x_max	y_min	y_max
+	{  17,	220,	121,	169,	go_main_game },			// START GAME
+	{  17,	220,	 71,	119,	go_high_score },		// HIGH SCORE
+};
+
+static const input_region_t high_score_regions[] = {
+	{  34,	220,	 11,	 59,	go_main_menu },			// MAIN MENU
+};
+
+static const input_region_t game_over_regions[] = {
+	{  17,	237,	 11,	119,	game_over_touch },	// TAP TO CONT
+};
+
+static const input_region_t pause_regions[] = {
+	{  34,	220,	121,	169,	go_main_menu },			// MAIN MENU
+	{  85,	203,	 71,	119,	go_main_game },			// RESUME
+};
+
+#define REGIONS(r)		r, (sizeof(r)/sizeof(r[0]))
+
+// Indexed by gameState_t
+static const state_desc_t states[NUM_STATES] = {
+	//  enter							exit							tick_a							tick_b							joystick
+	{ main_menu_enter,		NULL,							NULL,								NULL,								NULL,									REGIONS(main_menu_regions) },
+	{ high_score_enter,		NULL,							NULL,								NULL,								NULL,									REGIONS(high_score_regions) },
+	{ main_game_enter,		NULL,							main_game_tick_a,		main_game_tick_b,		main_game_joystick,		NULL, 0 },
+	{ game_over_enter,		NULL,							NULL,								NULL,								NULL,									REGIONS(game_over_regions) },
+	{ new_record_enter,		new_record_exit,	new_record_tick_a,	new_record_tick_b,	new_record_joystick,	NULL, 0 },
+	{ pause_enter,				NULL,							pause_tick_a,				NULL,								NULL,									REGIONS(pause_regions) },
+};
+
+// Text rows left behind by the outgoing screen.  Pausing draws over the game
+// and resuming only wipes the pause text; the game redraws on its next frame.
+static const transition_t transitions[] = {
+	{ MAIN_MENU,	MAIN_GAME,	MAIN_MENU_ROWS },
+	{ MAIN_MENU,	HIGH_SCORE,	MAIN_MENU_ROWS },
+	{ HIGH_SCORE,	MAIN_MENU,	HIGH_SCORE_ROWS },
+	{ MAIN_GAME,	PAUSE,			TEXT_ROWS_NONE },
+	{ PAUSE,			MAIN_GAME,	PAUSE_ROWS },
+	{ GAME_OVER,	HIGH_SCORE,	GAME_OVER_ROWS },
+	{ GAME_OVER,	NEW_RECORD,	GAME_OVER_ROWS },
+	{ NEW_RECORD,	HIGH_SCORE,	NEW_RECORD_ROWS },
+};
+
+//*****************************************************************************
+// Function Name: set_state
+//*****************************************************************************
+//	Summary: Requests a change to the next state.  The change is made at the
+//					 top of the main loop so the current handler can finish.
+//
+//*****************************************************************************
+static void set_state(gameState_t next){
+	next_state = next;
+	state_pending = true;
+}
+
+//*****************************************************************************
+// Function Name: repaint_rows
+//*****************************************************************************
+//	Summary: Clears the given text rows to black.  Runs of adjacent rows are
+//					 cleared with a single fill.
+//
+//*****************************************************************************
+static void repaint_rows(uint32_t rows){
+	int first, last;
+	
+	if(rows == TEXT_ROWS_ALL){
+		lcd_clear_screen(LCD_COLOR_BLACK);
+		return;
+	}
+	
+	for(first = 0; first < 20; first++){
+		if(!(rows & TEXT_ROW(first))) continue;
+		
+		for(last = first; last < 19 && (rows & TEXT_ROW(last+1)); last++);
+		
+		// Text row Y is drawn from (19-Y)*FONT_HEIGHT upwards
+		lcd_fill_rect(0, ROWS-1, (19-last)*FONT_HEIGHT, (20-first)*FONT_HEIGHT - 1, LCD_COLOR_BLACK);
+		first = last;
+	}
+}
+
+//*****************************************************************************
+// Function Name: change_state
+//*****************************************************************************
+//	Summary: Runs the exit handler of the current state, repaints what the
+//					 transition invalidated and runs the enter handler of next.
+//
+//*****************************************************************************
+static void change_state(gameState_t next){
+	gameState_t from = state;
+	uint32_t rows = TEXT_ROWS_ALL;
+	int i;
+	
+	TRACE2(STATE, from, next);
+	if(states[from].exit) states[from].exit(next);
+	
+	for(i = 0; i < sizeof(transitions)/sizeof(transitions[0]); i++){
+		if(transitions[i].from == from && transitions[i].to == next){
+			rows = transitions[i].invalidate;
+			break;
+		}
+	}
+	if(rows != TEXT_ROWS_NONE) repaint_rows(rows);
+	
+	state = next;
+	fault_state = next;
+	input_touch_set_regions(states[next].regions, states[next].num_regions);
+	if(states[next].enter) states[next].enter(from);
+}
 
 //*****************************************************************************
 //*****************************************************************************
@@ -293,29 +436,15 @@ void ADC0SS2_Handler(void)
 //*****************************************************************************
 int main(void)
 {
-  int counterA = 0;		// Counter for TimerA's Interrupt Handler
-	int counterB = 0;		// Counter for TimerB's Interrupt Handler
 	uint32_t x_value;
 	uint32_t y_value;
-	uint8_t data;
-	i2c_status_t td_status;
-	uint16_t x = 0;
-	uint16_t y = 0;
-	gameState_t state;
 	uint16_t addr;
-	int i,j;
-	bool toggle;	
-	int cursor_pos = 0;  // cursor position
-	int selected_char = 0; // A is 0, B is 1...
-	uint8_t pbData = 0;
-	char initial[4];
-	bool foo = false;
-	
-	extern uint16_t level;
-
+	int i;
+	tlm_entities_t entities;
 	
 	// INITIALIZE FUNCTIONS =====================================================
 	initialize_hardware();
+	TRACE(BOOT);
 	
 	// DISPLAY ON CONSOLE =======================================================
 	put_string("\n\r");
@@ -329,6 +458,9 @@ int main(void)
   put_string("\n\r");  
   put_string("************************************\n\r");
 	
+	// Print what was saved if the last run ended in a fault
+	fault_report();
+	
 
 	/* USE TO WIPE EEPROM
 	addr = ADDR_START;
@@ -338,127 +470,53 @@ int main(void)
 	}
 	*/
 
-	// Set state to Main Menu and start the while loop
-	state=MAIN_MENU;
-	new_state = true;
+	// Start in the main menu, the screen was cleared by initialize_hardware
+	state = MAIN_MENU;
+	fault_state = state;
+	input_touch_set_regions(states[state].regions, states[state].num_regions);
+	states[state].enter(state);
+	
   while(1)
 	{
-		if(new_state){
-			new_state=false;
-			
-			lcd_clear_screen(LCD_COLOR_BLACK);
-			
-			// If state is main menu, print the menu
-			if(state==MAIN_MENU) print_main_menu();
-			// If state is high score, print the high score screen
-			else if(state==HIGH_SCORE) print_high_scores();
-			// If state is main game the initialize the game
-			else if(state==MAIN_GAME) game_init();
-			// If state is game over the initialize the game over menu
-			else if(state==GAME_OVER) print_game_over();
-			// If state is new record, print the new record screen
-			else if(state==NEW_RECORD) print_new_record();
-			// If state is new pause, print the pause screen
-			else if(state==PAUSE) print_pause();
+		// Commands typed on the serial port, never waits
+		console_poll();
+		
+		if(state_pending){
+			state_pending = false;
+			change_state(next_state);
 		}
+		
+		//*************************************************************************
+		// TIMER A INTERRUPT HANDLING
+		//*************************************************************************
 		if(interrupt_timerA){
 			interrupt_timerA = false;
-			counterA = ((counterA+1)%TIMER_A_CYCLES);
+			counterA = ((counterA+1)%timer_a_cycles);
 			
-			// Check for Touchscreen press
-			td_status = ft6x06_read_td_status();
-			// If Touchscreen event occured, read the Y value
-			if( td_status >0 ){
-				y = ft6x06_read_y();
-
-				if(state==MAIN_MENU){
-					// If the Y is the START GAME button then start the game
-					if ((y >120)&& (y < 170)){
-						state = MAIN_GAME;
-						new_state = true;
-					}
-					// If the Y is the HIGH SCORE button then got to high scores
-					else if ((y > 70) && ( y < 120 )){
-						state = HIGH_SCORE;
-						new_state = true;
-					}
-				} 
-				// If the Y is the MAIN_MENU button then got to the main menu
-				else if (state==HIGH_SCORE){
-					if ( (y < 60) && (y > 10) ){
-						state = MAIN_MENU;
-						new_state = true;
-					}		
-				}
-				// If the Y is the high score button then got to high scores
-				else if(state == GAME_OVER){
-          if ( (y < 120) && (y > 10) ){
-				    state = HIGH_SCORE;
-            new_state = true;
-				    for(i = 0; i < NUM_HIGH_SCORES; i++){
-					    if(player_score > high_scores[i]){
-                print_new_record();
-                cursor_pos = 0;
-                selected_char = 0;
-								*((uint32_t*)initial) = 0;
-                state = NEW_RECORD;
-              }
-				    }		
-			    }
-				}	else if(state == PAUSE){
-					// If the Y is the MAIN MENU button then go to MAIN MENU
-					if ((y >120)&& (y < 170)){
-						state = MAIN_MENU;
-						new_state = true;
-					}
-					// If the Y is the RESUME button then return to MAIN GAME
-					else if ((y > 70) && ( y < 120 )){
-						lcd_clear_screen(LCD_COLOR_BLACK);
-						state = MAIN_GAME;
-					}
-				}
+			// Sample and debounce every button once for this tick
+			input_sample();
 			
- 
-			}
-			// if SW1 is pressed whiled paused, resume MAIN_GAME
-			if (state==PAUSE  && sw1_debounce()  ){
-					lcd_clear_screen(LCD_COLOR_BLACK);
-					state = MAIN_GAME;
+			// Route a new touch press to the current screen's regions
+			input_touch_route();
+			
+			// The console can pause and single-step the game
+			if(!state_pending && states[state].tick_a && !(state == MAIN_GAME && console_hold())){
+				telemetry_tick_begin();
+				states[state].tick_a();
+				telemetry_tick_end(interrupt_timerA);
+				if(interrupt_timerA) TRACE1(TICK_OVERRUN, counterA);
 			}
-			if (state==MAIN_GAME && !new_state){
-				if(sw1_debounce()){
-					state = PAUSE;
-					new_state  = true;
-					put_string("dddd");
-				}
-				// Update bullet positions
-				update_bullets();
-				
-				//If increment of 5 read ADC
-				if(counterA%5==0) {
-					// Initialize ADC Read
-					myADC->PSSI = ADC_PSSI_SS2;
-					//update_enemies();
-					if(update_enemies()) {
-						level_up();
-					}
-					if(!update_LCD()){
-						state = GAME_OVER;
-						new_state = true;
-					}
-				}
-				// If new interrupt count read PEXP buttons
-				if(counterA==0){
-					if(pexp_read_buttons(I2C1_BASE, &data) != I2C_OK){
-						put_string("error reading port expander");
-						continue;
-					}else if(data & PEXP_BUTTON_DOWN) fire_bullet(true, 0);
-					for(i=0; i<17; i++){
-						fire_bullet(false, get_rand_num(TIMER0_BASE));
-					}
-				}	
+			
+			// Pixels drawn this tick go out before the frame record after them
+			lcd_mirror_flush();
+			
+			// One telemetry frame per game frame, sent after its last tick
+			if(state == MAIN_GAME && counterA%MAIN_GAME_SAMPLE_TICKS == MAIN_GAME_SAMPLE_TICKS - 1){
+				count_entities(&entities);
+				telemetry_frame(&entities);
 			}
-	}
+		}
+		
 		//*************************************************************************
 		// TIMER B INTERRUPT HANDLING
 		//*************************************************************************
@@ -469,73 +527,26 @@ int main(void)
 			
 			// Increment the counter & reset to zero if it reached TIMER_B_CYCLES
 			counterB = ((counterB+1)%TIMER_B_CYCLES);
-
-			if(state == MAIN_GAME){
-				if(counterB==0) {
-					update_LCD();
-				}	
-			} else if (state == NEW_RECORD){
-				myADC->PSSI = ADC_PSSI_SS2;
-			}
-
 			
-		}
-		if(state == NEW_RECORD){			
-			// If right is pressed
-			if (pbRight_debounce()){
-				// If cursor is at position 2, submit score and enter HIGH_SCORE
-				if( cursor_pos ==2 ){
-					push_high_scores(initial);
-					pull_high_scores();
-					print_high_scores();
-					state = HIGH_SCORE;
-					new_state = true;
-					continue;
-				// Otherwise set selected character and increment cursor
-				} else {
-					initial[cursor_pos] = (char)selected_char + 'A';
-					selected_char = 0;
-					cursor_pos++;
-				}
-			
-			// If down is pressed and cursor is not at position 0
-			} else if ( pbDown_debounce() && (cursor_pos >0) ){
-				// Delete curret value and decrement cursor position
-				initial[cursor_pos] = ' ';
-				cursor_pos--;
-				selected_char = ((int) initial[cursor_pos] -'A');
+			// A device holding the bus is clocked free instead of hanging the game
+			if(i2cBusStuck(I2C1_BASE)){
+				TRACE1(I2C_RECOVER, i2cBusRecover(I2C1_BASE, EEPROM_GPIO_BASE, EEPROM_I2C_SCL_PIN, EEPROM_I2C_SDA_PIN));
 			}
-			// Print entered characters
+			
+			// Write back changed high scores, one entry per tick, and write out
+			// one queued EEPROM page if the last write cycle has finished
+			hs_flush_step();
+			eeprom_queue_step();
 
-				lcd_print_stringXY(initial, 5,11, GALAGA_COLOR_3, LCD_COLOR_BLACK );		
+			if(!state_pending && states[state].tick_b) states[state].tick_b();
 		}
+		
 		//*************************************************************************
 		// ADC0SS2 INTERRUPT HANDLING
 		//*************************************************************************
-		if(interrupt_adc0ss2)
+		if(joystick_read(&x_value, &y_value))
 		{	
-			// CLEAR INTERRUPT INDICATOR ============================================
-			interrupt_adc0ss2 = false;
-			
-			y_value = (uint32_t)(myADC->SSFIFO2 & 0xFFF);
-			x_value = (uint32_t)(myADC->SSFIFO2 & 0xFFF);
-			
-			if (state==MAIN_GAME){
-				if(x_value >= 0xBFD)
-					update_player(true);
-				else if (x_value <= 0x3FF)
-					update_player(false);
-			} else if(state == NEW_RECORD){
-          // Check if the y value is >= 75% increment currently selected character
-					if(y_value >= 0xBFD)	selected_char = (selected_char+1)%26;
-					// if y value is <=25%, decrement instead
-					else if(y_value <= 0x3FF) selected_char = selected_char-1;
-					if (selected_char < 0)
-						selected_char = 25;
-					// Set new character in cursor position
-					initial[cursor_pos] = (char)selected_char+'A';	
-      }
+			if(!state_pending && states[state].joystick) states[state].joystick(x_value, y_value);
 		}
 	}
 }
-
@@ -47,6 +47,9 @@
 #define TIMER_A_CYCLES 20
 #define TIMER_B_CYCLES 6
 
+// Runtime copy of TIMER_A_CYCLES, tuned from the serial console
+extern int32_t timer_a_cycles;
+
 // DEFINE STATUS BITS FOR PS2 READ ============================================
 // Define a value of 10 for TimerA/B's Interrupt Handler
 #define MOVE_Y_M						3
@@ -65,9 +68,28 @@
 #define LCD_TOUCH_BUFFER		8;
 
 
+// DEFINE LATENCY TRACE =======================================================
+// Uncomment to time joystick samples from the ADC ISR until the ship has been
+// redrawn.  The percentiles are printed to the serial port on pause.
+//#define LATENCY_TRACE
+
+
 // DEFINE EEPROM VARS
+// EEPROM map, every region starts on a page boundary
+//   0x100 - 0x122  old fixed high score table, read once to migrate it
+//   0x200 - 0x2FF  last fault record, see fault.h
+//   0x400 - 0xFFF  record log, two banks of 96 records
+// The old table entries are the score (least significant byte first)
+// followed by three initials.
 #define ADDR_START    256
 #define NUM_BYTES      10
+#define HS_ENTRY_SIZE   7
+
+#define FAULT_ADDR		0x200
+#define FAULT_SIZE		0x100
+
+#define RLOG_START		0x400
+#define RLOG_END			0x1000
 
 
 extern void serialDebugInit(void);
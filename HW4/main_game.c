@@ -0,0 +1,124 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "main.h"
+#include "ps2.h"
+#include "timers.h"
+#include "galaga.h"
+#include "input.h"
+#include "latency.h"
+#include "main_game.h"
+
+static ADC0_Type* myADC = ((ADC0_Type *)PS2_ADC_BASE);
+
+// Set by ADC0SS2_Handler, cleared by joystick_read
+static volatile bool interrupt_adc0ss2 = false;
+
+// Trace timestamp of the last joystick sample, taken in ADC0SS2_Handler
+static volatile uint32_t adc0ss2_stamp = 0;
+
+// Trace timestamp of the joystick sample being handled
+static uint32_t joystick_stamp;
+
+//*****************************************************************************
+// ADC0 Sample Sequencer 2 Interrupt Service handler
+//*****************************************************************************
+void ADC0SS2_Handler(void)
+{
+	// SIGNAL MAIN() THAT THE INTERRUPT OCCURRED ================================
+	adc0ss2_stamp = latency_now();
+	interrupt_adc0ss2 = true;
+	
+	// CLEAR THE ADC0SS2 INTERRUPT ==============================================
+	myADC->ISC |= ADC_ISC_IN2;
+}
+
+//*****************************************************************************
+// Function Name: joystick_start
+//*****************************************************************************
+//	Summary: Processor triggered, see ps2_initialize_HW3
+//
+//*****************************************************************************
+void joystick_start(void){
+	myADC->PSSI = ADC_PSSI_SS2;
+}
+
+//*****************************************************************************
+// Function Name: joystick_read
+//*****************************************************************************
+//	Summary: SSMUX2 converts y first, so the FIFO holds y then x
+//
+//*****************************************************************************
+bool joystick_read(uint32_t *x_value, uint32_t *y_value){
+	if(!interrupt_adc0ss2) return false;
+	
+	interrupt_adc0ss2 = false;
+	joystick_stamp = adc0ss2_stamp;
+	*y_value = (uint32_t)(myADC->SSFIFO2 & 0xFFF);
+	*x_value = (uint32_t)(myADC->SSFIFO2 & 0xFFF);
+	return true;
+}
+
+//*****************************************************************************
+// Function Name: main_game_tick
+//*****************************************************************************
+//	Summary: The sample is started before the enemies move so the conversion
+//					 runs while they are drawn
+//
+//*****************************************************************************
+bool main_game_tick(int counter){
+	int i;
+	
+	// Update bullet positions
+	update_bullets();
+	
+	//If increment of 5 read ADC
+	if(counter%MAIN_GAME_SAMPLE_TICKS==0) {
+		joystick_start();
+		if(update_enemies()) {
+			level_up();
+		}
+		if(!update_LCD()) return false;
+	}
+	// If new interrupt count fire if the down button is held
+	if(counter==0){
+		if(input_buttons.state & INPUT_BTN_DOWN) fire_bullet(true, 0);
+		for(i=0; i<17; i++){
+			fire_bullet(false, get_rand_num(TIMER0_BASE));
+		}
+	}
+	return true;
+}
+
+//*****************************************************************************
+// Function Name: main_game_joystick
+//*****************************************************************************
+//	Summary: The sample is done once the ship has been redrawn
+//
+//*****************************************************************************
+void main_game_joystick(uint32_t x_value, uint32_t y_value){
+	if(x_value >= MAIN_GAME_STICK_HIGH){
+		if(update_player(true)) latency_record(joystick_stamp);
+	}
+	else if (x_value <= MAIN_GAME_STICK_LOW){
+		if(update_player(false)) latency_record(joystick_stamp);
+	}
+}
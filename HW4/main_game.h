@@ -1,4 +1,4 @@
-// Copyright (c) 2015, Joe Krachey
+// Copyright (c) 2015-16, Joe Krachey
 // All rights reserved.
 //
 // Redistribution and use in source or binary form, with or without modification, 
@@ -19,92 +19,71 @@
 // WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
 // NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-#include "pc_buffer.h"
+#ifndef __MAIN_GAME_H__
+#define __MAIN_GAME_H__
 
-//*****************************************************************************
-// Initializes a Producer-Consumer circular buffer.  Be sure to allocate 
-// memory using malloc for the array field.
-// 
-// Parameters
-//    buffer  :   The address of the circular buffer.
-//    size:       Number of entries in the circular buffer.
-//*****************************************************************************
-void pc_buffer_init(PC_Buffer *buffer, uint16_t buffer_size)
-{
+#include <stdint.h>
+#include <stdbool.h>
 
-	buffer->array 		= malloc(sizeof(char)*buffer_size);
-	buffer->BUFFER_SIZE = buffer_size;
-	buffer->produce_count = 0;
-	buffer->consume_count = 0;
-}
+// DEFINE MAIN GAME VARS ======================================================
+// Timer A ticks per joystick sample and enemy move
+#define MAIN_GAME_SAMPLE_TICKS			5
 
+// Joystick readings past 75% and 25% of full scale that move the ship
+#define MAIN_GAME_STICK_HIGH				0xBFD
+#define MAIN_GAME_STICK_LOW					0x3FF
+
+//*****************************************************************************
+// Function Name: joystick_start
 //*****************************************************************************
-// Adds a character to the circular buffer.
-// 
-// Parameters
-//    buffer  :   The address of the circular buffer.
-//    data    :   Character to add.
+//	Summary: Starts a conversion of both joystick axes on ADC0 SS2.
+//					 ADC0SS2_Handler runs when it is done.
+//
 //*****************************************************************************
-void pc_buffer_add(PC_Buffer *buffer, char data)
-{
-	if(buffer==NULL) return;
-	if(!pc_buffer_full(buffer)) {
-		buffer->array[buffer->produce_count%buffer->BUFFER_SIZE] = data;
-		buffer->produce_count++;
-	}
-	return;
-}
+void joystick_start(void);
 
 //*****************************************************************************
-// Removes the oldest character from the circular buffer.
-// 
-// Parameters
-//    buffer  :   The address of the circular buffer.
-//    data    :   Address to place the oldest character.
+// Function Name: joystick_read
+//*****************************************************************************
+//	Summary: Takes the sample ADC0SS2_Handler flagged, if there is one, and
+//					 keeps its trace timestamp for main_game_joystick
+//
+//	Params:
+//					 x_value - set to the x axis, 12 bits
+//					 y_value - set to the y axis, 12 bits
+//
+//	Returns:
+//					 true - a new sample was read
+//					 false - no sample since the last call
+//
 //*****************************************************************************
-void pc_buffer_remove(PC_Buffer *buffer, char *data)
-{
-	if(buffer==NULL) return;
-	if(!pc_buffer_empty(buffer)) {
-		*data = buffer->array[buffer->consume_count%buffer->BUFFER_SIZE];
-		buffer->consume_count++;
-	}
-	return;
-}
+bool joystick_read(uint32_t *x_value, uint32_t *y_value);
 
 //*****************************************************************************
-// Returns true if the circular buffer is empty.  Returns false if it is not.
-// 
-// Parameters
-//    buffer  :   The address of the circular buffer.
+// Function Name: main_game_tick
+//*****************************************************************************
+//	Summary: One Timer A tick of the game.  Moves the bullets, and every
+//					 MAIN_GAME_SAMPLE_TICKS ticks starts a joystick sample and
+//					 moves and redraws the enemies.  The enemies fire when counter
+//					 wraps to 0, and so does the player if down is held.
+//
+//	Params:
+//					 counter - Timer A tick count, 0 to timer_a_cycles - 1
+//
+//	Returns:
+//					 true - the game goes on
+//					 false - the player was hit, the game is over
+//
 //*****************************************************************************
-bool pc_buffer_empty(PC_Buffer *buffer)
-{
-	if(buffer->produce_count==buffer->consume_count)
-	{
-		return true;
-	}
-	else
-	{
-		return false;
-	}
-}
+bool main_game_tick(int counter);
 
 //*****************************************************************************
-// Returns true if the circular buffer is full.  Returns false if it is not.
-// 
-// Parameters
-//    buffer  :   The address of the circular buffer.
+// Function Name: main_game_joystick
+//*****************************************************************************
+//	Summary: Moves the ship when the stick is far enough over.  The sample's
+//					 input-to-photon time is recorded once the ship is redrawn.
+//
 //*****************************************************************************
-bool pc_buffer_full(PC_Buffer *buffer)
-{
-	if(pc_buffer_empty(buffer)) return false;
-	if((buffer->produce_count-buffer->consume_count) == buffer->BUFFER_SIZE)
-	{
-		return true;
-	}
-	else
-	{
-		return false;
-	}
-}
+void main_game_joystick(uint32_t x_value, uint32_t y_value);
+
+#endif
@@ -0,0 +1,167 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "main.h"
+#include "lcd.h"
+#include "galaga.h"
+#include "name_entry.h"
+
+typedef enum {
+	ENTRY_IDLE,
+	ENTRY_EDITING,
+	ENTRY_DONE
+} entry_state_t;
+
+static entry_state_t entry_state = ENTRY_IDLE;
+
+// The name being entered and what the LCD shows, blank past the cursor
+static char name[NAME_ENTRY_LEN + 1];
+static char shown[NAME_ENTRY_LEN];
+static uint8_t cursor = 0;
+
+//*****************************************************************************
+// Function Name: name_entry_start
+//*****************************************************************************
+//	Summary: Blanks the name and what the LCD is taken to show.  The rows
+//					 were cleared by the state change, so the first draw only
+//					 prints the 'A' at the cursor.
+//
+//*****************************************************************************
+void name_entry_start(void){
+	int i;
+	
+	for(i = 0; i < NAME_ENTRY_LEN; i++){
+		name[i] = ' ';
+		shown[i] = ' ';
+	}
+	name[NAME_ENTRY_LEN] = '\0';
+	name[0] = 'A';
+	cursor = 0;
+	entry_state = ENTRY_EDITING;
+}
+
+//*****************************************************************************
+// Function Name: name_entry_stop
+//*****************************************************************************
+//	Summary: Ends name entry, further input is ignored
+//
+//*****************************************************************************
+void name_entry_stop(void){
+	entry_state = ENTRY_IDLE;
+}
+
+//*****************************************************************************
+// Function Name: name_entry_key
+//*****************************************************************************
+//	Summary: Applies one edit.  Only the name is changed, the LCD is updated by
+//					 name_entry_draw.
+//
+//*****************************************************************************
+void name_entry_key(name_key_t key){
+	if(entry_state != ENTRY_EDITING) return;
+	
+	switch(key){
+		case NAME_KEY_UP:
+			name[cursor] = (name[cursor] == 'Z') ? 'A' : name[cursor] + 1;
+			break;
+		case NAME_KEY_DOWN:
+			name[cursor] = (name[cursor] == 'A') ? 'Z' : name[cursor] - 1;
+			break;
+		case NAME_KEY_NEXT:
+			if(cursor == NAME_ENTRY_LEN - 1) entry_state = ENTRY_DONE;
+			else name[++cursor] = 'A';
+			break;
+		case NAME_KEY_BACK:
+			if(cursor > 0) name[cursor--] = ' ';
+			break;
+	}
+}
+
+//*****************************************************************************
+// Function Name: name_entry_type
+//*****************************************************************************
+//	Summary: Replaces the name with typed text and submits it.  The text is
+//					 checked in full before the name is touched.
+//
+//	Returns: false if no name is being entered or text is not exactly
+//					 NAME_ENTRY_LEN letters
+//
+//*****************************************************************************
+bool name_entry_type(const char *text){
+	char typed[NAME_ENTRY_LEN];
+	int i;
+	
+	if(entry_state != ENTRY_EDITING) return false;
+	
+	for(i = 0; i < NAME_ENTRY_LEN; i++){
+		if(text[i] >= 'a' && text[i] <= 'z') typed[i] = text[i] - 'a' + 'A';
+		else if(text[i] >= 'A' && text[i] <= 'Z') typed[i] = text[i];
+		else return false;
+	}
+	if(text[NAME_ENTRY_LEN] != '\0') return false;
+	
+	for(i = 0; i < NAME_ENTRY_LEN; i++) name[i] = typed[i];
+	cursor = NAME_ENTRY_LEN - 1;
+	entry_state = ENTRY_DONE;
+	return true;
+}
+
+//*****************************************************************************
+// Function Name: name_entry_draw
+//*****************************************************************************
+//	Summary: Redraws each letter that differs from what the LCD shows.  A
+//					 letter changed and changed back between calls is not drawn.
+//
+//*****************************************************************************
+void name_entry_draw(void){
+	char cell[2];
+	int i;
+	
+	if(entry_state == ENTRY_IDLE) return;
+	
+	cell[1] = '\0';
+	for(i = 0; i < NAME_ENTRY_LEN; i++){
+		if(name[i] == shown[i]) continue;
+		cell[0] = name[i];
+		lcd_print_stringXY(cell, NAME_ENTRY_X + i, NAME_ENTRY_Y, GALAGA_COLOR_3, LCD_COLOR_BLACK);
+		shown[i] = name[i];
+	}
+}
+
+//*****************************************************************************
+// Function Name: name_entry_done
+//*****************************************************************************
+//	Summary: Returns true once the name has been submitted
+//
+//*****************************************************************************
+bool name_entry_done(void){
+	return entry_state == ENTRY_DONE;
+}
+
+//*****************************************************************************
+// Function Name: name_entry_text
+//*****************************************************************************
+//	Summary: Returns the name, NAME_ENTRY_LEN characters and a terminator
+//
+//*****************************************************************************
+char *name_entry_text(void){
+	return name;
+}
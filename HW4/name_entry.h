@@ -0,0 +1,109 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef __NAME_ENTRY_H__
+#define __NAME_ENTRY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DEFINE NAME ENTRY VARS =====================================================
+// Letters in a high score name
+#define NAME_ENTRY_LEN							3
+
+// Text position of the first letter
+#define NAME_ENTRY_X								5
+#define NAME_ENTRY_Y								11
+
+// Edits from the joystick and buttons
+typedef enum {
+	NAME_KEY_UP,					// next letter at the cursor
+	NAME_KEY_DOWN,				// previous letter at the cursor
+	NAME_KEY_NEXT,				// keep the letter and move right, submit on the last one
+	NAME_KEY_BACK					// clear the letter and move left
+} name_key_t;
+
+//*****************************************************************************
+// Function Name: name_entry_start
+//*****************************************************************************
+//	Summary: Starts a new name at the first letter with 'A' selected.  Nothing
+//					 is drawn until the next name_entry_draw.
+//
+//*****************************************************************************
+void name_entry_start(void);
+
+//*****************************************************************************
+// Function Name: name_entry_stop
+//*****************************************************************************
+//	Summary: Ends name entry, further input is ignored
+//
+//*****************************************************************************
+void name_entry_stop(void);
+
+//*****************************************************************************
+// Function Name: name_entry_key
+//*****************************************************************************
+//	Summary: Applies one edit.  Only the name is changed, the LCD is updated by
+//					 name_entry_draw.
+//
+//*****************************************************************************
+void name_entry_key(name_key_t key);
+
+//*****************************************************************************
+// Function Name: name_entry_type
+//*****************************************************************************
+//	Summary: Replaces the name with typed text and submits it.  Lowercase
+//					 letters are accepted.
+//
+//	Returns: false if no name is being entered or text is not exactly
+//					 NAME_ENTRY_LEN letters
+//
+//*****************************************************************************
+bool name_entry_type(const char *text);
+
+//*****************************************************************************
+// Function Name: name_entry_draw
+//*****************************************************************************
+//	Summary: Redraws the letters that changed since the last call, if any.
+//					 Call once per UI tick; edits between calls cost one redraw.
+//
+//*****************************************************************************
+void name_entry_draw(void);
+
+//*****************************************************************************
+// Function Name: name_entry_done
+//*****************************************************************************
+//	Summary: Returns true once the name has been submitted
+//
+//*****************************************************************************
+bool name_entry_done(void);
+
+//*****************************************************************************
+// Function Name: name_entry_text
+//*****************************************************************************
+//	Summary: Returns the name entered so far.  Letters past the cursor are
+//					 blank until the name is submitted; a submitted name always
+//					 has NAME_ENTRY_LEN letters.
+//
+//*****************************************************************************
+char *name_entry_text(void);
+
+#endif
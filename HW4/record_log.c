@@ -0,0 +1,281 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "main.h"
+#include "i2c.h"
+#include "eeprom.h"
+#include "validate.h"
+#include "galaga_bitmaps.h"
+#include "crc16.h"
+#include "latency.h"
+#include "record_log.h"
+
+// Record layout, RLOG_RECORD_SIZE bytes.  Records are page aligned so each
+// one is a single page write.
+#define REC_MAGIC									0
+#define REC_INDEX									1
+#define REC_SEQ										2
+#define REC_DATA									6
+#define REC_CRC										(RLOG_RECORD_SIZE - 2)
+
+// Slots read per sequential read during the boot scan
+#define SCAN_SLOTS								16
+
+rlog_stats_t rlog_stats;
+
+static uint16_t head;													// address of the next slot to write
+static uint32_t next_seq = 1;
+static uint8_t num_indexes = 0;
+static uint16_t live_addr[RLOG_MAX_INDEX];		// 0 if the index has no record
+static uint32_t live_seq[RLOG_MAX_INDEX];
+
+//*****************************************************************************
+// Function Name: seq_newer
+//*****************************************************************************
+//	Summary: True if sequence number a was written after b, across a wrap
+//
+//*****************************************************************************
+static bool seq_newer(uint32_t a, uint32_t b){
+	return (int32_t)(a - b) > 0;
+}
+
+//*****************************************************************************
+// Function Name: bank_of
+//*****************************************************************************
+//	Summary: Bank number, 0 or 1, holding the slot at addr
+//
+//*****************************************************************************
+static int bank_of(uint16_t addr){
+	return (addr - RLOG_START) / RLOG_BANK_SIZE;
+}
+
+//*****************************************************************************
+// Function Name: rec_valid
+//*****************************************************************************
+//	Summary: Checks the magic, index and CRC of one record
+//
+//*****************************************************************************
+static bool rec_valid(const uint8_t *rec){
+	uint16_t crc;
+	
+	if(rec[REC_MAGIC] != RLOG_MAGIC || rec[REC_INDEX] >= num_indexes) return false;
+	crc = rec[REC_CRC] | (rec[REC_CRC+1] << 8);
+	return crc == crc16(CRC16_INIT, rec, REC_CRC);
+}
+
+//*****************************************************************************
+// Function Name: rec_seq
+//*****************************************************************************
+//	Summary: Sequence number of a record, least significant byte first
+//
+//*****************************************************************************
+static uint32_t rec_seq(const uint8_t *rec){
+	return rec[REC_SEQ] | (rec[REC_SEQ+1] << 8) | (rec[REC_SEQ+2] << 16) | ((uint32_t)rec[REC_SEQ+3] << 24);
+}
+
+//*****************************************************************************
+// Function Name: write_record
+//*****************************************************************************
+//	Summary: Queues one record at head with the next sequence number.  The
+//					 EEPROM write happens later from eeprom_queue_step(); reads
+//					 go through eeprom_queue_read() so they see it meanwhile.
+//					 head only moves on success so a failed write is retried in
+//					 the same slot.
+//
+//*****************************************************************************
+static i2c_status_t write_record(uint8_t index, const uint8_t *data){
+	uint8_t rec[RLOG_RECORD_SIZE];
+	uint16_t crc;
+	i2c_status_t status;
+	int i;
+	
+	rec[REC_MAGIC] = RLOG_MAGIC;
+	rec[REC_INDEX] = index;
+	for(i = 0; i < 4; i++) rec[REC_SEQ+i] = (next_seq >> (8*i)) & 0xFF;
+	for(i = 0; i < RLOG_DATA_SIZE; i++) rec[REC_DATA+i] = data[i];
+	crc = crc16(CRC16_INIT, rec, REC_CRC);
+	rec[REC_CRC] = crc & 0xFF;
+	rec[REC_CRC+1] = crc >> 8;
+	
+	status = eeprom_queue_write(I2C1_BASE, head, rec, RLOG_RECORD_SIZE);
+	if(status != I2C_OK) return status;
+	
+	live_addr[index] = head;
+	live_seq[index] = next_seq;
+	next_seq++;
+	head += RLOG_RECORD_SIZE;
+	rlog_stats.record_writes++;
+	return I2C_OK;
+}
+
+//*****************************************************************************
+// Function Name: read_data
+//*****************************************************************************
+//	Summary: Reads back the payload of the live record for index
+//
+//*****************************************************************************
+static i2c_status_t read_data(uint8_t index, uint8_t *data){
+	return eeprom_queue_read(I2C1_BASE, live_addr[index] + REC_DATA, data, RLOG_DATA_SIZE);
+}
+
+//*****************************************************************************
+// Function Name: compact
+//*****************************************************************************
+//	Summary: Copies every live record except skip to the start of the other
+//					 bank.  All of them are read before any is written, so a record
+//					 can never be overwritten before it has been copied.
+//
+//*****************************************************************************
+static i2c_status_t compact(uint8_t skip){
+	uint8_t data[RLOG_MAX_INDEX][RLOG_DATA_SIZE];
+	i2c_status_t status;
+	int i;
+	
+	for(i = 0; i < num_indexes; i++){
+		if(i == skip || live_addr[i] == 0) continue;
+		status = read_data(i, data[i]);
+		if(status != I2C_OK) return status;
+	}
+	
+	// The second bank starts where the first one ends
+	if(head == RLOG_END) head = RLOG_START;
+	rlog_stats.compactions++;
+	
+	for(i = 0; i < num_indexes; i++){
+		if(i == skip || live_addr[i] == 0) continue;
+		status = write_record(i, data[i]);
+		if(status != I2C_OK) return status;
+	}
+	return I2C_OK;
+}
+
+//*****************************************************************************
+// Function Name: append
+//*****************************************************************************
+//	Summary: A full bank leaves head on a bank boundary
+//
+//*****************************************************************************
+static i2c_status_t append(uint8_t index, const uint8_t *data){
+	i2c_status_t status;
+	
+	if(head == RLOG_START + RLOG_BANK_SIZE || head == RLOG_END){
+		status = compact(index);
+		if(status != I2C_OK) return status;
+	}
+	return write_record(index, data);
+}
+
+//*****************************************************************************
+// Function Name: rlog_mount
+//*****************************************************************************
+//	Summary: Reads the whole region once.  The slot after the record with the
+//					 highest sequence number is where the next record goes.
+//
+//*****************************************************************************
+uint8_t rlog_mount(uint8_t data[][RLOG_DATA_SIZE], uint8_t num_index){
+	uint8_t buf[SCAN_SLOTS * RLOG_RECORD_SIZE];
+	uint8_t *rec;
+	uint32_t seq, max_seq = 0;
+	uint32_t start = latency_now();
+	uint16_t addr, max_addr = 0;
+	uint8_t found = 0;
+	int i;
+	
+	num_indexes = num_index > RLOG_MAX_INDEX ? RLOG_MAX_INDEX : num_index;
+	for(i = 0; i < RLOG_MAX_INDEX; i++) live_addr[i] = 0;
+	
+	for(addr = RLOG_START; addr < RLOG_END; addr += sizeof(buf)){
+		if(eeprom_read(I2C1_BASE, addr, buf, sizeof(buf)) != I2C_OK) continue;
+		
+		for(i = 0; i < SCAN_SLOTS; i++){
+			rec = buf + i*RLOG_RECORD_SIZE;
+			rlog_stats.records_scanned++;
+			if(!rec_valid(rec)) continue;
+			rlog_stats.records_valid++;
+			
+			seq = rec_seq(rec);
+			if(max_addr == 0 || seq_newer(seq, max_seq)){
+				max_seq = seq;
+				max_addr = addr + i*RLOG_RECORD_SIZE;
+			}
+			if(live_addr[rec[REC_INDEX]] == 0 || seq_newer(seq, live_seq[rec[REC_INDEX]])){
+				live_addr[rec[REC_INDEX]] = addr + i*RLOG_RECORD_SIZE;
+				live_seq[rec[REC_INDEX]] = seq;
+				memcpy(data[rec[REC_INDEX]], rec + REC_DATA, RLOG_DATA_SIZE);
+				found |= 1 << rec[REC_INDEX];
+			}
+		}
+	}
+	
+	if(max_addr == 0){
+		head = RLOG_START;
+		next_seq = 1;
+	}
+	else{
+		head = max_addr + RLOG_RECORD_SIZE;
+		next_seq = max_seq + 1;
+		
+		// Finish a compaction that was cut short.  Leaving a live record in the
+		// other bank would let the next compaction overwrite its only copy.
+		for(i = 0; i < num_indexes; i++){
+			if(live_addr[i] != 0 && bank_of(live_addr[i]) != bank_of(max_addr)){
+				append(i, data[i]);
+			}
+		}
+	}
+	
+	rlog_stats.scan_ticks = latency_now() - start;
+	return found;
+}
+
+//*****************************************************************************
+// Function Name: rlog_append
+//*****************************************************************************
+//	Summary: Only appends made here count as user writes
+//
+//*****************************************************************************
+i2c_status_t rlog_append(uint8_t index, const uint8_t *data){
+	if(index >= num_indexes) return I2C_INVALID_PARAM;
+	rlog_stats.user_writes++;
+	return append(index, data);
+}
+
+//*****************************************************************************
+// Function Name: rlog_report
+//*****************************************************************************
+//	Summary: Write amplification is shown times 100, 100 means no overhead
+//
+//*****************************************************************************
+void rlog_report(void){
+	put_string("RLOG\n\r");
+	latency_print_count("  scanned      ", rlog_stats.records_scanned);
+	latency_print_count("  valid        ", rlog_stats.records_valid);
+#ifdef LATENCY_TRACE
+	latency_print_count("  scan us      ", rlog_stats.scan_ticks / LATENCY_TICKS_PER_US);
+#endif
+	latency_print_count("  user writes  ", rlog_stats.user_writes);
+	latency_print_count("  rec writes   ", rlog_stats.record_writes);
+	latency_print_count("  compactions  ", rlog_stats.compactions);
+	latency_print_count("  queued bytes ", eeprom_queue_pending());
+	if(rlog_stats.user_writes)
+		latency_print_count("  write amp x100 ", (rlog_stats.record_writes * 100) / rlog_stats.user_writes);
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef __RECORD_LOG_H__
+#define __RECORD_LOG_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "main.h"
+#include "i2c.h"
+
+// An append-only log of small records in the EEPROM.  Every record carries
+// an index, a sequence number and a CRC; the newest valid record for each
+// index is its current value.  The log region is split in two banks.  When
+// the active bank fills, the live records are copied to the start of the
+// other bank and appending continues there, so every slot is written about
+// as often as every other one.  A torn write only ever damages the record
+// being written, which then fails its CRC and is ignored.
+
+#define RLOG_RECORD_SIZE					16
+#define RLOG_DATA_SIZE						8
+#define RLOG_MAX_INDEX						8
+#define RLOG_MAGIC								0xA5
+
+#define RLOG_BANK_SIZE						((RLOG_END - RLOG_START) / 2)
+#define RLOG_SLOTS_PER_BANK				(RLOG_BANK_SIZE / RLOG_RECORD_SIZE)
+
+typedef struct {
+	uint32_t records_scanned;		// slots read by the boot scan
+	uint32_t records_valid;			// of those, records that passed the CRC
+	uint32_t scan_ticks;				// boot scan time, LATENCY_TRACE timebase
+	uint32_t user_writes;				// records appended by the caller
+	uint32_t record_writes;			// records written including compaction
+	uint32_t compactions;
+} rlog_stats_t;
+
+extern rlog_stats_t rlog_stats;
+
+//*****************************************************************************
+// Function Name: rlog_mount
+//*****************************************************************************
+//	Summary: Scans the log for the newest valid record of every index and
+//					 finds where the next record goes.  Records left behind by an
+//					 interrupted compaction are copied forward.
+//
+//	Params:
+//					 data - receives the payload of each index that was found
+//					 num_index - number of indexes in use, up to RLOG_MAX_INDEX
+//
+//	Returns:
+//					 Bit mask of the indexes that were found
+//
+//*****************************************************************************
+uint8_t rlog_mount(uint8_t data[][RLOG_DATA_SIZE], uint8_t num_index);
+
+//*****************************************************************************
+// Function Name: rlog_append
+//*****************************************************************************
+//	Summary: Appends a new value for index, compacting first if the active
+//					 bank is full
+//
+//	Params:
+//					 index - record index, less than the num_index given to mount
+//					 data - RLOG_DATA_SIZE bytes of payload
+//
+//	Returns:
+//					 I2C_OK or the error from the EEPROM
+//
+//*****************************************************************************
+i2c_status_t rlog_append(uint8_t index, const uint8_t *data);
+
+//*****************************************************************************
+// Function Name: rlog_report
+//*****************************************************************************
+//	Summary: Prints the scan and write amplification counters to the serial
+//					 debug port
+//
+//*****************************************************************************
+void rlog_report(void);
+
+#endif
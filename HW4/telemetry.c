@@ -0,0 +1,306 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include <string.h>
+
+#include "TM4C123.h"
+#include "serial_debug.h"
+#include "i2c.h"
+#include "crc16.h"
+#include "latency.h"
+#include "telemetry.h"
+
+bool telemetry_enabled = true;
+
+// Largest record before and after encoding, COBS adds one byte to records
+// shorter than 254 bytes and the two delimiters are two more
+#define TLM_MAX_RECORD		(TLM_HEADER_SIZE + TLM_MAX_PAYLOAD + TLM_CRC_SIZE)
+#define TLM_MAX_ENCODED		(TLM_MAX_RECORD + 3)
+
+static uint8_t tlm_seq = 0;
+static uint16_t tlm_frame_num = 0;
+static uint16_t tlm_frame_bytes = 0;		// bytes queued in the current frame
+static uint8_t tlm_drops = 0;						// records dropped in the current frame
+
+// Timing of the ticks in the current frame, in Timer A counts
+static uint16_t tick_start;
+static uint8_t frame_ticks = 0;
+static uint32_t frame_busy = 0;
+static uint16_t frame_max = 0;
+static uint16_t frame_lag = 0;
+static uint8_t frame_overruns = 0;
+
+//*****************************************************************************
+// Function Name: put16
+//*****************************************************************************
+//	Summary: Stores v least significant byte first, returns the next byte
+//
+//*****************************************************************************
+static uint8_t *put16(uint8_t *p, uint16_t v){
+	*p++ = v & 0xFF;
+	*p++ = v >> 8;
+	return p;
+}
+
+//*****************************************************************************
+// Function Name: sat16
+//*****************************************************************************
+//	Summary: Clamps a count to what fits in a 16-bit field
+//
+//*****************************************************************************
+static uint16_t sat16(uint32_t v){
+	return v > 0xFFFF ? 0xFFFF : v;
+}
+
+//*****************************************************************************
+// Function Name: cobs_encode
+//*****************************************************************************
+//	Summary: COBS encodes len (< 254) bytes of src into dst, which must hold
+//					 len + 1 bytes.  Returns the encoded length, without a delimiter.
+//
+//*****************************************************************************
+static uint8_t cobs_encode(const uint8_t *src, uint8_t len, uint8_t *dst){
+	uint8_t code_pos = 0;
+	uint8_t code = 1;
+	uint8_t n = 1;
+	uint8_t i;
+	
+	for(i = 0; i < len; i++){
+		if(src[i] == 0){
+			dst[code_pos] = code;
+			code_pos = n++;
+			code = 1;
+		}
+		else{
+			dst[n++] = src[i];
+			code++;
+		}
+	}
+	dst[code_pos] = code;
+	return n;
+}
+
+//*****************************************************************************
+// Function Name: tlm_encode
+//*****************************************************************************
+//	Summary: Builds one record with its CRC and COBS encodes it between two
+//					 delimiters into out.  Returns the number of bytes to send.
+//
+//*****************************************************************************
+static uint8_t tlm_encode(uint8_t type, const uint8_t *payload, uint8_t len, uint8_t *out){
+	uint8_t raw[TLM_MAX_RECORD];
+	uint16_t crc;
+	uint8_t n;
+	
+	raw[0] = type;
+	raw[1] = tlm_seq++;
+	memcpy(&raw[TLM_HEADER_SIZE], payload, len);
+	len += TLM_HEADER_SIZE;
+	crc = crc16(CRC16_INIT, raw, len);
+	put16(&raw[len], crc);
+	len += TLM_CRC_SIZE;
+	
+	// The leading delimiter ends any text put_string left on the line
+	out[0] = 0;
+	n = cobs_encode(raw, len, &out[1]) + 1;
+	out[n++] = 0;
+	return n;
+}
+
+//*****************************************************************************
+// Function Name: tlm_send
+//*****************************************************************************
+//	Summary: Queues one record on UART0 without waiting.  The record is
+//					 dropped whole if it does not fit in the frame budget or the TX
+//					 ring, a partial record would cost the host the next record as
+//					 well.
+//
+//*****************************************************************************
+static void tlm_send(uint8_t type, const uint8_t *payload, uint8_t len){
+	uint8_t out[TLM_MAX_ENCODED];
+	uint8_t n;
+	
+	n = tlm_encode(type, payload, len, out);
+	if(tlm_frame_bytes + n > TELEMETRY_FRAME_BUDGET || ring_space(&UART0_Tx_Buffer) < n){
+		if(tlm_drops < 0xFF) tlm_drops++;
+		return;
+	}
+	serial_debug_write(UART0_BASE, &UART0_Tx_Buffer, (const char *)out, n);
+	tlm_frame_bytes += n;
+}
+
+//*****************************************************************************
+// Function Name: telemetry_tick_begin
+//*****************************************************************************
+//	Summary: Timer A reloads on the interrupt, so how far it has counted down
+//					 is how late the tick is being handled
+//
+//*****************************************************************************
+void telemetry_tick_begin(void){
+	uint16_t lag;
+	
+	tick_start = TIMER0->TAR & 0xFFFF;
+	lag = (TIMER0->TAILR & 0xFFFF) - tick_start;
+	if(lag > frame_lag) frame_lag = lag;
+}
+
+//*****************************************************************************
+// Function Name: telemetry_tick_end
+//*****************************************************************************
+//	Summary: A tick longer than the timer period wraps, the overrun flag tells
+//					 the host the duration is short by a multiple of the period
+//
+//*****************************************************************************
+void telemetry_tick_end(bool overrun){
+	uint16_t now = TIMER0->TAR & 0xFFFF;
+	uint16_t elapsed;
+	
+	if(tick_start >= now) elapsed = tick_start - now;
+	else elapsed = tick_start + (TIMER0->TAILR & 0xFFFF) - now;
+	
+	frame_busy += elapsed;
+	if(elapsed > frame_max) frame_max = elapsed;
+	if(overrun && frame_overruns < 0xFF) frame_overruns++;
+	if(frame_ticks < 0xFF) frame_ticks++;
+}
+
+//*****************************************************************************
+// Function Name: telemetry_frame
+//*****************************************************************************
+//	Summary: Sends the frame timing and entity records for the ticks since the
+//					 last call, plus the I2C counters every TELEMETRY_I2C_FRAMES,
+//					 and starts a new frame budget
+//
+//*****************************************************************************
+void telemetry_frame(const tlm_entities_t *entities){
+	uint8_t payload[TLM_MAX_PAYLOAD];
+	uint8_t *p;
+	const i2c_stats_t *stats;
+	
+	if(!telemetry_enabled) return;
+	
+	// The drop count covers the frame that is ending, the budget restarts
+	p = put16(payload, tlm_frame_num);
+	*p++ = frame_ticks;
+	p = put16(p, sat16(frame_busy * TELEMETRY_US_PER_COUNT));
+	p = put16(p, sat16((uint32_t)frame_max * TELEMETRY_US_PER_COUNT));
+	p = put16(p, sat16((uint32_t)frame_lag * TELEMETRY_US_PER_COUNT));
+	*p++ = frame_overruns;
+	*p++ = tlm_drops;
+	tlm_frame_bytes = 0;
+	tlm_drops = 0;
+	tlm_send(TLM_FRAME, payload, TLM_FRAME_SIZE);
+	
+	payload[0] = entities->units;
+	payload[1] = entities->player_bullets;
+	payload[2] = entities->enemy_bullets;
+	payload[3] = entities->lives;
+	payload[4] = entities->level;
+	tlm_send(TLM_ENTITIES, payload, TLM_ENTITIES_SIZE);
+	
+	// Counters are sent as running totals, the host takes the differences,
+	// so latency_i2c_report can still clear them
+	if(tlm_frame_num % TELEMETRY_I2C_FRAMES == 0){
+		stats = i2cGetStats(I2C1_BASE);
+		if(stats){
+			p = put16(payload, stats->transfers);
+			p = put16(p, stats->async_xfers);
+			p = put16(p, stats->bytes_written + stats->bytes_read);
+			*p++ = stats->nacks;
+			*p++ = stats->timeouts;
+			p = put16(p, sat16(stats->max_ticks / LATENCY_TICKS_PER_US));
+			tlm_send(TLM_I2C, payload, TLM_I2C_SIZE);
+		}
+	}
+	
+	tlm_frame_num++;
+	frame_ticks = 0;
+	frame_busy = 0;
+	frame_max = 0;
+	frame_lag = 0;
+	frame_overruns = 0;
+}
+
+//*****************************************************************************
+// Function Name: telemetry_score
+//*****************************************************************************
+//	Summary: Sends a score event for points scored by destroying a unit
+//
+//*****************************************************************************
+void telemetry_score(uint32_t score, uint16_t points, uint8_t unit_type){
+	uint8_t payload[TLM_SCORE_SIZE];
+	uint8_t *p;
+	
+	if(!telemetry_enabled) return;
+	
+	p = put16(payload, score & 0xFFFF);
+	p = put16(p, score >> 16);
+	p = put16(p, points);
+	*p = unit_type;
+	tlm_send(TLM_SCORE, payload, TLM_SCORE_SIZE);
+}
+
+//*****************************************************************************
+// Function Name: telemetry_record
+//*****************************************************************************
+//	Summary: Sends one record outside the frame budget, waiting for room.
+//					 polled writes straight to the UART0 FIFO for callers running
+//					 with interrupts off, after the TX ring has been sent.
+//
+//*****************************************************************************
+void telemetry_record(uint8_t type, const uint8_t *payload, uint8_t len, bool polled){
+	UART0_Type *uart = (UART0_Type *)UART0_BASE;
+	uint8_t out[TLM_MAX_ENCODED];
+	uint8_t n, i;
+	
+	n = tlm_encode(type, payload, len, out);
+	if(!polled){
+		for(i = 0; i < n; i++) serial_debug_tx(UART0_BASE, &UART0_Tx_Buffer, out[i]);
+		return;
+	}
+	
+	// Bytes still in the ring go out first so a record is never split
+	serial_debug_tx_drain(UART0_BASE, &UART0_Tx_Buffer);
+	for(i = 0; i < n; i++){
+		while(uart->FR & UART_FR_TXFF);
+		uart->DR = out[i];
+	}
+}
+
+//*****************************************************************************
+// Function Name: telemetry_offer
+//*****************************************************************************
+//	Summary: Queues one record outside the frame budget if the TX ring still
+//					 has reserve bytes free after it.  Never waits.
+//
+//	Returns: false if the record was not queued
+//
+//*****************************************************************************
+bool telemetry_offer(uint8_t type, const uint8_t *payload, uint8_t len, uint32_t reserve){
+	uint8_t out[TLM_MAX_ENCODED];
+	uint8_t n;
+	
+	// The worst case size is checked first so a refused record costs no CRC
+	if(ring_space(&UART0_Tx_Buffer) < len + TLM_HEADER_SIZE + TLM_CRC_SIZE + 3 + reserve) return false;
+	n = tlm_encode(type, payload, len, out);
+	serial_debug_write(UART0_BASE, &UART0_Tx_Buffer, (const char *)out, n);
+	return true;
+}
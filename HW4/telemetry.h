@@ -0,0 +1,135 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DEFINE TELEMETRY VARS ======================================================
+// Each record is
+//   type, seq, payload (little endian), crc16 of type..payload (little endian)
+// COBS encoded between two 0x00 delimiters, so a reader can resync on the
+// next zero after a dropped byte or a line of text from put_string.
+// seq counts every record built, a gap on the host means records were dropped.
+#define TLM_HEADER_SIZE							2
+#define TLM_CRC_SIZE								2
+#define TLM_MAX_PAYLOAD							64
+
+// Record types and their payload sizes
+#define TLM_FRAME										0x01
+#define TLM_FRAME_SIZE							11		// frame u16, ticks u8, busy_us u16, max_us u16, lag_us u16, overruns u8, drops u8
+#define TLM_ENTITIES								0x02
+#define TLM_ENTITIES_SIZE						5			// units, player bullets, enemy bullets, lives, level
+#define TLM_I2C											0x03
+#define TLM_I2C_SIZE								10		// transfers u16, async u16, bytes u16, nacks u8, timeouts u8, max_us u16
+#define TLM_SCORE										0x04
+#define TLM_SCORE_SIZE							7			// score u32, points u16, unit type u8
+#define TLM_TRACE										0x05
+#define TLM_TRACE_SIZE							12		// message id u16, tick u16, arg0 u32, arg1 u32, see trace.h
+#define TLM_RECT										0x06	// LCD mirror pixels, see lcd_mirror.h
+#define TLM_RECT_HEADER_SIZE				10		// x0, x1, y0, y1, offset, all u16, then the runs
+#define TLM_STALE										0x07
+#define TLM_STALE_SIZE							10		// x0, x1, y0, y1, dropped records, all u16
+#define TLM_FAULT										0x08	// see fault.h
+#define TLM_FAULT_SIZE							60		// pc, lr, xpsr, sp, cfsr, hfsr, mmfar, bfar, r0-r3, r12, exc_return, state, all u32
+
+// Bytes that may be queued on UART0 per game frame (5 Timer A ticks).  A
+// frame with an I2C record is 47 bytes, what is left is for score events.
+// 80 bytes every 50ms is about 14% of the 115200 baud link.
+#define TELEMETRY_FRAME_BUDGET			80
+
+// An I2C record is sent every this many frames
+#define TELEMETRY_I2C_FRAMES				20
+
+// Timer A counts down in 2us steps from TIMER_TAILR_10MS_W_PRESCALE
+#define TELEMETRY_US_PER_COUNT			2
+
+// Entity counts sent once a frame
+typedef struct {
+	uint8_t units;									// active enemies
+	uint8_t player_bullets;
+	uint8_t enemy_bullets;
+	uint8_t lives;
+	uint8_t level;
+} tlm_entities_t;
+
+// Set false to stop the stream, records are then not built at all
+extern bool telemetry_enabled;
+
+//*****************************************************************************
+// Function Name: telemetry_tick_begin
+//*****************************************************************************
+//	Summary: Notes when a Timer A tick started being handled.  Call before the
+//					 tick handler, paired with telemetry_tick_end.
+//
+//*****************************************************************************
+void telemetry_tick_begin(void);
+
+//*****************************************************************************
+// Function Name: telemetry_tick_end
+//*****************************************************************************
+//	Summary: Adds the time since telemetry_tick_begin to the current frame.
+//					 overrun is true if the next tick was already due.
+//
+//*****************************************************************************
+void telemetry_tick_end(bool overrun);
+
+//*****************************************************************************
+// Function Name: telemetry_frame
+//*****************************************************************************
+//	Summary: Sends the frame timing and entity records for the ticks since the
+//					 last call, plus the I2C counters every TELEMETRY_I2C_FRAMES,
+//					 and starts a new frame budget
+//
+//*****************************************************************************
+void telemetry_frame(const tlm_entities_t *entities);
+
+//*****************************************************************************
+// Function Name: telemetry_score
+//*****************************************************************************
+//	Summary: Sends a score event for points scored by destroying a unit
+//
+//*****************************************************************************
+void telemetry_score(uint32_t score, uint16_t points, uint8_t unit_type);
+
+//*****************************************************************************
+// Function Name: telemetry_record
+//*****************************************************************************
+//	Summary: Sends one record outside the frame budget, waiting for room.
+//					 Pass polled as true when interrupts are off.
+//
+//*****************************************************************************
+void telemetry_record(uint8_t type, const uint8_t *payload, uint8_t len, bool polled);
+
+//*****************************************************************************
+// Function Name: telemetry_offer
+//*****************************************************************************
+//	Summary: Queues one record outside the frame budget if the TX ring still
+//					 has reserve bytes free after it.  Never waits.
+//
+//	Returns: false if the record was not queued
+//
+//*****************************************************************************
+bool telemetry_offer(uint8_t type, const uint8_t *payload, uint8_t len, uint32_t reserve);
+
+#endif
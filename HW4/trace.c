@@ -0,0 +1,122 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "TM4C123.h"
+#include "telemetry.h"
+#include "trace.h"
+
+trace_entry_t trace_ring[TRACE_DEPTH];
+volatile uint32_t trace_head = 0;
+
+static volatile uint16_t trace_ticks = 0;
+
+// Entries before this one have been dumped
+static uint32_t trace_dumped = 0;
+
+//*****************************************************************************
+// Function Name: trace_log
+//*****************************************************************************
+//	Summary: Only taking the slot needs interrupts off, an ISR that logs
+//					 while the slot is filled gets the next one
+//
+//*****************************************************************************
+void trace_log(uint16_t id, uint32_t arg0, uint32_t arg1){
+	trace_entry_t *entry;
+	uint32_t primask;
+	
+	primask = __get_PRIMASK();
+	__disable_irq();
+	entry = &trace_ring[trace_head++ & (TRACE_DEPTH - 1)];
+	__set_PRIMASK(primask);
+	
+	entry->id = id;
+	entry->tick = trace_ticks;
+	entry->arg[0] = arg0;
+	entry->arg[1] = arg1;
+}
+
+//*****************************************************************************
+// Function Name: trace_tick
+//*****************************************************************************
+//	Summary: Advances the trace timestamp, called from the Timer A ISR
+//
+//*****************************************************************************
+void trace_tick(void){
+	trace_ticks++;
+}
+
+//*****************************************************************************
+// Function Name: trace_send
+//*****************************************************************************
+//	Summary: Sends one entry as a TLM_TRACE record
+//
+//*****************************************************************************
+void trace_send(const trace_entry_t *entry, bool polled){
+	uint8_t payload[TLM_TRACE_SIZE];
+	int i;
+	
+	payload[0] = entry->id & 0xFF;
+	payload[1] = entry->id >> 8;
+	payload[2] = entry->tick & 0xFF;
+	payload[3] = entry->tick >> 8;
+	for(i = 0; i < 4; i++){
+		payload[4 + i] = entry->arg[0] >> (8 * i);
+		payload[8 + i] = entry->arg[1] >> (8 * i);
+	}
+	telemetry_record(TLM_TRACE, payload, TLM_TRACE_SIZE, polled);
+}
+
+//*****************************************************************************
+// Function Name: trace_dump
+//*****************************************************************************
+//	Summary: Sends the entries logged since the last dump as telemetry
+//					 records, oldest first.  Entries logged while the dump runs
+//					 are left for the next one.
+//
+//*****************************************************************************
+void trace_dump(bool polled){
+	trace_entry_t lost = { TRACE_OVERWRITTEN, 0, { 0, 0 } };
+	uint32_t end = trace_head;
+	
+	if(end - trace_dumped > TRACE_DEPTH){
+		lost.tick = trace_ring[end & (TRACE_DEPTH - 1)].tick;
+		lost.arg[0] = end - trace_dumped - TRACE_DEPTH;
+		trace_send(&lost, polled);
+		trace_dumped = end - TRACE_DEPTH;
+	}
+	while(trace_dumped != end){
+		trace_send(&trace_ring[trace_dumped & (TRACE_DEPTH - 1)], polled);
+		trace_dumped++;
+	}
+}
+
+//*****************************************************************************
+// Function Name: trace_rewind
+//*****************************************************************************
+//	Summary: The oldest entry still in the ring is TRACE_DEPTH behind the
+//					 head, or the first one ever logged
+//
+//*****************************************************************************
+void trace_rewind(void){
+	uint32_t end = trace_head;
+	
+	trace_dumped = (end > TRACE_DEPTH) ? end - TRACE_DEPTH : 0;
+}
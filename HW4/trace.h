@@ -0,0 +1,103 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DEFINE TRACE VARS ==========================================================
+// Entries kept in RAM, the oldest is overwritten.  Must be a power of 2.
+#define TRACE_DEPTH									128
+
+// Message IDs, one per line of trace_msgs.h
+typedef enum {
+#define TRACE_MSG(name, format)	TRACE_##name,
+#include "trace_msgs.h"
+#undef TRACE_MSG
+	TRACE_NUM_MSGS
+} trace_id_t;
+
+// One logged message.  tick counts Timer A interrupts (10ms).
+typedef struct {
+	uint16_t id;
+	uint16_t tick;
+	uint32_t arg[2];
+} trace_entry_t;
+
+// The ring stays readable from a debugger or a fault handler.  trace_head
+// counts every entry ever logged, the newest is trace_head - 1.
+extern trace_entry_t trace_ring[TRACE_DEPTH];
+extern volatile uint32_t trace_head;
+
+// Log a message from trace_msgs.h by name, from any context
+#define TRACE(name)								trace_log(TRACE_##name, 0, 0)
+#define TRACE1(name, a)						trace_log(TRACE_##name, (uint32_t)(a), 0)
+#define TRACE2(name, a, b)				trace_log(TRACE_##name, (uint32_t)(a), (uint32_t)(b))
+
+//*****************************************************************************
+// Function Name: trace_log
+//*****************************************************************************
+//	Summary: Stores a message ID and its arguments in the trace ring.  No
+//					 formatting is done on the target, so it is cheap enough for
+//					 ISRs and the game loop.  Use the TRACE macros.
+//
+//*****************************************************************************
+void trace_log(uint16_t id, uint32_t arg0, uint32_t arg1);
+
+//*****************************************************************************
+// Function Name: trace_tick
+//*****************************************************************************
+//	Summary: Advances the trace timestamp, called from the Timer A ISR
+//
+//*****************************************************************************
+void trace_tick(void);
+
+//*****************************************************************************
+// Function Name: trace_send
+//*****************************************************************************
+//	Summary: Sends one entry as a TLM_TRACE record, such as a copy saved with
+//					 a fault
+//
+//*****************************************************************************
+void trace_send(const trace_entry_t *entry, bool polled);
+
+//*****************************************************************************
+// Function Name: trace_dump
+//*****************************************************************************
+//	Summary: Sends the entries logged since the last dump as telemetry
+//					 records, oldest first.  Pass polled as true when interrupts
+//					 are off, such as from a fault handler.
+//
+//*****************************************************************************
+void trace_dump(bool polled);
+
+//*****************************************************************************
+// Function Name: trace_rewind
+//*****************************************************************************
+//	Summary: Makes the next trace_dump send every entry still in the ring,
+//					 including those an earlier dump already sent
+//
+//*****************************************************************************
+void trace_rewind(void);
+
+#endif
@@ -0,0 +1,44 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Trace message table, included once per use with TRACE_MSG defined.
+//
+//   TRACE_MSG(name, format)
+//
+// The target only sees the names, as TRACE_<name> IDs from trace.h, and
+// logs the ID with up to two 32-bit arguments.  The format strings are only
+// compiled into tools/telemetry_decode.c, which expands them on the host.
+// Formats may use %u, %d and %x.  Add new messages at the end so the IDs in
+// a saved log still decode.
+
+TRACE_MSG(BOOT,							"boot")
+TRACE_MSG(OVERWRITTEN,			"%u trace entries overwritten before this dump")
+TRACE_MSG(STATE,						"state %u -> %u")
+TRACE_MSG(TICK_OVERRUN,			"Timer A tick overran, counter %u")
+TRACE_MSG(GPIOF_IRQ,				"GPIOF interrupt, MIS 0x%x")
+TRACE_MSG(PEXP_READ_FAIL,		"port expander read failed, status %u")
+TRACE_MSG(I2C_STALL,				"input reads stalled, I2C queue aborted")
+TRACE_MSG(I2C_RECOVER,			"I2C bus recovered, status %u")
+TRACE_MSG(ENEMY_HIT,				"unit %u hit, health %d")
+TRACE_MSG(PLAYER_HIT,				"player hit by enemy bullet %u, health %d")
+TRACE_MSG(LEVEL_UP,					"level %u")
+TRACE_MSG(HS_SUBMIT,				"high score %u entered at rank %u")
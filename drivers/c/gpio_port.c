@@ -399,8 +399,18 @@ bool  gpio_config_falling_edge_irq(uint32_t gpioBase, uint8_t pins)
 	// using the verify_base_addr function provided above
 	if(verify_base_addr(gpioBase)){
 		gpioPort = (GPIOA_Type *)gpioBase;
+		
+		// Mask the pins while the sense is changed so no false edge is latched
+		gpioPort->IM &= ~pins;
+		
+		// Edge sensitive, single edge, falling
+		gpioPort->IS &= ~pins;
 		gpioPort->IBE &= ~pins;
 		gpioPort->IEV &= ~pins;
+		
+		// Clear anything that was latched and then unmask the pins
+		gpioPort->ICR = pins;
+		gpioPort->IM |= pins;
 		return true;
 	}
 	return false;
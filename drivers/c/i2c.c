@@ -1,6 +1,120 @@
+#include <string.h>
 #include "i2c.h"
 #include "driver_defines.h"
 
+// State of the asynchronous engine for one I2C peripheral
+typedef struct {
+  i2c_xfer_t * volatile head;   // transaction on the bus
+  i2c_xfer_t * volatile tail;
+  uint8_t               index;  // next byte of the current phase
+  bool                  reading;
+  bool                  stopping; // a STOP after a NACK is still going out
+  volatile bool         stuck;  // a wait timed out, see i2cBusRecover
+  uint32_t              start;  // clock when head was started
+  i2c_stats_t           stats;
+} i2c_engine_t;
+
+// Indexed by I2C peripheral number.  The bases are 0x1000 apart.
+static i2c_engine_t i2c_engines[4];
+
+// Timebase for the stats, NULL if transactions are not timed
+static i2c_clock_t i2c_clock = NULL;
+
+static i2c_engine_t *i2c_get_engine(uint32_t base_addr)
+{
+  return &i2c_engines[(base_addr - I2C0_BASE) >> 12];
+}
+
+static uint32_t i2c_now(void)
+{
+  return (i2c_clock != NULL) ? i2c_clock() : 0;
+}
+
+//*****************************************************************************
+// Adds one finished transaction to the stats
+//*****************************************************************************
+static void i2c_stats_add(
+  i2c_stats_t *stats, 
+  uint32_t start, 
+  uint32_t wr_len, 
+  uint32_t rd_len, 
+  i2c_status_t status
+)
+{
+  uint32_t ticks = i2c_now() - start;
+  
+  stats->ticks += ticks;
+  if ( ticks > stats->max_ticks )
+  {
+    stats->max_ticks = ticks;
+  }
+  
+  if ( status == I2C_OK )
+  {
+    stats->bytes_written += wr_len;
+    stats->bytes_read += rd_len;
+  }
+  else if ( status == I2C_NO_ACK )
+  {
+    stats->nacks++;
+  }
+  else if ( status == I2C_TIMEOUT )
+  {
+    stats->timeouts++;
+  }
+}
+
+static IRQn_Type i2c_get_irq_num(uint32_t base_addr)
+{
+  switch (base_addr)
+  {
+    case I2C0_BASE: return I2C0_IRQn;
+    case I2C1_BASE: return I2C1_IRQn;
+    case I2C2_BASE: return I2C2_IRQn;
+    default:        return I2C3_IRQn;
+  }
+}
+
+//*****************************************************************************
+// Waits for the master to finish the current byte.  A slave that stretches
+// SCL forever would otherwise hang the caller, so the wait gives up after
+// I2C_WAIT_POLLS and flags the bus as stuck.
+//*****************************************************************************
+static bool i2c_wait_busy(uint32_t i2c_base)
+{
+  i2c_engine_t *engine = i2c_get_engine(i2c_base);
+  uint32_t polls = I2C_WAIT_POLLS;
+  
+  while ( I2CMasterBusy(i2c_base))
+  {
+    engine->stats.wait_polls++;
+    if ( --polls == 0 )
+    {
+      engine->stuck = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+//*****************************************************************************
+// Waits for the asynchronous queue to drain, aborting it if it does not
+//*****************************************************************************
+static bool i2c_wait_async(uint32_t i2c_base)
+{
+  uint32_t polls = I2C_WAIT_POLLS;
+  
+  while ( !i2cAsyncIdle(i2c_base))
+  {
+    if ( --polls == 0 )
+    {
+      i2cAsyncAbort(i2c_base);
+      return false;
+    }
+  }
+  return true;
+}
+
 //*****************************************************************************
 // Initializes a given I2C peripheral to operate at 100KHz.  This assumes
 // MCU core is running at 50MHz
@@ -52,6 +166,11 @@ i2c_status_t initializeI2CMaster(uint32_t base_addr)
     //myI2C->MTPR = 0x18;
     myI2C->MTPR = 0x06;
     
+    // The master interrupt is only unmasked while async transactions run
+    myI2C->MIMR = 0;
+    myI2C->MICR = I2C_MICR_IC;
+    NVIC_SetPriority(i2c_get_irq_num(base_addr), 1);
+    NVIC_EnableIRQ(i2c_get_irq_num(base_addr));
     
     return I2C_OK;
 }
@@ -106,6 +225,13 @@ i2c_status_t i2cSetSlaveAddr(
   
   myI2C = (I2C0_Type *) baseAddr;
   
+  // Every blocking transaction starts here.  Let queued transactions finish
+  // before taking the bus.
+  if ( !i2c_wait_async(baseAddr))
+  {
+    return I2C_TIMEOUT;
+  }
+  
   // Set the slave address to transmit data
    myI2C->MSA = (slaveAddr << 1) | readWrite;
   //myI2C->MSA = slaveAddr | readWrite;
@@ -293,7 +419,10 @@ i2c_status_t i2cSendByte(
   myI2C->MCS = mcs;
   
   // Wait for the device to be free
-  while ( I2CMasterBusy(baseAddr)) {};
+  if ( !i2c_wait_busy(baseAddr))
+  {
+    return I2C_TIMEOUT;
+  }
   
     // Check for error conditions
   if ( myI2C->MCS & (I2C_MCS_ERROR | I2C_MCS_ARBLST) )
@@ -366,7 +495,10 @@ i2c_status_t i2cGetByte(
   myI2C->MCS = mcs;
   
   // Wait for the device to be free
-  while ( I2CMasterBusy(baseAddr)) {};
+  if ( !i2c_wait_busy(baseAddr))
+  {
+    return I2C_TIMEOUT;
+  }
   
   // Check for error conditions
   if ( myI2C->MCS & I2C_MCS_ERROR  )
@@ -380,3 +512,585 @@ i2c_status_t i2cGetByte(
     return I2C_OK;
   }
 }
+
+//*****************************************************************************
+// Runs one byte of a blocking transaction and checks the result.  On a NACK
+// the bus is released with a STOP.
+//*****************************************************************************
+static i2c_status_t i2c_run_byte(uint32_t i2c_base, uint8_t mcs)
+{
+  I2C0_Type *myI2C = (I2C0_Type *) i2c_base;
+  uint32_t status;
+  
+  myI2C->MCS = mcs;
+  if ( !i2c_wait_busy(i2c_base))
+  {
+    return I2C_TIMEOUT;
+  }
+  
+  status = myI2C->MCS;
+  if ( status & I2C_MCS_ARBLST )
+  {
+    return I2C_ARBLST;
+  }
+  if ( status & I2C_MCS_ERROR )
+  {
+    if ( (mcs & I2C_MCS_STOP) == 0 )
+    {
+      myI2C->MCS = I2C_MCS_STOP;
+      i2c_wait_busy(i2c_base);
+    }
+    return I2C_NO_ACK;
+  }
+  return I2C_OK;
+}
+
+//*****************************************************************************
+// Write then repeated START read, blocking.  Arguments are checked by
+// i2c_transfer.
+//*****************************************************************************
+static i2c_status_t i2c_transfer_run(
+  uint32_t i2c_base,
+  uint8_t dev_id,
+  const uint8_t *wr_data,
+  uint8_t wr_len,
+  uint8_t *rd_data,
+  uint8_t rd_len
+)
+{
+  I2C0_Type *myI2C;
+  i2c_status_t status;
+  uint8_t mcs;
+  int i;
+  
+  myI2C = (I2C0_Type *) i2c_base;
+  
+  // Let queued transactions finish before taking the bus
+  if ( !i2c_wait_async(i2c_base) || !i2c_wait_busy(i2c_base))
+  {
+    return I2C_TIMEOUT;
+  }
+  
+  //==============================================================
+  // Write phase
+  //==============================================================
+  if ( wr_len > 0 )
+  {
+    myI2C->MSA = (dev_id << 1) | I2C_WRITE;
+  }
+  for ( i = 0; i < wr_len; i++ )
+  {
+    myI2C->MDR = wr_data[i];
+    
+    mcs = I2C_MCS_RUN;
+    if ( i == 0 )                          mcs |= I2C_MCS_START;
+    if ( i == wr_len - 1 && rd_len == 0 )  mcs |= I2C_MCS_STOP;
+    
+    status = i2c_run_byte(i2c_base, mcs);
+    if ( status != I2C_OK )
+    {
+      return status;
+    }
+  }
+  
+  //==============================================================
+  // Read phase, the START here is a repeated START if bytes were written
+  //==============================================================
+  if ( rd_len > 0 )
+  {
+    myI2C->MSA = (dev_id << 1) | I2C_READ;
+  }
+  for ( i = 0; i < rd_len; i++ )
+  {
+    mcs = I2C_MCS_RUN;
+    if ( i == 0 )           mcs |= I2C_MCS_START;
+    if ( i == rd_len - 1 )  mcs |= I2C_MCS_STOP;
+    else                    mcs |= I2C_MCS_ACK;
+    
+    status = i2c_run_byte(i2c_base, mcs);
+    if ( status != I2C_OK )
+    {
+      return status;
+    }
+    rd_data[i] = myI2C->MDR;
+  }
+  
+  return I2C_OK;
+}
+
+//*****************************************************************************
+// Write then repeated START read, blocking
+//*****************************************************************************
+i2c_status_t i2c_transfer(
+  uint32_t i2c_base,
+  uint8_t dev_id,
+  const uint8_t *wr_data,
+  uint8_t wr_len,
+  uint8_t *rd_data,
+  uint8_t rd_len
+)
+{
+  i2c_engine_t *engine;
+  i2c_status_t status;
+  uint32_t start;
+  
+  if( i2cVerifyBaseAddr(i2c_base) == false)
+  {
+    return I2C_INVALID_BASE;
+  }
+  if ( (wr_len > 0 && wr_data == NULL) || (rd_len > 0 && rd_data == NULL) )
+  {
+    return I2C_NULL_PTR;
+  }
+  if ( wr_len == 0 && rd_len == 0 )
+  {
+    return I2C_INVALID_PARAM;
+  }
+  
+  engine = i2c_get_engine(i2c_base);
+  start = i2c_now();
+  status = i2c_transfer_run(i2c_base, dev_id, wr_data, wr_len, rd_data, rd_len);
+  
+  engine->stats.transfers++;
+  i2c_stats_add(&engine->stats, start, wr_len, rd_len, status);
+  return status;
+}
+
+//*****************************************************************************
+// Starts the transaction at the head of the queue
+//*****************************************************************************
+static void i2c_start_xfer(I2C0_Type *myI2C, i2c_engine_t *engine)
+{
+  i2c_xfer_t *xfer = engine->head;
+  
+  engine->index = 0;
+  engine->stopping = false;
+  engine->start = i2c_now();
+  myI2C->MICR = I2C_MICR_IC;
+  myI2C->MIMR = I2C_MIMR_IM;
+  
+  if (xfer->wr_len > 0)
+  {
+    engine->reading = false;
+    myI2C->MSA = (xfer->dev_id << 1) | I2C_WRITE;
+    myI2C->MDR = xfer->wr_data[0];
+    myI2C->MCS = I2C_MCS_START | I2C_MCS_RUN | 
+                 ((xfer->wr_len == 1 && xfer->rd_len == 0) ? I2C_MCS_STOP : 0);
+  }
+  else
+  {
+    engine->reading = true;
+    myI2C->MSA = (xfer->dev_id << 1) | I2C_READ;
+    myI2C->MCS = I2C_MCS_START | I2C_MCS_RUN | 
+                 ((xfer->rd_len == 1) ? I2C_MCS_STOP : I2C_MCS_ACK);
+  }
+}
+
+//*****************************************************************************
+// Retires the transaction at the head of the queue and starts the next one
+//*****************************************************************************
+static void i2c_finish_xfer(I2C0_Type *myI2C, i2c_engine_t *engine, i2c_status_t status)
+{
+  i2c_xfer_t *xfer = engine->head;
+  bool pending;
+  
+  engine->head = xfer->next;
+  pending = (engine->head != NULL);
+  if (!pending)
+  {
+    engine->tail = NULL;
+    myI2C->MIMR = 0;
+  }
+  
+  engine->stats.async_xfers++;
+  i2c_stats_add(&engine->stats, engine->start, xfer->wr_len, xfer->rd_len, status);
+  
+  xfer->status = status;
+  xfer->done = true;
+  if (xfer->callback != NULL)
+  {
+    xfer->callback(xfer);
+  }
+  
+  // If the queue had emptied, anything the callback submitted has already
+  // been started by i2cSubmit
+  if (pending)
+  {
+    i2c_start_xfer(myI2C, engine);
+  }
+}
+
+//*****************************************************************************
+// Queues an asynchronous transaction
+//*****************************************************************************
+i2c_status_t i2cSubmit(
+  uint32_t i2c_base,
+  i2c_xfer_t *xfer
+)
+{
+  i2c_engine_t *engine;
+  bool start;
+  
+  if( i2cVerifyBaseAddr(i2c_base) == false)
+  {
+    return I2C_INVALID_BASE;
+  }
+  if ( xfer == NULL || 
+      (xfer->wr_len > 0 && xfer->wr_data == NULL) ||
+      (xfer->rd_len > 0 && xfer->rd_data == NULL))
+  {
+    return I2C_NULL_PTR;
+  }
+  
+  engine = i2c_get_engine(i2c_base);
+  
+  xfer->next = NULL;
+  xfer->done = false;
+  xfer->status = I2C_OK;
+  
+  // Nothing to put on the bus
+  if (xfer->wr_len == 0 && xfer->rd_len == 0)
+  {
+    xfer->done = true;
+    if (xfer->callback != NULL)
+    {
+      xfer->callback(xfer);
+    }
+    return I2C_OK;
+  }
+  
+  // The ISR also edits the queue
+  NVIC_DisableIRQ(i2c_get_irq_num(i2c_base));
+  start = (engine->head == NULL);
+  if (start)
+  {
+    engine->head = xfer;
+  }
+  else
+  {
+    engine->tail->next = xfer;
+  }
+  engine->tail = xfer;
+  NVIC_EnableIRQ(i2c_get_irq_num(i2c_base));
+  
+  if (start)
+  {
+    // A blocking transaction may still be finishing its STOP
+    if ( !i2c_wait_busy(i2c_base))
+    {
+      i2cAsyncAbort(i2c_base);
+      return I2C_TIMEOUT;
+    }
+    i2c_start_xfer((I2C0_Type *)i2c_base, engine);
+  }
+  
+  return I2C_OK;
+}
+
+//*****************************************************************************
+// Returns true if no asynchronous transactions are queued or running
+//*****************************************************************************
+bool
+i2cAsyncIdle(
+  uint32_t i2c_base
+)
+{
+  if( i2cVerifyBaseAddr(i2c_base) == false)
+  {
+    return true;
+  }
+  return i2c_get_engine(i2c_base)->head == NULL;
+}
+
+//*****************************************************************************
+// Takes the whole queue away from the ISR and returns it
+//*****************************************************************************
+static i2c_xfer_t *i2c_take_queue(uint32_t i2c_base)
+{
+  I2C0_Type *myI2C = (I2C0_Type *) i2c_base;
+  i2c_engine_t *engine = i2c_get_engine(i2c_base);
+  i2c_xfer_t *xfer;
+  
+  NVIC_DisableIRQ(i2c_get_irq_num(i2c_base));
+  myI2C->MIMR = 0;
+  myI2C->MICR = I2C_MICR_IC;
+  xfer = engine->head;
+  engine->head = NULL;
+  engine->tail = NULL;
+  engine->stopping = false;
+  engine->stuck = true;
+  NVIC_EnableIRQ(i2c_get_irq_num(i2c_base));
+  
+  return xfer;
+}
+
+//*****************************************************************************
+// Fails every queued transaction with I2C_TIMEOUT
+//*****************************************************************************
+void
+i2cAsyncAbort(
+  uint32_t i2c_base
+)
+{
+  i2c_xfer_t *xfer;
+  
+  if( i2cVerifyBaseAddr(i2c_base) == false)
+  {
+    return;
+  }
+  
+  // The queue is taken before running the callbacks, which may submit again
+  xfer = i2c_take_queue(i2c_base);
+  while (xfer != NULL)
+  {
+    i2c_xfer_t *next = xfer->next;
+    
+    xfer->status = I2C_TIMEOUT;
+    xfer->done = true;
+    if (xfer->callback != NULL)
+    {
+      xfer->callback(xfer);
+    }
+    xfer = next;
+  }
+}
+
+//*****************************************************************************
+// Empties the queue without running any callbacks
+//*****************************************************************************
+void
+i2cAsyncDrop(
+  uint32_t i2c_base
+)
+{
+  if( i2cVerifyBaseAddr(i2c_base) == false)
+  {
+    return;
+  }
+  i2c_take_queue(i2c_base);
+}
+
+//*****************************************************************************
+// Returns true if a wait has timed out since the last recovery
+//*****************************************************************************
+bool
+i2cBusStuck(
+  uint32_t i2c_base
+)
+{
+  if( i2cVerifyBaseAddr(i2c_base) == false)
+  {
+    return false;
+  }
+  return i2c_get_engine(i2c_base)->stuck;
+}
+
+//*****************************************************************************
+// Returns the transaction counters of a peripheral
+//*****************************************************************************
+const i2c_stats_t *
+i2cGetStats(
+  uint32_t i2c_base
+)
+{
+  if( i2cVerifyBaseAddr(i2c_base) == false)
+  {
+    return NULL;
+  }
+  return &i2c_get_engine(i2c_base)->stats;
+}
+
+//*****************************************************************************
+// Clears the transaction counters of a peripheral
+//*****************************************************************************
+void
+i2cStatsReset(
+  uint32_t i2c_base
+)
+{
+  i2c_stats_t *stats;
+  
+  if( i2cVerifyBaseAddr(i2c_base) == false)
+  {
+    return;
+  }
+  stats = &i2c_get_engine(i2c_base)->stats;
+  
+  NVIC_DisableIRQ(i2c_get_irq_num(i2c_base));
+  memset(stats, 0, sizeof(i2c_stats_t));
+  NVIC_EnableIRQ(i2c_get_irq_num(i2c_base));
+}
+
+//*****************************************************************************
+// Sets the clock used to time transactions
+//*****************************************************************************
+void
+i2cStatsSetClock(
+  i2c_clock_t now
+)
+{
+  i2c_clock = now;
+}
+
+//*****************************************************************************
+// Roughly half an SCL period at 100KHz
+//*****************************************************************************
+static void i2c_recover_delay(void)
+{
+  volatile int i;
+  
+  for ( i = 0; i < 100; i++ ) {};
+}
+
+//*****************************************************************************
+// Clocks a stuck slave off the bus and reinitializes the peripheral
+//*****************************************************************************
+i2c_status_t i2cBusRecover(
+  uint32_t i2c_base,
+  uint32_t gpio_base,
+  uint8_t scl_pin,
+  uint8_t sda_pin
+)
+{
+  I2C0_Type *myI2C;
+  GPIOA_Type *gpioPort;
+  bool released;
+  int i;
+  
+  if( i2cVerifyBaseAddr(i2c_base) == false)
+  {
+    return I2C_INVALID_BASE;
+  }
+  myI2C = (I2C0_Type *) i2c_base;
+  gpioPort = (GPIOA_Type *) gpio_base;
+  
+  i2cAsyncAbort(i2c_base);
+  myI2C->MCR = 0;
+  
+  // Drive both lines by hand.  SCL becomes open drain like SDA, and both
+  // are released high to start with.
+  gpioPort->DATA |= scl_pin | sda_pin;
+  gpioPort->ODR |= scl_pin | sda_pin;
+  gpioPort->DIR |= scl_pin | sda_pin;
+  gpioPort->AFSEL &= ~(scl_pin | sda_pin);
+  i2c_recover_delay();
+  
+  // A slave part way through a read lets go of SDA within 9 clocks
+  for ( i = 0; i < 9 && (gpioPort->DATA & sda_pin) == 0; i++ )
+  {
+    gpioPort->DATA &= ~scl_pin;
+    i2c_recover_delay();
+    gpioPort->DATA |= scl_pin;
+    i2c_recover_delay();
+  }
+  
+  // STOP: SDA rises while SCL is high
+  gpioPort->DATA &= ~scl_pin;
+  i2c_recover_delay();
+  gpioPort->DATA &= ~sda_pin;
+  i2c_recover_delay();
+  gpioPort->DATA |= scl_pin;
+  i2c_recover_delay();
+  gpioPort->DATA |= sda_pin;
+  i2c_recover_delay();
+  released = (gpioPort->DATA & sda_pin) != 0;
+  
+  // Hand the pins back to the peripheral, SCL is push-pull again
+  gpioPort->ODR &= ~scl_pin;
+  gpioPort->AFSEL |= scl_pin | sda_pin;
+  initializeI2CMaster(i2c_base);
+  i2c_get_engine(i2c_base)->stuck = false;
+  
+  return released ? I2C_OK : I2C_BUS_ERROR;
+}
+
+//*****************************************************************************
+// Moves the current asynchronous transaction along by one byte
+//*****************************************************************************
+static void i2c_async_isr(uint32_t i2c_base)
+{
+  I2C0_Type *myI2C = (I2C0_Type *) i2c_base;
+  i2c_engine_t *engine = i2c_get_engine(i2c_base);
+  i2c_xfer_t *xfer = engine->head;
+  uint32_t mcs;
+  
+  myI2C->MICR = I2C_MICR_IC;
+  
+  // Left over from a blocking transaction
+  if (xfer == NULL)
+  {
+    return;
+  }
+  
+  // The STOP that released the bus after a NACK has gone out, so the
+  // next transaction can start
+  if (engine->stopping)
+  {
+    engine->stopping = false;
+    i2c_finish_xfer(myI2C, engine, I2C_NO_ACK);
+    return;
+  }
+  
+  mcs = myI2C->MCS;
+  if (mcs & I2C_MCS_ERROR)
+  {
+    if (mcs & I2C_MCS_ARBLST)
+    {
+      i2c_finish_xfer(myI2C, engine, I2C_ARBLST);
+    }
+    else
+    {
+      // Address or data NACK.  Release the bus and finish on the interrupt
+      // the STOP raises instead of waiting for it here.
+      myI2C->MCS = I2C_MCS_STOP;
+      engine->stopping = true;
+    }
+    return;
+  }
+  
+  if (!engine->reading)
+  {
+    engine->index++;
+    if (engine->index < xfer->wr_len)
+    {
+      myI2C->MDR = xfer->wr_data[engine->index];
+      myI2C->MCS = I2C_MCS_RUN | 
+                   ((engine->index == xfer->wr_len - 1 && xfer->rd_len == 0) ? I2C_MCS_STOP : 0);
+    }
+    else if (xfer->rd_len > 0)
+    {
+      // Repeated START into the read phase
+      engine->reading = true;
+      engine->index = 0;
+      myI2C->MSA = (xfer->dev_id << 1) | I2C_READ;
+      myI2C->MCS = I2C_MCS_START | I2C_MCS_RUN | 
+                   ((xfer->rd_len == 1) ? I2C_MCS_STOP : I2C_MCS_ACK);
+    }
+    else
+    {
+      i2c_finish_xfer(myI2C, engine, I2C_OK);
+    }
+  }
+  else
+  {
+    xfer->rd_data[engine->index++] = myI2C->MDR;
+    if (engine->index < xfer->rd_len)
+    {
+      // NACK the last byte so the slave lets go of SDA
+      myI2C->MCS = I2C_MCS_RUN | 
+                   ((engine->index == xfer->rd_len - 1) ? I2C_MCS_STOP : I2C_MCS_ACK);
+    }
+    else
+    {
+      i2c_finish_xfer(myI2C, engine, I2C_OK);
+    }
+  }
+}
+
+//*****************************************************************************
+// I2C1 is the board's shared bus (touch, port expander and EEPROM)
+//*****************************************************************************
+void I2C1_Handler(void)
+{
+  i2c_async_isr(I2C1_BASE);
+}
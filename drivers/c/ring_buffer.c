@@ -0,0 +1,131 @@
+// Copyright (c) 2015, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include <string.h>
+#include "ring_buffer.h"
+
+//*****************************************************************************
+// Adds one element
+//*****************************************************************************
+bool ring_push(ring_t *ring, const void *elem)
+{
+	return ring_push_bulk(ring, elem, 1) == 1;
+}
+
+//*****************************************************************************
+// Removes the oldest element
+//*****************************************************************************
+bool ring_pop(ring_t *ring, void *elem)
+{
+	return ring_pop_bulk(ring, elem, 1) == 1;
+}
+
+//*****************************************************************************
+// Copies into the free space after head.  It wraps at most once, so the copy
+// is split in two at the end of the array.
+//*****************************************************************************
+uint32_t ring_push_bulk(ring_t *ring, const void *elems, uint32_t count)
+{
+	uint32_t head = ring->head;
+	uint32_t space = ring->mask + 1 - (head - ring->tail);
+	uint32_t index = head & ring->mask;
+	uint32_t first;
+	
+	if(count > space) count = space;
+	if(count == 0) return 0;
+	
+	first = ring->mask + 1 - index;
+	if(first > count) first = count;
+	
+	memcpy(ring->array + index * ring->elem_size, elems, first * ring->elem_size);
+	memcpy(ring->array, (const uint8_t *)elems + first * ring->elem_size, (count - first) * ring->elem_size);
+	
+	// The consumer must not see the new head before the data
+	__DMB();
+	ring->head = head + count;
+	return count;
+}
+
+//*****************************************************************************
+// Copies out of the used space after tail, split in two at the end of the
+// array
+//*****************************************************************************
+uint32_t ring_pop_bulk(ring_t *ring, void *elems, uint32_t count)
+{
+	uint32_t tail = ring->tail;
+	uint32_t used = ring->head - tail;
+	uint32_t index = tail & ring->mask;
+	uint32_t first;
+	
+	if(count > used) count = used;
+	if(count == 0) return 0;
+	
+	// Read head before the data it covers
+	__DMB();
+	first = ring->mask + 1 - index;
+	if(first > count) first = count;
+	
+	memcpy(elems, ring->array + index * ring->elem_size, first * ring->elem_size);
+	memcpy((uint8_t *)elems + first * ring->elem_size, ring->array, (count - first) * ring->elem_size);
+	
+	// The producer must not reuse the slots before they have been read
+	__DMB();
+	ring->tail = tail + count;
+	return count;
+}
+
+//*****************************************************************************
+// Returns the used elements from tail up to head or the end of the array,
+// whichever comes first
+//*****************************************************************************
+uint32_t ring_read_span(ring_t *ring, const void **span)
+{
+	return ring_peek_span(ring, 0, span);
+}
+
+//*****************************************************************************
+// Same, from offset elements past tail
+//*****************************************************************************
+uint32_t ring_peek_span(ring_t *ring, uint32_t offset, const void **span)
+{
+	// head is read once and used for both the bounds check and used.
+	// Re-reading it for the check could let a concurrent push pass the
+	// check while used comes from the stale value.
+	uint32_t head = ring->head;
+	uint32_t tail = ring->tail + offset;
+	uint32_t used = head - tail;
+	uint32_t index = tail & ring->mask;
+	
+	__DMB();
+	*span = ring->array + index * ring->elem_size;
+	if(offset > head - ring->tail) return 0;
+	if(used > ring->mask + 1 - index) used = ring->mask + 1 - index;
+	return used;
+}
+
+//*****************************************************************************
+// Releases elements returned by ring_read_span
+//*****************************************************************************
+void ring_consume(ring_t *ring, uint32_t count)
+{
+	__DMB();
+	ring->tail += count;
+}
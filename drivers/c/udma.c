@@ -0,0 +1,98 @@
+#include "udma.h"
+
+// Primary structures for every channel, then the alternates.  The
+// controller needs the table on a 1KB boundary.
+#if defined(__CC_ARM)
+static __align(1024) udma_entry_t udma_table[2 * UDMA_NUM_CHANNELS];
+#else
+static udma_entry_t udma_table[2 * UDMA_NUM_CHANNELS] __attribute__((aligned(1024)));
+#endif
+
+static udma_entry_t *udma_get_entry(uint8_t channel, bool alt)
+{
+  return &udma_table[channel + (alt ? UDMA_NUM_CHANNELS : 0)];
+}
+
+//*****************************************************************************
+// Clocks the controller, waits for it to come out of reset and enables it
+//*****************************************************************************
+void udma_init(void)
+{
+  SYSCTL->RCGCDMA |= SYSCTL_RCGCDMA_R0;
+  while ( (SYSCTL->PRDMA & SYSCTL_PRDMA_R0) == 0 )
+  {
+  }
+  
+  UDMA->CFG = UDMA_CFG_MASTEN;
+  UDMA->CTLBASE = (uint32_t)udma_table;
+}
+
+//*****************************************************************************
+// Each CHMAP register holds the encodings of 8 channels, 4 bits apiece
+//*****************************************************************************
+void udma_assign(uint8_t channel, uint8_t encoding)
+{
+  volatile uint32_t *chmap = &UDMA->CHMAP0 + (channel >> 3);
+  uint32_t shift = (channel & 0x7) * 4;
+  uint32_t mask = 1UL << channel;
+  
+  *chmap = (*chmap & ~(0xFUL << shift)) | ((uint32_t)encoding << shift);
+  
+  UDMA->ENACLR = mask;
+  UDMA->USEBURSTCLR = mask;
+  UDMA->REQMASKCLR = mask;
+  UDMA->ALTCLR = mask;
+  UDMA->PRIOCLR = mask;
+}
+
+//*****************************************************************************
+// Byte source that increments, fixed byte destination, arbitrate every 4
+// bytes so the UART's burst and single requests both work
+//*****************************************************************************
+void udma_arm_tx(uint8_t channel, bool alt, const void *src, volatile void *dst, uint32_t len)
+{
+  udma_entry_t *entry = udma_get_entry(channel, alt);
+  
+  entry->src_end = (const uint8_t *)src + len - 1;
+  entry->dst_end = dst;
+  entry->control = UDMA_CHCTL_DSTINC_NONE | UDMA_CHCTL_DSTSIZE_8 |
+                   UDMA_CHCTL_SRCINC_8 | UDMA_CHCTL_SRCSIZE_8 |
+                   UDMA_CHCTL_ARBSIZE_4 |
+                   ((len - 1) << UDMA_CHCTL_XFERSIZE_S) |
+                   UDMA_CHCTL_XFERMODE_PINGPONG;
+}
+
+void udma_start(uint8_t channel, bool alt)
+{
+  if ( alt )
+  {
+    UDMA->ALTSET = 1UL << channel;
+  }
+  else
+  {
+    UDMA->ALTCLR = 1UL << channel;
+  }
+  UDMA->ENASET = 1UL << channel;
+}
+
+bool udma_enabled(uint8_t channel)
+{
+  return (UDMA->ENASET & (1UL << channel)) != 0;
+}
+
+bool udma_stopped(uint8_t channel, bool alt)
+{
+  udma_entry_t *entry = udma_get_entry(channel, alt);
+  
+  return (entry->control & UDMA_CHCTL_XFERMODE_M) == UDMA_CHCTL_XFERMODE_STOP;
+}
+
+bool udma_irq_clear(uint8_t channel)
+{
+  if ( (UDMA->CHIS & (1UL << channel)) == 0 )
+  {
+    return false;
+  }
+  UDMA->CHIS = 1UL << channel;
+  return true;
+}
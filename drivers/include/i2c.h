@@ -20,9 +20,14 @@ typedef enum {
   I2C_ACK_RXED,
   I2C_NO_ACK,
   I2C_INVALID_BASE,
-  I2C_INVALID_PARAM
+  I2C_INVALID_PARAM,
+  I2C_TIMEOUT
 } i2c_status_t;
 
+// Polls of the busy flag before a blocking wait gives up and returns
+// I2C_TIMEOUT, about 20ms at 50MHz.  One byte at 100KHz takes 90us.
+#define I2C_WAIT_POLLS  100000
+
 typedef enum {
   I2C_READ  = I2C_MSA_RX,
   I2C_WRITE = I2C_MSA_TX
@@ -33,6 +38,81 @@ typedef struct {
   uint32_t    BaseAddr;
 } I2C_CONFIG;
 
+//*****************************************************************************
+// Per peripheral transaction counters, for comparing changes to the I2C
+// paths.  The tick fields stay at zero unless a clock is set with
+// i2cStatsSetClock.
+//*****************************************************************************
+typedef struct {
+  uint32_t    transfers;        // blocking i2c_transfer calls
+  uint32_t    async_xfers;      // queued transactions completed
+  uint32_t    bytes_written;    // data bytes ACKed, addresses not counted
+  uint32_t    bytes_read;
+  uint32_t    nacks;
+  uint32_t    timeouts;
+  uint32_t    wait_polls;       // busy flag polls made by blocking calls
+  uint32_t    ticks;            // total time of all transactions
+  uint32_t    max_ticks;        // longest single transaction
+} i2c_stats_t;
+
+typedef uint32_t (*i2c_clock_t)(void);
+
+//*****************************************************************************
+// Performs a complete blocking transaction: writes wr_len bytes (usually a
+// register address) and then, after a repeated START, reads rd_len bytes.
+// The last byte read is NACKed and followed by a STOP.  Either length may
+// be zero, but not both.
+//
+// Polls the peripheral, so it also works with interrupts disabled.
+//
+// Paramters:
+//    i2c_base:  The base address of the I2C peripheral
+//    dev_id:    7-bit slave address
+//    wr_data:   bytes to write, may be NULL if wr_len is 0
+//    wr_len:    number of bytes to write
+//    rd_data:   buffer for the bytes read, may be NULL if rd_len is 0
+//    rd_len:    number of bytes to read
+//
+// Return Value:
+//    Returns I2C_OK if every byte was ACKed
+//    Returns I2C_NO_ACK if the slave NACKed the address or a data byte
+//    Returns I2C_ARBLST if arbitration was lost
+//    Returns I2C_TIMEOUT if the bus did not finish a byte in I2C_WAIT_POLLS
+//    Returns I2C_INVALID_BASE, I2C_NULL_PTR or I2C_INVALID_PARAM for bad
+//    arguments
+//*****************************************************************************
+i2c_status_t i2c_transfer(
+  uint32_t i2c_base,
+  uint8_t dev_id,
+  const uint8_t *wr_data,
+  uint8_t wr_len,
+  uint8_t *rd_data,
+  uint8_t rd_len
+);
+
+//*****************************************************************************
+// Asynchronous transaction descriptor.  The caller owns the memory and must
+// leave it (and the buffers it points to) alone until done is set.
+//
+// A transaction writes wr_len bytes and then, if rd_len is not zero, reads
+// rd_len bytes after a repeated START.  Either length may be zero.
+//*****************************************************************************
+typedef struct i2c_xfer i2c_xfer_t;
+typedef void (*i2c_callback_t)(i2c_xfer_t *xfer);
+
+struct i2c_xfer {
+  uint8_t                 dev_id;     // 7-bit slave address
+  const uint8_t           *wr_data;
+  uint8_t                 wr_len;
+  uint8_t                 *rd_data;
+  uint8_t                 rd_len;
+  i2c_callback_t          callback;   // called from the I2C ISR, may be NULL
+  void                    *context;   // free for the caller's use
+  volatile i2c_status_t   status;     // valid once done is set
+  volatile bool           done;
+  i2c_xfer_t              *next;      // queue link, owned by the driver
+};
+
 //*****************************************************************************
 // Initializes a given I2C peripheral to operate at 100KHz.  This assumes
 // MCU core is running at 50MHz
@@ -210,4 +290,122 @@ i2cVerifyBaseAddr(
   uint32_t i2c_base
 );
 
+//*****************************************************************************
+// Queues an asynchronous transaction.  The I2C ISR moves it along one byte
+// at a time, so the caller does not wait on the bus.  When the transaction
+// ends xfer->status and xfer->done are set and the callback runs from the
+// ISR.  Callbacks may submit the next transaction.
+//
+// Submit from the main loop or from a callback only.  The blocking
+// functions above wait for the queue to drain before using the bus, so the
+// two can be mixed from the main loop.
+//
+// Paramters:
+//    i2c_base:  The base address of the I2C peripheral
+//    xfer:      Transaction to queue
+//
+// Return Value:
+//    Returns I2C_OK if the transaction was queued
+//    Returns I2C_INVALID_BASE if the base address is not a valid I2C address
+//    Returns I2C_NULL_PTR if xfer or one of its buffers is NULL
+//*****************************************************************************
+i2c_status_t i2cSubmit(
+  uint32_t i2c_base,
+  i2c_xfer_t *xfer
+);
+
+//*****************************************************************************
+// Returns true if no asynchronous transactions are queued or running
+//*****************************************************************************
+bool
+i2cAsyncIdle(
+  uint32_t i2c_base
+);
+
+//*****************************************************************************
+// Drops every queued asynchronous transaction.  Each one completes with
+// I2C_TIMEOUT and its callback runs, so callers waiting on done are
+// released.  Used when a transaction has not finished in time.
+//
+// Paramters:
+//    i2c_base:  The base address of the I2C peripheral
+//*****************************************************************************
+void
+i2cAsyncAbort(
+  uint32_t i2c_base
+);
+
+//*****************************************************************************
+// Empties the asynchronous queue without completing its transactions: no
+// callback runs and done stays false.  For fault handlers, where the
+// callbacks and the state they touch cannot be trusted.
+//
+// Paramters:
+//    i2c_base:  The base address of the I2C peripheral
+//*****************************************************************************
+void
+i2cAsyncDrop(
+  uint32_t i2c_base
+);
+
+//*****************************************************************************
+// Returns true if a wait on this peripheral has timed out or its queue was
+// aborted since the last i2cBusRecover.  The caller should recover the bus.
+//*****************************************************************************
+bool
+i2cBusStuck(
+  uint32_t i2c_base
+);
+
+//*****************************************************************************
+// Returns the transaction counters of a peripheral, or NULL if the base
+// address is not a valid I2C address.  The counters keep running; clear
+// them with i2cStatsReset.
+//*****************************************************************************
+const i2c_stats_t *
+i2cGetStats(
+  uint32_t i2c_base
+);
+
+//*****************************************************************************
+// Clears the transaction counters of a peripheral
+//*****************************************************************************
+void
+i2cStatsReset(
+  uint32_t i2c_base
+);
+
+//*****************************************************************************
+// Sets the free running up counter used to time transactions.  Pass NULL
+// to stop timing.  The clock is read from the I2C ISR.
+//*****************************************************************************
+void
+i2cStatsSetClock(
+  i2c_clock_t now
+);
+
+//*****************************************************************************
+// Frees a bus held by a slave that lost track of a transaction.  The pins
+// are taken over as GPIO and SCL is clocked up to 9 times until the slave
+// releases SDA, then a STOP is sent and the peripheral is reinitialized.
+// Any queued asynchronous transactions are aborted first.
+//
+// Paramters:
+//    i2c_base:  The base address of the I2C peripheral
+//    gpio_base: The GPIO port the SCL and SDA pins are on
+//    scl_pin:   SCL pin mask
+//    sda_pin:   SDA pin mask
+//
+// Return Value:
+//    Returns I2C_OK if SDA is high once the bus has been reset
+//    Returns I2C_BUS_ERROR if SDA is still held low
+//    Returns I2C_INVALID_BASE if the base address is not a valid I2C address
+//*****************************************************************************
+i2c_status_t i2cBusRecover(
+  uint32_t i2c_base,
+  uint32_t gpio_base,
+  uint8_t scl_pin,
+  uint8_t sda_pin
+);
+
 #endif
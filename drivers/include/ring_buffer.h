@@ -0,0 +1,190 @@
+// Copyright (c) 2015, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "TM4C123GH6PM.h"
+
+//*****************************************************************************
+// Single producer, single consumer ring buffer.  One side may be an ISR and
+// the other the main loop without masking interrupts: the producer only
+// writes head and the consumer only writes tail, and each publishes its
+// index only after the data it covers.
+//
+// head and tail run freely and are masked on use, so the size must be a
+// power of 2 and every slot can be used.  Elements are elem_size bytes.
+//*****************************************************************************
+typedef struct {
+	volatile uint32_t	head;				// elements ever pushed, written by the producer
+	volatile uint32_t	tail;				// elements ever popped, written by the consumer
+	uint32_t					mask;				// number of elements - 1
+	uint16_t					elem_size;	// bytes per element
+	uint8_t						*array;
+} ring_t;
+
+//*****************************************************************************
+// Defines a statically allocated ring named name holding size elements of
+// type.  A size that is not a power of 2 fails to compile.
+//
+// Example:
+//    RING_DEFINE(rx_ring, char, 128);
+//*****************************************************************************
+#define RING_DEFINE(name, type, size)																	\
+	typedef char name##_size_is_power_of_2[(((size) & ((size) - 1)) == 0) ? 1 : -1]; \
+	static type name##_array[size];																			\
+	ring_t name = { 0, 0, (size) - 1, sizeof(type), (uint8_t *)name##_array }
+
+//*****************************************************************************
+// Returns the number of elements waiting in the ring
+//*****************************************************************************
+static __INLINE uint32_t ring_count(const ring_t *ring)
+{
+	return ring->head - ring->tail;
+}
+
+//*****************************************************************************
+// Returns the number of free elements in the ring
+//*****************************************************************************
+static __INLINE uint32_t ring_space(const ring_t *ring)
+{
+	return ring->mask + 1 - (ring->head - ring->tail);
+}
+
+//*****************************************************************************
+// Returns true if the ring is empty.  Returns false if it is not.
+//*****************************************************************************
+static __INLINE bool ring_empty(const ring_t *ring)
+{
+	return ring->head == ring->tail;
+}
+
+//*****************************************************************************
+// Returns true if the ring is full.  Returns false if it is not.
+//*****************************************************************************
+static __INLINE bool ring_full(const ring_t *ring)
+{
+	return ring_space(ring) == 0;
+}
+
+//*****************************************************************************
+// Adds one byte to a ring of chars.  Producer side only.
+//
+// Returns true if the byte was added, false if the ring was full.
+//*****************************************************************************
+static __INLINE bool ring_push_byte(ring_t *ring, uint8_t data)
+{
+	uint32_t head = ring->head;
+	
+	if(head - ring->tail > ring->mask) return false;
+	ring->array[head & ring->mask] = data;
+	__DMB();
+	ring->head = head + 1;
+	return true;
+}
+
+//*****************************************************************************
+// Removes the oldest byte from a ring of chars.  Consumer side only.
+//
+// Returns true if a byte was removed, false if the ring was empty.
+//*****************************************************************************
+static __INLINE bool ring_pop_byte(ring_t *ring, uint8_t *data)
+{
+	uint32_t tail = ring->tail;
+	
+	if(ring->head == tail) return false;
+	__DMB();
+	*data = ring->array[tail & ring->mask];
+	__DMB();
+	ring->tail = tail + 1;
+	return true;
+}
+
+//*****************************************************************************
+// Adds one element.  Producer side only.
+// 
+// Parameters
+//    ring    :   The address of the ring.
+//    elem    :   Element to copy in, elem_size bytes.
+//
+// Returns true if the element was added, false if the ring was full.
+//*****************************************************************************
+bool ring_push(ring_t *ring, const void *elem);
+
+//*****************************************************************************
+// Removes the oldest element.  Consumer side only.
+// 
+// Parameters
+//    ring    :   The address of the ring.
+//    elem    :   Where to copy the element, elem_size bytes.
+//
+// Returns true if an element was removed, false if the ring was empty.
+//*****************************************************************************
+bool ring_pop(ring_t *ring, void *elem);
+
+//*****************************************************************************
+// Adds up to count elements with at most two block copies.  Producer side
+// only.
+// 
+// Returns the number of elements added, less than count if the ring filled.
+//*****************************************************************************
+uint32_t ring_push_bulk(ring_t *ring, const void *elems, uint32_t count);
+
+//*****************************************************************************
+// Removes up to count of the oldest elements with at most two block copies.
+// Consumer side only.
+// 
+// Returns the number of elements removed.
+//*****************************************************************************
+uint32_t ring_pop_bulk(ring_t *ring, void *elems, uint32_t count);
+
+//*****************************************************************************
+// Returns the oldest elements that sit next to each other in memory, without
+// removing them.  Release them with ring_consume once they have been used.
+// Consumer side only.
+// 
+// Parameters
+//    ring    :   The address of the ring.
+//    span    :   Set to the address of the oldest element.
+//
+// Returns the number of elements in the span, 0 if the ring is empty.
+//*****************************************************************************
+uint32_t ring_read_span(ring_t *ring, const void **span);
+
+//*****************************************************************************
+// Like ring_read_span, but starts offset elements past the oldest.  Lets a
+// consumer hand out more data, such as to DMA, while earlier spans are still
+// in use and not yet consumed.  Consumer side only.
+// 
+// Returns the number of elements in the span, 0 if there are no more than
+// offset elements in the ring.
+//*****************************************************************************
+uint32_t ring_peek_span(ring_t *ring, uint32_t offset, const void **span);
+
+//*****************************************************************************
+// Removes count elements after a ring_read_span.  Consumer side only.
+//*****************************************************************************
+void ring_consume(ring_t *ring, uint32_t count);
+
+#endif
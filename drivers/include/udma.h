@@ -0,0 +1,103 @@
+//*****************************************************************************
+// udma.h
+// Author: jkrachey@wisc.edu
+//*****************************************************************************
+
+#ifndef __UDMA_H__
+#define __UDMA_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "TM4C123GH6PM.h"
+#include "driver_defines.h"
+
+// Channel numbers and their CHMAP encodings.  Only the channels the project
+// uses are listed.
+#define UDMA_CH_UART0_TX          9
+#define UDMA_ENC_UART0_TX         0
+
+#define UDMA_NUM_CHANNELS         32
+
+// Longest transfer one control structure can describe
+#define UDMA_MAX_TRANSFER         1024
+
+#define UDMA_CFG_MASTEN           0x00000001
+
+// Bit fields of the control word in a control structure
+#define UDMA_CHCTL_DSTINC_NONE    0xC0000000
+#define UDMA_CHCTL_DSTSIZE_8      0x00000000
+#define UDMA_CHCTL_SRCINC_8       0x00000000
+#define UDMA_CHCTL_SRCSIZE_8      0x00000000
+#define UDMA_CHCTL_ARBSIZE_4      0x00008000
+#define UDMA_CHCTL_XFERSIZE_S     4
+#define UDMA_CHCTL_XFERMODE_M     0x00000007
+#define UDMA_CHCTL_XFERMODE_STOP  0x00000000
+#define UDMA_CHCTL_XFERMODE_PINGPONG  0x00000003
+
+//*****************************************************************************
+// One channel control structure.  The controller reads it to start a
+// transfer and writes the remaining size and a STOP mode back into control
+// when it is done.
+//*****************************************************************************
+typedef struct {
+  const volatile void *src_end;   // address of the last source byte
+  volatile void       *dst_end;   // address of the last destination byte
+  volatile uint32_t   control;
+  uint32_t            unused;
+} udma_entry_t;
+
+//*****************************************************************************
+// Turns on the uDMA controller and points it at the control table.
+//*****************************************************************************
+void udma_init(void);
+
+//*****************************************************************************
+// Connects a channel to one of its peripherals and lets the peripheral
+// request both single and burst transfers.
+//
+// Paramters:
+//    channel:   uDMA channel number
+//    encoding:  CHMAP value that selects the peripheral
+//*****************************************************************************
+void udma_assign(uint8_t channel, uint8_t encoding);
+
+//*****************************************************************************
+// Fills the primary or alternate control structure of a channel with a
+// ping-pong transfer of len bytes from memory to a peripheral data
+// register.  The controller moves on to the other structure when this one
+// finishes, so one can be refilled while the other is in use.
+//
+// Paramters:
+//    channel:   uDMA channel number
+//    alt:       true for the alternate structure, false for the primary
+//    src:       first byte to send
+//    dst:       peripheral data register
+//    len:       number of bytes, 1 to UDMA_MAX_TRANSFER
+//*****************************************************************************
+void udma_arm_tx(uint8_t channel, bool alt, const void *src, volatile void *dst, uint32_t len);
+
+//*****************************************************************************
+// Enables a channel, starting with the primary or alternate structure.
+//*****************************************************************************
+void udma_start(uint8_t channel, bool alt);
+
+//*****************************************************************************
+// Returns true if the channel is enabled.  The controller disables it after
+// a transfer whose other structure is stopped.
+//*****************************************************************************
+bool udma_enabled(uint8_t channel);
+
+//*****************************************************************************
+// Returns true if the primary or alternate structure of a channel is
+// stopped, which is the case once its transfer has finished.
+//*****************************************************************************
+bool udma_stopped(uint8_t channel, bool alt);
+
+//*****************************************************************************
+// The completion interrupt of a peripheral channel arrives on the
+// peripheral's own vector.  Returns true, and clears it, if the channel
+// raised it.
+//*****************************************************************************
+bool udma_irq_clear(uint8_t channel);
+
+#endif
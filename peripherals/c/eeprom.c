@@ -1,5 +1,19 @@
 #include "eeprom.h"
 
+// Write-behind queue.  Each entry is the part of a write that falls inside
+// one page, so draining an entry is exactly one page write.
+typedef struct {
+  uint32_t  i2c_base;
+  uint16_t  address;
+  uint8_t   len;
+  uint8_t   data[EEPROM_PAGE_SIZE];
+} eeprom_queue_entry_t;
+
+static eeprom_queue_entry_t eeprom_queue[EEPROM_QUEUE_DEPTH];
+static uint8_t  queue_head = 0;
+static uint8_t  queue_count = 0;
+static uint16_t queue_bytes = 0;
+
 //*****************************************************************************
 // Used to determine if the EEPROM is busy writing the last transaction to 
 // non-volatile storage
@@ -9,36 +23,26 @@
 //
 // Returns
 // I2C_OK is returned one the EEPROM is ready to write the next byte
+// I2C_TIMEOUT is returned if it has not ACKed after EEPROM_WRITE_POLLS tries
 //*****************************************************************************
 static 
 i2c_status_t eeprom_wait_for_write( int32_t  i2c_base)
 {
-  
+  // The data we send does not matter.  This has been set to 0x00, but could
+  // be set to anything
+  uint8_t dummy = 0x00;
   i2c_status_t status;
+  uint32_t polls = EEPROM_WRITE_POLLS;
   
-  if( !i2cVerifyBaseAddr(i2c_base) )
-  {
-    return  I2C_INVALID_BASE;
-  }
-
-  // Set the I2C address to be the EEPROM and in Write Mode
-  status = i2cSetSlaveAddr(i2c_base, MCP24LC32AT_DEV_ID, I2C_WRITE);
-
   // Poll while the device is busy.  The  MCP24LC32AT will not ACK
-  // writing an address while the write has not finished.
+  // its address while the write has not finished.  A missing device never
+  // ACKs, so give up well after the longest write cycle.
   do 
   {
-    // The data we send does not matter.  This has been set to 0x00, but could
-    // be set to anything
-    status = i2cSendByte( i2c_base, 0x00, I2C_MCS_START | I2C_MCS_RUN | I2C_MCS_STOP);
-    
-    // Wait for the address to finish transmitting
-    while ( I2CMasterBusy(i2c_base)) {};
-    
-    // If the address was not ACKed, try again.
-  } while (I2CMasterAdrAck(i2c_base) == false);
+    status = i2c_transfer(i2c_base, MCP24LC32AT_DEV_ID, &dummy, 1, NULL, 0);
+  } while (status == I2C_NO_ACK && --polls > 0);
 
-  return  status;
+  return  (status == I2C_NO_ACK) ? I2C_TIMEOUT : status;
 }
   
   
@@ -63,45 +67,22 @@ i2c_status_t eeprom_byte_write
   uint8_t   data
 )
 {
+  uint8_t buf[3];
   i2c_status_t status;
   
-  // Before doing anything, make sure the I2C device is idle
-  while ( I2CMasterBusy(i2c_base)) 
-	{
-	};
-
-  //==============================================================
-  // Set the I2C address to be the EEPROM
-	// ADD CODE
-  //==============================================================
-	status = i2cSetSlaveAddr(i2c_base, MCP24LC32AT_DEV_ID, I2C_WRITE);
-	if(!status==I2C_OK) return false;
-  
   // If the EEPROM is still writing the last byte written, wait
-  eeprom_wait_for_write(i2c_base);
-  
-  //==============================================================
-  // Send the Upper byte of the address
-	// ADD CODE	
-  //==============================================================
-	status = i2cSendByte(i2c_base, (uint8_t)(address>>8), I2C_MCS_START | I2C_MCS_RUN);
-	if(!status==I2C_OK) return false;
-	
-  //==============================================================
-  // Send the Lower byte of the address
-	// ADD CODE
-  //==============================================================
-  status = i2cSendByte(i2c_base, (uint8_t)(address), I2C_MCS_RUN);
-	if(!status==I2C_OK) return false;
-	
-  //==============================================================
-  // Send the Byte of data to write
-	// ADD CODE
-  //==============================================================
-	status = i2cSendByte(i2c_base, data, I2C_MCS_RUN | I2C_MCS_STOP);
-	if(!status==I2C_OK) return false;
-	
-  return status;
+  status = eeprom_wait_for_write(i2c_base);
+  if ( status != I2C_OK )
+  {
+    return status;
+  }
+  
+  // Upper address byte, lower address byte, then the data
+  buf[0] = (uint8_t)(address >> 8);
+  buf[1] = (uint8_t)(address);
+  buf[2] = data;
+  
+  return i2c_transfer(i2c_base, MCP24LC32AT_DEV_ID, buf, 3, NULL, 0);
 }
 
 //*****************************************************************************
@@ -125,52 +106,306 @@ i2c_status_t eeprom_byte_read
   uint8_t   *data
 )
 {
+  uint8_t buf[2];
   i2c_status_t status;
   
-  // Before doing anything, make sure the I2C device is idle
-  while ( I2CMasterBusy(i2c_base)) {};
-
   // If the EEPROM is still writing the last byte written, wait
-  eeprom_wait_for_write(i2c_base);
-
-  //==============================================================
-  // Set the I2C slave address to be the EEPROM and in Write Mode
-	// ADD CODE
-  //==============================================================
-		status = i2cSetSlaveAddr(i2c_base, MCP24LC32AT_DEV_ID, I2C_WRITE);
-	if(!status==I2C_OK) return false;
-
-  //==============================================================
-  // Send the Upper byte of the address
-	// ADD CODE
-  //==============================================================
-	status = i2cSendByte(i2c_base, (uint8_t)(address>>8), I2C_MCS_START | I2C_MCS_RUN);
-	if(!status==I2C_OK) return false;
-
-  //==============================================================
-  // Send the Lower byte of the address
-	// ADD CODE
-  //==============================================================
-  status = i2cSendByte(i2c_base, (uint8_t)(address), I2C_MCS_RUN);
-	if(!status==I2C_OK) return false;
-
-  //==============================================================
-  // Set the I2C slave address to be the EEPROM and in Read Mode
-	// ADD CODE
-  //==============================================================
-	status = i2cSetSlaveAddr(i2c_base, MCP24LC32AT_DEV_ID, I2C_READ);
-	if(!status==I2C_OK) return false;
-
-  //==============================================================
-  // Read the data returned by the EEPROM
-	// ADD CODE
-  //==============================================================
-	status = i2cGetByte(i2c_base, data, I2C_MCS_START | I2C_MCS_RUN | I2C_MCS_STOP);
-	if(!status==I2C_OK) return false;
-	
+  status = eeprom_wait_for_write(i2c_base);
+  if ( status != I2C_OK )
+  {
+    return status;
+  }
+  
+  // Set the address pointer and read the byte back after a repeated START
+  buf[0] = (uint8_t)(address >> 8);
+  buf[1] = (uint8_t)(address);
+  
+  return i2c_transfer(i2c_base, MCP24LC32AT_DEV_ID, buf, 2, data, 1);
+}
+
+//*****************************************************************************
+// Reads len consecutive bytes from the  MCP24LC32AT EEPROM.  
+//
+// Paramters
+//    i2c_base:   a valid base address of an I2C peripheral
+//
+//    address:    address of the first byte
+//
+//    data:       buffer for the bytes read
+//
+//    len:        number of bytes to read
+//
+// Returns
+// I2C_OK if all of the bytes were read from the EEPROM.
+//*****************************************************************************
+i2c_status_t eeprom_read
+( 
+  uint32_t  i2c_base,
+  uint16_t  address,
+  uint8_t   *data,
+  uint16_t  len
+)
+{
+  uint8_t buf[2];
+  uint8_t chunk;
+  i2c_status_t status;
+  
+  // If the EEPROM is still writing, wait
+  status = eeprom_wait_for_write(i2c_base);
+  
+  // One addressed transaction per 255 bytes, the most i2c_transfer can read
+  while ( status == I2C_OK && len > 0 )
+  {
+    chunk = (len > 255) ? 255 : len;
+    
+    buf[0] = (uint8_t)(address >> 8);
+    buf[1] = (uint8_t)(address);
+    status = i2c_transfer(i2c_base, MCP24LC32AT_DEV_ID, buf, 2, data, chunk);
+    
+    address += chunk;
+    data += chunk;
+    len -= chunk;
+  }
+  
+  return status;
+}
+
+//*****************************************************************************
+// Writes len consecutive bytes to the  MCP24LC32AT EEPROM.  
+//
+// Paramters
+//    i2c_base:   a valid base address of an I2C peripheral
+//
+//    address:    address of the first byte
+//
+//    data:       bytes to write
+//
+//    len:        number of bytes to write
+//
+// Returns
+// I2C_OK if all of the bytes were written to the EEPROM.
+//*****************************************************************************
+i2c_status_t eeprom_write
+( 
+  uint32_t  i2c_base,
+  uint16_t  address,
+  const uint8_t *data,
+  uint16_t  len
+)
+{
+  uint8_t buf[2 + EEPROM_PAGE_SIZE];
+  uint8_t chunk;
+  i2c_status_t status = I2C_OK;
+  int i;
+  
+  while ( status == I2C_OK && len > 0 )
+  {
+    // Stop at the end of the current page.  The EEPROM would wrap to the
+    // start of the page instead of moving on to the next one.
+    chunk = EEPROM_PAGE_SIZE - (address & (EEPROM_PAGE_SIZE - 1));
+    if ( chunk > len )
+    {
+      chunk = len;
+    }
+    
+    // Each page waits for the previous write cycle to finish
+    status = eeprom_wait_for_write(i2c_base);
+    if ( status != I2C_OK )
+    {
+      break;
+    }
+    
+    buf[0] = (uint8_t)(address >> 8);
+    buf[1] = (uint8_t)(address);
+    for ( i = 0; i < chunk; i++ )
+    {
+      buf[2 + i] = data[i];
+    }
+    status = i2c_transfer(i2c_base, MCP24LC32AT_DEV_ID, buf, 2 + chunk, NULL, 0);
+    
+    address += chunk;
+    data += chunk;
+    len -= chunk;
+  }
+  
+  return status;
+}
+
+//*****************************************************************************
+// Writes the oldest queued entry.  Without wait, a single address poll
+// decides if the EEPROM is still busy and I2C_NO_ACK is returned if it is.
+//*****************************************************************************
+static i2c_status_t eeprom_queue_drain(bool wait)
+{
+  eeprom_queue_entry_t *entry = &eeprom_queue[queue_head];
+  uint8_t dummy = 0x00;
+  i2c_status_t status;
+  
+  if ( !wait )
+  {
+    status = i2c_transfer(entry->i2c_base, MCP24LC32AT_DEV_ID, &dummy, 1, NULL, 0);
+    if ( status != I2C_OK )
+    {
+      return status;
+    }
+  }
+  
+  // A failed entry stays at the head and is tried again
+  status = eeprom_write(entry->i2c_base, entry->address, entry->data, entry->len);
+  if ( status == I2C_OK )
+  {
+    queue_bytes -= entry->len;
+    queue_head = (queue_head + 1) % EEPROM_QUEUE_DEPTH;
+    queue_count--;
+  }
+  return status;
+}
+
+//*****************************************************************************
+// Queues len consecutive bytes, one entry per page touched
+//*****************************************************************************
+i2c_status_t eeprom_queue_write
+( 
+  uint32_t  i2c_base,
+  uint16_t  address,
+  const uint8_t *data,
+  uint16_t  len
+)
+{
+  eeprom_queue_entry_t *entry;
+  uint8_t chunk;
+  i2c_status_t status;
+  int i;
+  
+  while ( len > 0 )
+  {
+    chunk = EEPROM_PAGE_SIZE - (address & (EEPROM_PAGE_SIZE - 1));
+    if ( chunk > len )
+    {
+      chunk = len;
+    }
+    
+    // Carry on in the newest entry if this write continues it on the same page
+    entry = &eeprom_queue[(queue_head + queue_count - 1) % EEPROM_QUEUE_DEPTH];
+    if ( queue_count == 0 || entry->i2c_base != i2c_base ||
+         entry->address + entry->len != address ||
+         (address & (EEPROM_PAGE_SIZE - 1)) == 0 )
+    {
+      if ( queue_count == EEPROM_QUEUE_DEPTH )
+      {
+        status = eeprom_queue_drain(true);
+        if ( status != I2C_OK )
+        {
+          return status;
+        }
+      }
+      entry = &eeprom_queue[(queue_head + queue_count) % EEPROM_QUEUE_DEPTH];
+      entry->i2c_base = i2c_base;
+      entry->address = address;
+      entry->len = 0;
+      queue_count++;
+    }
+    
+    for ( i = 0; i < chunk; i++ )
+    {
+      entry->data[entry->len++] = data[i];
+    }
+    queue_bytes += chunk;
+    
+    address += chunk;
+    data += chunk;
+    len -= chunk;
+  }
+  
   return I2C_OK;
 }
 
+//*****************************************************************************
+// Reads from the EEPROM, then copies in queued bytes oldest first so the
+// newest queued value of each byte wins
+//*****************************************************************************
+i2c_status_t eeprom_queue_read
+( 
+  uint32_t  i2c_base,
+  uint16_t  address,
+  uint8_t   *data,
+  uint16_t  len
+)
+{
+  eeprom_queue_entry_t *entry;
+  i2c_status_t status;
+  uint32_t start, end;
+  int i;
+  uint32_t j;
+  
+  status = eeprom_read(i2c_base, address, data, len);
+  if ( status != I2C_OK )
+  {
+    return status;
+  }
+  
+  for ( i = 0; i < queue_count; i++ )
+  {
+    entry = &eeprom_queue[(queue_head + i) % EEPROM_QUEUE_DEPTH];
+    if ( entry->i2c_base != i2c_base )
+    {
+      continue;
+    }
+    
+    // Overlap of [address, address+len) and the entry
+    start = (entry->address > address) ? entry->address : address;
+    end = entry->address + entry->len;
+    if ( end > (uint32_t)address + len )
+    {
+      end = (uint32_t)address + len;
+    }
+    for ( j = start; j < end; j++ )
+    {
+      data[j - address] = entry->data[j - entry->address];
+    }
+  }
+  
+  return I2C_OK;
+}
+
+//*****************************************************************************
+// Writes at most one page, only if the EEPROM is ready for it
+//*****************************************************************************
+uint16_t eeprom_queue_step(void)
+{
+  if ( queue_count > 0 )
+  {
+    eeprom_queue_drain(false);
+  }
+  return queue_bytes;
+}
+
+//*****************************************************************************
+// Writes everything in the queue
+//*****************************************************************************
+i2c_status_t eeprom_queue_flush(void)
+{
+  i2c_status_t status;
+  
+  while ( queue_count > 0 )
+  {
+    status = eeprom_queue_drain(true);
+    if ( status != I2C_OK )
+    {
+      return status;
+    }
+  }
+  return I2C_OK;
+}
+
+//*****************************************************************************
+// Returns the number of bytes waiting in the queue
+//*****************************************************************************
+uint16_t eeprom_queue_pending(void)
+{
+  return queue_bytes;
+}
+
 //*****************************************************************************
 // Initialize the I2C peripheral
 //*****************************************************************************
@@ -1,132 +1,239 @@
 #include "ft6x06.h"
 
 //*****************************************************************************
-// Sets the address to read/write from in the FT6x06  
+// Reads consecutive registers of the FT6x06 in one transaction.  The register
+// address is written and the data is read back after a repeated START.
 //
 // Paramters
-//    i2c_base:   a valid base address of an I2C peripheral
+//    address:    8-bit address of the first register
 //
-//    address:    8-bit address
+//    data:       buffer for the registers read
+//
+//    len:        number of registers to read
 //
 // Returns
-// I2C_OK if the byte was written to the FT6X06.
+// I2C_OK if the registers were read from the FT6X06.
 //*****************************************************************************
-static i2c_status_t ft6x06_set_addr
+static i2c_status_t ft6x06_read_regs
 ( 
-  uint32_t  i2c_base,
-  uint8_t  address
+  uint8_t  address,
+  uint8_t  *data,
+  uint8_t  len
 )
 {
-  i2c_status_t status;
-  
-  // Before doing anything, make sure the I2C device is idle
-  while ( I2CMasterBusy(i2c_base)) {};
-
-  //==============================================================
-  // ADD CODE
-  // Set the I2C address 
-  //==============================================================
-   status = i2cSetSlaveAddr(i2c_base, FT6X06_DEV_ID, I2C_WRITE);
-    
-  if ( status != I2C_OK )
-  {
-    return status;
-  }
-  
-  //==============================================================
-  // ADD CODE
-  // Send the address
-  //==============================================================
-	i2cSendByte(i2c_base, address, I2C_MCS_START | I2C_MCS_RUN |I2C_MCS_STOP);
-	
-  return status;
+  return i2c_transfer(FT6X06_I2C_BASE, FT6X06_DEV_ID, &address, 1, data, len);
 }
 
 //*****************************************************************************
-// Reads one byte of data from the current address of the FT6x06  
+// Writes one register of the FT6x06  
 //
 // Paramters
-//    i2c_base:   a valid base address of an I2C peripheral
+//    address:    8-bit register address
 //
-//    data:       data to read.
+//    data:       value to write
 //
 // Returns
 // I2C_OK if the byte was written to the FT6X06.
 //*****************************************************************************
-static i2c_status_t ft6x06_read_data
+static i2c_status_t ft6x06_write_reg
 ( 
-  uint32_t  i2c_base,
-  uint8_t *data
+  uint8_t  address,
+  uint8_t  data
 )
 {
-  i2c_status_t status;
+  uint8_t buf[2];
   
-  // Before doing anything, make sure the I2C device is idle
-  while ( I2CMasterBusy(i2c_base)) {};
-
-  //==============================================================
-  // ADD CODE
-  // Set the I2C address 
-  //==============================================================
-  status = i2cSetSlaveAddr(i2c_base, FT6X06_DEV_ID, I2C_READ);
-
-  if ( status != I2C_OK )
-  {
-    return status;
-  }
-
-  //==============================================================
-  // ADD CODE
-  // get the data
-  //==============================================================
-	status = i2cGetByte( i2c_base, data, I2C_MCS_START | I2C_MCS_RUN | I2C_MCS_STOP);
-
-  return status;
+  buf[0] = address;
+  buf[1] = data;
+  return i2c_transfer(FT6X06_I2C_BASE, FT6X06_DEV_ID, buf, 2, NULL, 0);
 }
 
-
 //*****************************************************************************
 // Read the number of active touch points.
 //*****************************************************************************
 uint8_t ft6x06_read_td_status(void)
 { 
-  // ADD CODE
   // Return the number of active touch points.  The only valid values of the 
   // register will be 0, 1, or 2.
 	uint8_t data;
-	i2c_status_t status;
 	
-	status = ft6x06_set_addr(FT6X06_I2C_BASE, FT6X06_TD_STATUS_R);
-	if(status == I2C_OK) status = ft6x06_read_data(FT6X06_I2C_BASE, &data);
-	if(status == I2C_OK) {
+	if(ft6x06_read_regs(FT6X06_TD_STATUS_R, &data, 1) == I2C_OK) {
 		data &= 0x3;
 		if(data == 3) data = 0;
 		return data;
 	}
 	return 0;
-	
 } 
 
+//*****************************************************************************
+// Decodes one touch point starting at its Pn_XH register
+//*****************************************************************************
+static void ft6x06_decode_point(const uint8_t *buf, ft6x06_point_t *point)
+{
+  point->event  = buf[0] >> 6;
+  point->x      = ((buf[0] & 0x0F) << 8) | buf[1];
+  point->id     = buf[2] >> 4;
+  point->y      = ((buf[2] & 0x0F) << 8) | buf[3];
+  point->weight = buf[4];
+  point->area   = buf[5] >> 4;
+}
+
+//*****************************************************************************
+// Decodes FT6X06_TOUCH_BYTES read from TD_STATUS onwards
+//*****************************************************************************
+void ft6x06_decode_touch(const uint8_t *buf, ft6x06_touch_t *report)
+{
+  report->touches = buf[0] & 0x3;
+  
+  // Only 0, 1 or 2 are valid touch counts
+  if ( report->touches == 3 )
+  {
+    report->touches = 0;
+  }
+  
+  ft6x06_decode_point(&buf[FT6X06_P1_XH_R - FT6X06_TD_STATUS_R], &report->point[0]);
+  ft6x06_decode_point(&buf[FT6X06_P2_XH_R - FT6X06_TD_STATUS_R], &report->point[1]);
+}
+
+//*****************************************************************************
+// Reads TD_STATUS through P2_MISC in one transaction
+//*****************************************************************************
+i2c_status_t ft6x06_read_touch(ft6x06_touch_t *report)
+{ 
+  uint8_t data[FT6X06_TOUCH_BYTES];
+  i2c_status_t status;
+  
+  status = ft6x06_read_regs(FT6X06_TD_STATUS_R, data, FT6X06_TOUCH_BYTES);
+  if ( status != I2C_OK )
+  {
+    report->touches = 0;
+    return status;
+  }
+  
+  ft6x06_decode_touch(data, report);
+  return I2C_OK;
+} 
+
+//*****************************************************************************
+// Queues the TD_STATUS through P2_MISC read
+//*****************************************************************************
+i2c_status_t ft6x06_read_touch_async(i2c_xfer_t *xfer, uint8_t *buf, i2c_callback_t callback)
+{
+  static const uint8_t td_status_addr = FT6X06_TD_STATUS_R;
+  
+  xfer->dev_id = FT6X06_DEV_ID;
+  xfer->wr_data = &td_status_addr;
+  xfer->wr_len = 1;
+  xfer->rd_data = buf;
+  xfer->rd_len = FT6X06_TOUCH_BYTES;
+  xfer->callback = callback;
+  
+  return i2cSubmit(FT6X06_I2C_BASE, xfer);
+}
+
+//*****************************************************************************
+// Adds a report to a history ring
+//*****************************************************************************
+void ft6x06_history_push(ft6x06_history_t *history, const ft6x06_touch_t *report)
+{
+  history->report[history->head] = *report;
+  history->head = (history->head + 1) & (FT6X06_HISTORY_LEN - 1);
+  if ( history->count < FT6X06_HISTORY_LEN )
+  {
+    history->count++;
+  }
+}
+
+//*****************************************************************************
+// Returns the report i places before the newest one
+//*****************************************************************************
+static const ft6x06_touch_t *ft6x06_history_get(const ft6x06_history_t *history, uint8_t i)
+{
+  return &history->report[(history->head - 1 - i) & (FT6X06_HISTORY_LEN - 1)];
+}
+
+//*****************************************************************************
+// Averages the first touch point over the newest n reports of the press
+//*****************************************************************************
+bool ft6x06_history_average(const ft6x06_history_t *history, uint8_t n, uint16_t *x, uint16_t *y)
+{
+  const ft6x06_touch_t *report;
+  uint32_t sum_x = 0;
+  uint32_t sum_y = 0;
+  uint8_t i;
+  
+  if ( n > history->count )
+  {
+    n = history->count;
+  }
+  
+  for ( i = 0; i < n; i++ )
+  {
+    report = ft6x06_history_get(history, i);
+    if ( report->touches == 0 )
+    {
+      break;
+    }
+    sum_x += report->point[0].x;
+    sum_y += report->point[0].y;
+  }
+  
+  if ( i == 0 )
+  {
+    return false;
+  }
+  
+  *x = sum_x / i;
+  *y = sum_y / i;
+  return true;
+}
+
+//*****************************************************************************
+// Movement of the first touch point over the current press
+//*****************************************************************************
+bool ft6x06_history_delta(const ft6x06_history_t *history, int16_t *dx, int16_t *dy)
+{
+  const ft6x06_touch_t *newest;
+  const ft6x06_touch_t *oldest;
+  uint8_t i;
+  
+  if ( history->count == 0 )
+  {
+    return false;
+  }
+  
+  newest = ft6x06_history_get(history, 0);
+  if ( newest->touches == 0 )
+  {
+    return false;
+  }
+  
+  // Walk back to the first report of this press
+  oldest = newest;
+  for ( i = 1; i < history->count; i++ )
+  {
+    if ( ft6x06_history_get(history, i)->touches == 0 )
+    {
+      break;
+    }
+    oldest = ft6x06_history_get(history, i);
+  }
+  
+  *dx = (int16_t)newest->point[0].x - (int16_t)oldest->point[0].x;
+  *dy = (int16_t)newest->point[0].y - (int16_t)oldest->point[0].y;
+  return true;
+}
 
 //*****************************************************************************
 // Read the X value of last touch event
 //*****************************************************************************
 uint16_t ft6x06_read_x(void)
 { 
-  // ADD CODE
-  // Return the X coordinate of the last touch point
-  // This will require reading P1_XH and P1_XL
+  // P1_XH holds the upper 4 bits, P1_XL the lower 8
 	uint8_t data[2];
-	uint16_t *return_data;
-	
-	ft6x06_set_addr(FT6X06_I2C_BASE, FT6X06_P1_XH_R);
-	ft6x06_read_data(FT6X06_I2C_BASE, (data+1));
-	
-	ft6x06_set_addr(FT6X06_I2C_BASE, FT6X06_P1_XL_R);
-	ft6x06_read_data(FT6X06_I2C_BASE, data);
 	
-	return_data =  (uint16_t *)data;
-	return (*return_data)&0xFFF;
+	if(ft6x06_read_regs(FT6X06_P1_XH_R, data, 2) != I2C_OK) return 0;
+	return ((data[0] & 0x0F) << 8) | data[1];
 } 
 
 //*****************************************************************************
@@ -134,20 +241,11 @@ uint16_t ft6x06_read_x(void)
 //*****************************************************************************
 uint16_t ft6x06_read_y(void)
 { 
-  // ADD CODE
-  // Return the Y coordinate of the last touch point 
-  // This will require reading P1_YH and P1_YL
+  // P1_YH holds the upper 4 bits, P1_YL the lower 8
 	uint8_t data[2];
-	uint16_t *return_data;
 	
-	ft6x06_set_addr(FT6X06_I2C_BASE, FT6X06_P1_YH_R);
-	ft6x06_read_data(FT6X06_I2C_BASE, (data+1));
-	
-	ft6x06_set_addr(FT6X06_I2C_BASE, FT6X06_P1_YL_R);
-	ft6x06_read_data(FT6X06_I2C_BASE, data);
-	
-	return_data = (uint16_t *)data;
-	return (*return_data)&0xFFF;
+	if(ft6x06_read_regs(FT6X06_P1_YH_R, data, 2) != I2C_OK) return 0;
+	return ((data[0] & 0x0F) << 8) | data[1];
 } 
 
 //*****************************************************************************
@@ -209,6 +307,12 @@ bool ft6x06_init(void)
     return false;
   }
   
+  // Pulse INT on each new report so touches can be interrupt driven
+  if( ft6x06_write_reg(FT6X06_G_MODE_R, FT6X06_G_MODE_TRIGGER) != I2C_OK)
+  {
+    return false;
+  }
+  
   return true;
   
 } 
@@ -1,5 +1,8 @@
 #include "lcd.h"
 
+// Receives a copy of the drawing, NULL when mirroring is off
+static const lcd_mirror_t *lcd_mirror = NULL;
+
 /*******************************************************************************
 * Function Name: delayms
 ********************************************************************************
@@ -108,6 +111,37 @@ __INLINE static void  lcd_write_data_u16(uint16_t y)
 	LCD_CSX = 0xFF;
 }
 
+/*******************************************************************************
+* Function Name: lcd_write_pixel
+********************************************************************************
+* Summary: Writes the color of the next pixel of the window and copies it to
+*          the mirror, if there is one
+* Return:
+*  Nothing
+*******************************************************************************/ 
+__INLINE static void lcd_write_pixel(uint16_t color)
+{
+  lcd_write_data_u16(color);
+  if (lcd_mirror)
+  {
+    lcd_mirror->pixel(color);
+  }
+}
+
+/*******************************************************************************
+* Function Name: lcd_set_mirror
+********************************************************************************
+* Summary: Copies every window set with lcd_set_pos and every pixel drawn
+*          into it to the mirror's handlers.  Pass NULL to stop.
+*
+* Return:
+*  Nothing
+*******************************************************************************/
+void lcd_set_mirror(const lcd_mirror_t *mirror)
+{
+  lcd_mirror = mirror;
+}
+
 /*******************************************************************************
 * Function Name: lcd_set_pos
 ********************************************************************************
@@ -126,6 +160,11 @@ void lcd_set_pos(uint16_t x0,uint16_t x1,uint16_t y0,uint16_t y1)
   lcd_write_data_u16(y0);
   lcd_write_data_u16(y1);
   lcd_write_cmd_u8(LCD_CMD_MEMORY_WRITE);
+  
+  if (lcd_mirror)
+  {
+    lcd_mirror->window(x0, x1, y0, y1);
+  }
 }
 
 /*******************************************************************************
@@ -145,11 +184,39 @@ void lcd_clear_screen(uint16_t bColor)
   {
         for(j= 0; j < ROWS; j++)
         {
-            lcd_write_data_u16(bColor);
+            lcd_write_pixel(bColor);
         }
   }
 }
 
+/*******************************************************************************
+* Function Name: lcd_fill_rect
+********************************************************************************
+* Summary: fills the box from x0,y0 to x1,y1 (inclusive) with the provided
+*          color.
+*
+* Return:
+*  Nothing
+*******************************************************************************/
+void lcd_fill_rect(
+  uint16_t x0, 
+  uint16_t x1, 
+  uint16_t y0, 
+  uint16_t y1,
+  uint16_t color
+)
+{
+  uint32_t i, count;
+  
+  lcd_set_pos(x0, x1, y0, y1);
+  
+  count = (uint32_t)(x1 - x0 + 1) * (y1 - y0 + 1);
+  for (i = 0; i < count; i++)
+  {
+    lcd_write_pixel(color);
+  }
+}
+
 /*******************************************************************************
 * Function Name: lcd_draw_image
 ********************************************************************************
@@ -201,11 +268,11 @@ void lcd_draw_image(
             }
             if ( data & 0x80)
             {
-                lcd_write_data_u16(fColor);
+                lcd_write_pixel(fColor);
             }
             else
             {
-                lcd_write_data_u16(bColor);
+                lcd_write_pixel(bColor);
             }
             data  = data << 1;
         }
@@ -315,18 +382,18 @@ void lcd_draw_unit(
 						for (k = 0; k < 8; k++){
 							// if flipX is set, parse data most to least significant bit
 							if(!flipX){
-								if ( data1 & (~data0) & 0x80) 			lcd_write_data_u16(f1Color);
-								else if ( (~data1) & data0 & 0x80) 	lcd_write_data_u16(f2Color);
-								else if ( data1 & data0 & 0x80) 	lcd_write_data_u16(f3Color);
-								else 															lcd_write_data_u16(bColor);
+								if ( data1 & (~data0) & 0x80) 			lcd_write_pixel(f1Color);
+								else if ( (~data1) & data0 & 0x80) 	lcd_write_pixel(f2Color);
+								else if ( data1 & data0 & 0x80) 	lcd_write_pixel(f3Color);
+								else 															lcd_write_pixel(bColor);
 								data0  = data0 << 1;
 								data1  = data1 << 1;
 							// else parse data normally from least to most significant bit
 							} else {
-								if ( data1 & (~data0) & 0x01) 			lcd_write_data_u16(f1Color);
-								else if ( (~data1) & data0 & 0x01) 	lcd_write_data_u16(f2Color);
-								else if ( data1 & data0 & 0x01) 	lcd_write_data_u16(f3Color);
-								else 															lcd_write_data_u16(bColor);
+								if ( data1 & (~data0) & 0x01) 			lcd_write_pixel(f1Color);
+								else if ( (~data1) & data0 & 0x01) 	lcd_write_pixel(f2Color);
+								else if ( data1 & data0 & 0x01) 	lcd_write_pixel(f3Color);
+								else 															lcd_write_pixel(bColor);
 								data0  = data0 >> 1;
 								data1  = data1 >> 1;
 							}
@@ -357,7 +424,7 @@ void lcd_draw_bullet(
 		// Draw each byte of a row
 		for(j= 0; j < image_width_bits; j++)
 		{
-			lcd_write_data_u16(color);
+			lcd_write_pixel(color);
 		}
 	}
 	
@@ -376,7 +443,7 @@ void lcd_draw_px(
   uint16_t color	// color
 ){
   lcd_set_pos(x,x,y,y);
-	lcd_write_data_u16(color);
+	lcd_write_pixel(color);
 }
 
 
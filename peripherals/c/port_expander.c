@@ -1,5 +1,32 @@
 #include "port_expander.h"
 
+//*****************************************************************************
+// Writes one register of the port expander
+//
+// Paramters
+//    i2c_base:   a valid base address of an I2C peripheral
+//
+//    reg:        register address
+//
+//    data:       value to write
+//
+// Returns
+// I2C_OK if completed without error.
+//*****************************************************************************
+static i2c_status_t pexp_write_reg
+( 
+  uint32_t  i2c_base,
+  uint8_t   reg,
+  uint8_t   data
+)
+{
+	uint8_t buf[2];
+	
+	buf[0] = reg;
+	buf[1] = data;
+	return i2c_transfer(i2c_base, MCP23017_DEV_ID, buf, 2, NULL, 0);
+}
+
 //*****************************************************************************
 // Reads the push buttons from the port expander.  
 //
@@ -17,34 +44,12 @@ i2c_status_t pexp_read_buttons
   uint8_t   *data
 )
 {
-  i2c_status_t status;
- // *data = 0;
-  // Before doing anything, make sure the I2C device is idle
-   while ( I2CMasterBusy(i2c_base)) {};
-
-  //==============================================================
-  // Write the GPIOB address to the port expander
-  //==============================================================
-	
-	// Set the Slave address as a write to send the GPIOB address
-	status = i2cSetSlaveAddr(i2c_base, MCP23017_DEV_ID, I2C_WRITE);
-	if(!status==I2C_OK) return status;
-
-  // Send the address of GPIOB to the port expander
-	status = i2cSendByte(i2c_base, PEXP_GPIOB_ADDR, I2C_MCS_START | I2C_MCS_RUN);
-	if(!status==I2C_OK) return status;
-
-  //==============================================================
-  // Read from the port expander
-  //==============================================================
+	uint8_t gpiob_addr = PEXP_GPIOB_ADDR;
+	i2c_status_t status;
 	
-	// Set the Slave address as a read to get the GPIOB values
-	status = i2cSetSlaveAddr(i2c_base, MCP23017_DEV_ID, I2C_READ);
-	if(!status==I2C_OK) return status;
-
-  // Read the GPIOB values
-	status = i2cGetByte(i2c_base, data, I2C_MCS_START | I2C_MCS_RUN | I2C_MCS_STOP);
-	if(!status==I2C_OK) return status;
+	// Write the GPIOB address and read it back after a repeated START
+	status = i2c_transfer(i2c_base, MCP23017_DEV_ID, &gpiob_addr, 1, data, 1);
+	if(status != I2C_OK) return status;
 	
 	*data = ~*data;
 	
@@ -52,6 +57,41 @@ i2c_status_t pexp_read_buttons
 }
 
 
+//*****************************************************************************
+// Queues a read of the push buttons without waiting on the bus.  
+//
+// Paramters
+//    i2c_base:   a valid base address of an I2C peripheral
+//
+//    xfer:       descriptor owned by the caller until the callback runs
+//
+//    data:       raw GPIOB value, a pressed button reads as 0
+//
+//    callback:   called from the I2C ISR when the read finishes
+//
+// Returns
+// I2C_OK if the read was queued.
+//*****************************************************************************
+i2c_status_t pexp_read_buttons_async
+( 
+  uint32_t  			i2c_base,
+	i2c_xfer_t			*xfer,
+  uint8_t   			*data,
+	i2c_callback_t	callback
+)
+{
+	static const uint8_t gpiob_addr = PEXP_GPIOB_ADDR;
+	
+	xfer->dev_id = MCP23017_DEV_ID;
+	xfer->wr_data = &gpiob_addr;
+	xfer->wr_len = 1;
+	xfer->rd_data = data;
+	xfer->rd_len = 1;
+	xfer->callback = callback;
+	
+	return i2cSubmit(i2c_base, xfer);
+}
+
 //*****************************************************************************
 // Initializes the port expander's GPIO B ports to be inputs and pull-up
 //
@@ -68,44 +108,44 @@ i2c_status_t pexp_button_config
 {
   i2c_status_t status;
   
-  // Before doing anything, make sure the I2C device is idle
-  while ( I2CMasterBusy(i2c_base)) 
-	{
-	};
+	// Set the pins to be inputs by writing all ones to the direction register
+	status = pexp_write_reg(i2c_base, PEXP_GPIOB_DIR, 0xFF);
+	if(status != I2C_OK) return status;
 
-  //==============================================================
-  // Set the pins to be inputs
-  //==============================================================
-	
-	// Set the Slave address as a write to send the direction address
-	status = i2cSetSlaveAddr(i2c_base, MCP23017_DEV_ID, I2C_WRITE);
-	if(!status==I2C_OK) return status;
-	
-	// Send the address of the direction register to the port expander
-  status = i2cSendByte(i2c_base, PEXP_GPIOB_DIR, I2C_MCS_START | I2C_MCS_RUN);
-	if(!status==I2C_OK) return status;
+	// Enable all of the pull-ups
+	return pexp_write_reg(i2c_base, PEXP_GPIOB_PU, 0xFF);
+}
 
-	// Set the DIR to be inputs by writing all ones
-	status = i2cSendByte(i2c_base, 0xFF, I2C_MCS_RUN | I2C_MCS_STOP);
-	if(!status==I2C_OK) return status;
+//*****************************************************************************
+// Enables interrupt-on-change for the push buttons on INTB
+//
+// Paramters
+//    i2c_base:   a valid base address of an I2C peripheral
+//
+// Returns
+// I2C_OK if completed without error.
+//*****************************************************************************
+i2c_status_t pexp_irq_config
+( 
+  uint32_t  i2c_base
+)
+{
+  i2c_status_t status;
+	uint8_t data;
 
-  //==============================================================
-  // Set the pins to be pull up
-  //==============================================================
-	
-	// Set the Slave address as a write to send the pull-up address
-	status = i2cSetSlaveAddr(i2c_base, MCP23017_DEV_ID, I2C_WRITE);
-	if(!status==I2C_OK) return status;
+	// Open-drain INT pins, active low
+	status = pexp_write_reg(i2c_base, PEXP_IOCON, PEXP_IOCON_ODR);
+	if(status != I2C_OK) return status;
 
-	// Send the address of the pull-up to the port expander
-  status = i2cSendByte(i2c_base, PEXP_GPIOB_PU, I2C_MCS_START | I2C_MCS_RUN);
-	if(!status==I2C_OK) return status;
+	// Compare against the previous pin value rather than DEFVAL
+	status = pexp_write_reg(i2c_base, PEXP_INTCONB, 0x00);
+	if(status != I2C_OK) return status;
 
-	// Set the pull-up to be inputs by writing all ones
-	status = i2cSendByte(i2c_base, 0xFF, I2C_MCS_RUN | I2C_MCS_STOP);
-	if(!status==I2C_OK) return status;
-	
-  return status;
+	status = pexp_write_reg(i2c_base, PEXP_GPINTENB, PEXP_BUTTON_M);
+	if(status != I2C_OK) return status;
+
+	// Reading GPIOB releases INTB in case a button was already down
+	return pexp_read_buttons(i2c_base, &data);
 }
 
 //*****************************************************************************
@@ -168,6 +208,12 @@ bool port_expander_init(void)
   }
 	
 	pexp_button_config(I2C1_BASE);
+	
+	// INTB idles high through the launchpad's SW2 pull-up
+	if(pexp_irq_config(PEXP_I2C_BASE) != I2C_OK)
+	{
+		return false;
+	}
   
   return true;
   
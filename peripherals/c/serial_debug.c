@@ -19,8 +19,17 @@ static bool Rx_Interrupts_Enabled = false;
 static bool Tx_Interrupts_Enabled = false;
 
 
-PC_Buffer UART0_Tx_Buffer;
-PC_Buffer UART0_Rx_Buffer;
+RING_DEFINE(UART0_Tx_Buffer, char, UART_TX_BUFFER_SIZE);
+RING_DEFINE(UART0_Rx_Buffer, char, UART_RX_BUFFER_SIZE);
+
+#ifdef SERIAL_DEBUG_TX_DMA
+// Bytes of the TX buffer given to the primary [0] and alternate [1] control
+// structures, 0 while a structure is free
+static uint32_t Tx_Dma_Len[2];
+
+// The structure the controller finishes next
+static uint8_t Tx_Dma_Next = 0;
+#endif
 
 
 //************************************************************************
@@ -60,15 +69,27 @@ bool init_serial_debug(bool enable_rx_irq, bool enable_tx_irq)
   Rx_Interrupts_Enabled = enable_rx_irq;
   Tx_Interrupts_Enabled = enable_tx_irq;
   
-  // Initialize the circular buffer(s)
-  pc_buffer_init(&UART0_Tx_Buffer, UART_BUFFER_SIZE);
-  pc_buffer_init(&UART0_Rx_Buffer, UART_BUFFER_SIZE); 
-  
+#ifdef SERIAL_DEBUG_TX_DMA
+  // The DMA completion interrupt replaces the TX interrupt
+  if( uart_init(SERIAL_DEBUG_UART_BASE,enable_rx_irq, false) == false)
+  { 
+    return false;
+  }
   
+  if( enable_tx_irq)
+  {
+    udma_init();
+    udma_assign(UDMA_CH_UART0_TX, UDMA_ENC_UART0_TX);
+    UART0->DMACTL |= UART_DMACTL_TXDMAE;
+    NVIC_SetPriority(UART0_IRQn, 0);
+    NVIC_EnableIRQ(UART0_IRQn);
+  }
+#else
   if( uart_init(SERIAL_DEBUG_UART_BASE,enable_rx_irq, enable_tx_irq) == false)
   { 
     return false;
   }
+#endif
   
   return true;
 }
@@ -76,77 +97,195 @@ bool init_serial_debug(bool enable_rx_irq, bool enable_tx_irq)
 /****************************************************************************
  *
  ****************************************************************************/
-int serial_debug_rx(PC_Buffer *rx_buffer, bool block)
+int serial_debug_rx(ring_t *rx_buffer, bool block)
 {
-	int c;
+	uint8_t c;
 	
-	while (pc_buffer_empty(rx_buffer))
+	// The ISR only ever adds to the ring, so no need to mask it
+	while (!ring_pop_byte(rx_buffer, &c))
 	{
 		if (!block)
 			return -1;
 	}
 
-	// ADD CODE
-	// Remove data from the circular buffer.  Make sure this is an
-	// atomic operation.
-	DisableInterrupts();
-	pc_buffer_remove(rx_buffer, (char*)(&c));
-	EnableInterrupts();
-
 	return c;
 }
 
-/****************************************************************************
- *
- ****************************************************************************/
-void serial_debug_tx(uint32_t uart_base, PC_Buffer *tx_buffer, int data)
+//*****************************************************************************
+// Moves bytes from the circular buffer to the hardware FIFO until the FIFO
+// is full or the buffer is empty.  Bytes are taken straight from the
+// ring's storage and released together.  Only one context may run this at
+// a time: the TX ISR, or the main loop with the TX interrupt masked.  With
+// uDMA it only runs while no transfer is in flight.
+//*****************************************************************************
+static void serial_debug_tx_fill(UART0_Type *uart, ring_t *tx_buffer)
 {
-  UART0_Type *uart = (UART0_Type *)(uart_base);
-  bool  tx_buffer_full;
-  bool  tx_buffer_empty;
-  bool  fifo_full;
+  const uint8_t *span;
+  uint32_t count, sent;
   
-  // ADD/MODIFY CODE
+  do
+  {
+    count = ring_read_span(tx_buffer, (const void **)&span);
+    for(sent = 0; sent < count && !(uart->FR & UART_FR_TXFF); sent++)
+    {
+      uart->DR = span[sent];
+    }
+    ring_consume(tx_buffer, sent);
+  } while(sent == count && count > 0);
+}
+
+#ifdef SERIAL_DEBUG_TX_DMA
+//*****************************************************************************
+// Keeps the DMA channel fed from the circular buffer.  The bytes are sent
+// from the ring's own storage, so they are only removed from the ring once
+// the controller has finished with them.  Each control structure covers one
+// contiguous span, and the second is filled while the first is sent.
+//
+// Runs from the UART ISR when a transfer finishes, with refill set, and
+// from the main loop with interrupts masked after adding to the buffer.
+// The main loop only starts an idle channel.  Were it to queue each write
+// as it came, a stream of short writes would become a stream of short
+// transfers, each with its own interrupt.  Left to the ISR, everything
+// added while a transfer ran goes out as one.
+//*****************************************************************************
+static void serial_debug_tx_dma(UART0_Type *uart, ring_t *tx_buffer, bool refill)
+{
+  const void *span;
+  uint32_t count;
+  uint8_t alt, i;
   
-  // Determine if the hw fifo is full
-  fifo_full = uart->FR & UART_FR_TXFF; /*MODIFIED*/
+  while(1)
+  {
+    // Release what the controller has finished, in the order it ran
+    while(Tx_Dma_Len[Tx_Dma_Next] != 0 && udma_stopped(UDMA_CH_UART0_TX, Tx_Dma_Next))
+    {
+      ring_consume(tx_buffer, Tx_Dma_Len[Tx_Dma_Next]);
+      Tx_Dma_Len[Tx_Dma_Next] = 0;
+      Tx_Dma_Next ^= 1;
+    }
+    
+    // With nothing in flight, top the FIFO up directly.  Short writes then
+    // do not cost a transfer at all, and DMA only carries what the FIFO
+    // cannot take.
+    if(Tx_Dma_Len[0] == 0 && Tx_Dma_Len[1] == 0)
+    {
+      serial_debug_tx_fill(uart, tx_buffer);
+    }
+    else if(!refill)
+    {
+      return;
+    }
+    
+    // Hand the bytes after those in flight to the free structures, the one
+    // that runs next first
+    for(i = 0, alt = Tx_Dma_Next; i < 2; i++, alt ^= 1)
+    {
+      if(Tx_Dma_Len[alt] != 0)
+      {
+        continue;
+      }
+      count = ring_peek_span(tx_buffer, Tx_Dma_Len[alt ^ 1], &span);
+      if(count == 0)
+      {
+        break;
+      }
+      if(count > UDMA_MAX_TRANSFER)
+      {
+        count = UDMA_MAX_TRANSFER;
+      }
+      udma_arm_tx(UDMA_CH_UART0_TX, alt, span, &uart->DR, count);
+      Tx_Dma_Len[alt] = count;
+    }
+    
+    // The controller disables the channel when it finds the other structure
+    // stopped.  Restart it, unless the structure it would start with was
+    // finished in the meantime, in which case release that one first.
+    if(Tx_Dma_Len[Tx_Dma_Next] == 0 || udma_enabled(UDMA_CH_UART0_TX))
+    {
+      return;
+    }
+    if(!udma_stopped(UDMA_CH_UART0_TX, Tx_Dma_Next))
+    {
+      udma_start(UDMA_CH_UART0_TX, Tx_Dma_Next);
+      return;
+    }
+  }
+}
+
+//*****************************************************************************
+// Starts sending after the main loop has added to the circular buffer.
+// Interrupts are masked so the ISR does not run the DMA bookkeeping at the
+// same time.
+//*****************************************************************************
+static void serial_debug_tx_kick(uint32_t uart_base, ring_t *tx_buffer)
+{
+  uint32_t primask;
   
-  // Determine if the pc_buffer is empty
-  tx_buffer_empty = pc_buffer_empty(tx_buffer); /*MODIFY*/
+  primask = __get_PRIMASK();
+  __disable_irq();
+  serial_debug_tx_dma((UART0_Type *)(uart_base), tx_buffer, false);
+  __set_PRIMASK(primask);
+}
+#else
+//*****************************************************************************
+// Starts sending after the main loop has added to the circular buffer.  The
+// TX interrupt only fires when the FIFO drains past its trigger level, so
+// the FIFO has to be primed here.  The ISR is kept out while this side
+// removes from the buffer.
+//*****************************************************************************
+static void serial_debug_tx_kick(uint32_t uart_base, ring_t *tx_buffer)
+{
+  UART0_Type *uart = (UART0_Type *)(uart_base);
+  
+  uart->IM &= ~UART_IM_TXIM;
+  serial_debug_tx_fill(uart, tx_buffer);
   
-  // If there is space in the hardwere FIFO, and the circular
-  // buffer is empty, send the data to the FIFO.
-  if( (!fifo_full) & tx_buffer_empty )
+  // The ISR sends the rest as the FIFO drains
+  if(!ring_empty(tx_buffer))
   {
-    // ADD CODE
-    // write data to HW FIFO
-		uart->DR = (char)data;
+    uart->IM |= UART_IM_TXIM;
   }
-  else
+}
+#endif
+
+/****************************************************************************
+ * Blocking, waits for room in the circular buffer.  Used by stdio.
+ ****************************************************************************/
+void serial_debug_tx(uint32_t uart_base, ring_t *tx_buffer, int data)
+{
+  // Sending from here as well keeps this moving with interrupts disabled
+  while(!ring_push_byte(tx_buffer, (uint8_t)data))
   {
-    // Test to see if the circular buffer is full
-    // If it is, we wait until there is space.
-    do
-    {
-        // determine if the tx circular buffer is full
-        tx_buffer_full = pc_buffer_full(tx_buffer); /*MODIFY*/
-    } while(tx_buffer_full);
-
-    // ADD CODE
-    // Add the character to the circular buffer.   Make sure this is an
-    // atomic operation.
-		DisableInterrupts();
-		pc_buffer_add(tx_buffer, (char)data);
-		EnableInterrupts();
-    
+    serial_debug_tx_kick(uart_base, tx_buffer);
   }
+  serial_debug_tx_kick(uart_base, tx_buffer);
+}
+
+/****************************************************************************
+ * Never blocks.  Queues as much of data as fits.
+ ****************************************************************************/
+uint32_t serial_debug_write(uint32_t uart_base, ring_t *tx_buffer, const char *data, uint32_t len)
+{
+  uint32_t accepted;
   
-  // ADD CODE
-  // If you're in this function, you want to send data
-  // so enable TX interrupts even if they are already enabled.
-	uart->IM |= UART_IM_TXIM;
+  accepted = ring_push_bulk(tx_buffer, data, len);
+  if(accepted > 0)
+  {
+    serial_debug_tx_kick(uart_base, tx_buffer);
+  }
+  return accepted;
+}
 
-  return;
+/****************************************************************************
+ * Keeps kicking the transmitter, which also makes progress with interrupts
+ * disabled, until the buffer is empty
+ ****************************************************************************/
+void serial_debug_tx_drain(uint32_t uart_base, ring_t *tx_buffer)
+{
+  while(!ring_empty(tx_buffer))
+  {
+    serial_debug_tx_kick(uart_base, tx_buffer);
+  }
 }
 
 
@@ -183,7 +322,7 @@ int fgetc(FILE* stream)
 int fputc(int c, FILE* stream)
 {
    uint32_t uart_base;
-   PC_Buffer *tx_buffer;
+   ring_t *tx_buffer;
 
    if ( Tx_Interrupts_Enabled)
    {
@@ -218,58 +357,50 @@ int fputc(int c, FILE* stream)
 //*****************************************************************************
 // Rx Portion of the UART ISR Handler
 //*****************************************************************************
-__INLINE static void UART_Rx_Flow(uint32_t uart_base, PC_Buffer *rx_buffer)
+__INLINE static void UART_Rx_Flow(uint32_t uart_base, ring_t *rx_buffer)
 {
   UART0_Type *uart = (UART0_Type *)(uart_base);
+  uint8_t fifo[UART_HW_FIFO_SIZE];
+  uint32_t count = 0;
   
-  // ADD CODE  
+  // Clear the RX interrupts before emptying the FIFO.  A byte that arrives
+  // after the last read then raises them again; cleared afterwards, it
+  // would sit in the FIFO with no interrupt until the FIFO overran.
+	uart->ICR |= (UART_ICR_RTIC|UART_ICR_RXIC);
   
-  // Remove entries from the RX FIFO and place them in the circular buffer.  Return
-  // once the RX FIFO is empty.
-	while(!(uart->FR & UART_FR_RXFE)){
-		
-		char c = uart->DR;
-		pc_buffer_add(rx_buffer, c);
+  // Empty the RX FIFO, then place all of it in the circular buffer with one
+  // copy.  Bytes that do not fit are dropped.
+	while(!(uart->FR & UART_FR_RXFE) && count < UART_HW_FIFO_SIZE){
+		fifo[count++] = uart->DR;
 	}
-  // Clear the RX interrupts so it can trigger again when the hardware 
-  // FIFO becomes full
-	uart->ICR |= (UART_ICR_RTIC|UART_ICR_RXIC);
+	ring_push_bulk(rx_buffer, fifo, count);
   
 }
 
+#ifndef SERIAL_DEBUG_TX_DMA
 //*****************************************************************************
 // Tx Portion of the UART ISR Handler
 //*****************************************************************************
-__INLINE static void UART_Tx_Flow(uint32_t uart_base, PC_Buffer *tx_buffer)
+__INLINE static void UART_Tx_Flow(uint32_t uart_base, ring_t *tx_buffer)
 {
     UART0_Type *uart = (UART0_Type *)(uart_base);    
-    char c;
-    bool tx_buffer_empty;
   
-   // ADD CODE   
-   // Check to see if we have any data in the circular buffer
-    tx_buffer_empty = uart->FR & UART_FR_TXFE; /*modify*/
+    // Refill the hardware FIFO from the circular buffer
+    serial_debug_tx_fill(uart, tx_buffer);
   
-    if( !tx_buffer_empty)
+    // Disable the TX interrupts once the circular buffer has drained.  The
+    // next write turns them back on.
+    if( ring_empty(tx_buffer))
     {
-        // Move data from the circular queue to the hardware FIFO
-        // until the hardware FIFO is full OR the circular buffer
-        // becomes empty.
-			while(!((uart->FR & UART_FR_TXFF) | pc_buffer_empty(tx_buffer))){
-				pc_buffer_remove(tx_buffer, (char*)&uart->DR);
-			}
-    }
-    else
-    {
-        // Disable the TX interrupts.
 			uart->IM &= ~UART_IM_TXIM;
     }
     
     // Clear the TX interrupt so it can trigger again when the hardware
     // FIFO is empty
-			uart->ICR |= (UART_ICR_TXIC);
+			uart->ICR = UART_ICR_TXIC;
 
 }
+#endif
 
 //*****************************************************************************
 // UART0 Interrupt Service handler
@@ -278,7 +409,9 @@ void UART0_Handler(void)
 {
     uint32_t  status;
     uint32_t  rx_mask   = 0 ;
+#ifndef SERIAL_DEBUG_TX_DMA
 		uint32_t  tx_mask   = 0 ;
+#endif
 
     // ADD CODE  
     // Read the interrupt status of the UART
@@ -286,15 +419,24 @@ void UART0_Handler(void)
 
     // set rx_mask to detect both Rx related interrupts.
 		rx_mask = UART_MIS_RXMIS | UART_MIS_RTMIS; /*modify*/
+#ifndef SERIAL_DEBUG_TX_DMA
 		tx_mask = UART_MIS_TXMIS;
+#endif
 	
     if ( status & rx_mask)
     {
       UART_Rx_Flow(UART0_BASE, &UART0_Rx_Buffer);
     }
+#ifdef SERIAL_DEBUG_TX_DMA
+		// A finished TX transfer is signalled on this vector as well
+		if (udma_irq_clear(UDMA_CH_UART0_TX)) {
+			serial_debug_tx_dma(UART0, &UART0_Tx_Buffer, true);
+		}
+#else
 		if (status & tx_mask) {
 			UART_Tx_Flow(UART0_BASE, &UART0_Tx_Buffer);
 		}
+#endif
     
     return;
 }
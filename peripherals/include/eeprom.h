@@ -9,6 +9,17 @@
 #define MCP24LC32AT_DEV_ID				0x50
 #define EEPROM_TEST_NUM_BYTES    	20
 
+// Page writes may not cross a 32-byte boundary
+#define EEPROM_PAGE_SIZE					32
+#define EEPROM_SIZE								4096
+
+// Address polls before a write cycle is given up on.  Each poll takes about
+// 30us and the 24LC32 finishes a write within 5ms.
+#define EEPROM_WRITE_POLLS				500
+
+// Page sized entries held by the write-behind queue
+#define EEPROM_QUEUE_DEPTH				8
+
 //*****************************************************************************
 // Fill out the #defines below to configure which pins are connected to
 // the I2C Bus
@@ -64,6 +75,128 @@ i2c_status_t eeprom_byte_read
   uint8_t   *data
 );
 
+//*****************************************************************************
+// Reads len consecutive bytes from the  MCP24LC32AT EEPROM using sequential
+// reads.  The address is sent once and the EEPROM auto-increments.
+//
+// Paramters
+//    i2c_base:   a valid base address of an I2C peripheral
+//
+//    address:    address of the first byte
+//
+//    data:       buffer for the bytes read
+//
+//    len:        number of bytes to read
+//
+// Returns
+// I2C_OK if all of the bytes were read from the EEPROM.
+//*****************************************************************************
+i2c_status_t eeprom_read
+( 
+  uint32_t  i2c_base,
+  uint16_t  address,
+  uint8_t   *data,
+  uint16_t  len
+);
+
+//*****************************************************************************
+// Writes len consecutive bytes to the  MCP24LC32AT EEPROM using page writes.
+// The data is split at 32-byte page boundaries, so it costs one write cycle
+// per page touched.
+//
+// Paramters
+//    i2c_base:   a valid base address of an I2C peripheral
+//
+//    address:    address of the first byte
+//
+//    data:       bytes to write
+//
+//    len:        number of bytes to write
+//
+// Returns
+// I2C_OK if all of the bytes were written to the EEPROM.
+//*****************************************************************************
+i2c_status_t eeprom_write
+( 
+  uint32_t  i2c_base,
+  uint16_t  address,
+  const uint8_t *data,
+  uint16_t  len
+);
+
+//*****************************************************************************
+// Queues len bytes to be written to the  MCP24LC32AT EEPROM and returns
+// without touching the bus.  The queue is drained one page write at a time
+// by eeprom_queue_step.  Writes are applied in the order they were queued.
+// If the queue is full the oldest entries are written out first, which
+// blocks.
+//
+// Paramters
+//    i2c_base:   a valid base address of an I2C peripheral
+//
+//    address:    address of the first byte
+//
+//    data:       bytes to write, copied into the queue
+//
+//    len:        number of bytes to write
+//
+// Returns
+// I2C_OK if all of the bytes were queued.
+//*****************************************************************************
+i2c_status_t eeprom_queue_write
+( 
+  uint32_t  i2c_base,
+  uint16_t  address,
+  const uint8_t *data,
+  uint16_t  len
+);
+
+//*****************************************************************************
+// Reads len consecutive bytes like eeprom_read, with any bytes still in the
+// write-behind queue laid over the result so reads see queued writes.
+//
+// Paramters
+//    i2c_base:   a valid base address of an I2C peripheral
+//
+//    address:    address of the first byte
+//
+//    data:       buffer for the bytes read
+//
+//    len:        number of bytes to read
+//
+// Returns
+// I2C_OK if all of the bytes were read from the EEPROM.
+//*****************************************************************************
+i2c_status_t eeprom_queue_read
+( 
+  uint32_t  i2c_base,
+  uint16_t  address,
+  uint8_t   *data,
+  uint16_t  len
+);
+
+//*****************************************************************************
+// Writes the oldest queued page if the EEPROM has finished its last write
+// cycle.  Never waits on a write cycle, so it can be called every tick.
+//
+// Returns
+// The number of bytes still waiting in the queue.
+//*****************************************************************************
+uint16_t eeprom_queue_step(void);
+
+//*****************************************************************************
+// Writes everything in the queue, waiting on each write cycle.
+//
+// Returns
+// I2C_OK once the queue is empty, or the error that stopped it.
+//*****************************************************************************
+i2c_status_t eeprom_queue_flush(void);
+
+//*****************************************************************************
+// Returns the number of bytes waiting in the write-behind queue
+//*****************************************************************************
+uint16_t eeprom_queue_pending(void);
+
 //*****************************************************************************
 // Initialize the EEPROM peripheral
 //*****************************************************************************
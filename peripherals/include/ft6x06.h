@@ -21,6 +21,11 @@
 #define 	FT6X06_I2C_SDA_PCTL_M		 GPIO_PCTL_PA7_M
 #define   FT6X06_I2C_SDA_PIN_PCTL  GPIO_PCTL_PA7_I2C1SDA
 
+//*****************************************************************************
+// INT is jumpered to PF4, the launchpad's SW1 pin, and uses SW1's pull-up.
+// SW1 reads as pressed while INT is low, so input.c keeps SW1 at its last
+// level until the report INT announced has been read.
+//*****************************************************************************
 #define   FT6X06_IRQ_GPIO_BASE     GPIOF_BASE
 #define   FT6X06_IRQ_PIN_NUM       PF4
 
@@ -62,12 +67,93 @@
 #define FT6X06_REALEASE_CODE_ID_R     0xAF
 #define FT6X06_STATE_R                0xBC
 
+// G_MODE values.  Trigger mode pulses INT low once per new touch report.
+#define FT6X06_G_MODE_POLLING         0x00
+#define FT6X06_G_MODE_TRIGGER         0x01
+
 
 //*****************************************************************************
 // Read the X value of last touch event
 //*****************************************************************************
 uint8_t ft6x06_read_td_status(void);
 
+// Event flag in the upper two bits of Pn_XH
+#define FT6X06_EVENT_PRESS_DOWN       0x00
+#define FT6X06_EVENT_LIFT_UP          0x01
+#define FT6X06_EVENT_CONTACT          0x02
+#define FT6X06_EVENT_NONE             0x03
+
+// TD_STATUS through P2_MISC
+#define FT6X06_TOUCH_BYTES            (FT6X06_P2_MISC_R - FT6X06_TD_STATUS_R + 1)
+
+// Number of reports kept in a touch history.  Must be a power of 2.
+#define FT6X06_HISTORY_LEN            8
+
+typedef struct {
+  uint16_t  x;
+  uint16_t  y;
+  uint8_t   event;    // FT6X06_EVENT_*
+  uint8_t   id;       // touch ID, follows a finger between reports
+  uint8_t   weight;
+  uint8_t   area;
+} ft6x06_point_t;
+
+typedef struct {
+  uint8_t         touches;    // 0, 1 or 2.  Only that many points are valid.
+  ft6x06_point_t  point[2];
+} ft6x06_touch_t;
+
+typedef struct {
+  ft6x06_touch_t  report[FT6X06_HISTORY_LEN];
+  uint8_t         head;       // next slot to write
+  uint8_t         count;      // number of valid reports, up to FT6X06_HISTORY_LEN
+} ft6x06_history_t;
+
+//*****************************************************************************
+// Reads TD_STATUS, both touch points and their event flags in a single
+// transaction and fills in report.
+//
+// Returns
+// I2C_OK if the report was read.  report->touches is 0 on any error.
+//*****************************************************************************
+i2c_status_t ft6x06_read_touch(ft6x06_touch_t *report);
+
+//*****************************************************************************
+// Queues the same read as ft6x06_read_touch without waiting on the bus.
+// buf must hold FT6X06_TOUCH_BYTES and be decoded with ft6x06_decode_touch
+// once the callback has run.
+//*****************************************************************************
+i2c_status_t ft6x06_read_touch_async(i2c_xfer_t *xfer, uint8_t *buf, i2c_callback_t callback);
+
+//*****************************************************************************
+// Decodes FT6X06_TOUCH_BYTES read from TD_STATUS onwards into report
+//*****************************************************************************
+void ft6x06_decode_touch(const uint8_t *buf, ft6x06_touch_t *report);
+
+//*****************************************************************************
+// Adds a report to a history ring, overwriting the oldest once it is full
+//*****************************************************************************
+void ft6x06_history_push(ft6x06_history_t *history, const ft6x06_touch_t *report);
+
+//*****************************************************************************
+// Averages the first touch point over the newest n reports of a history.
+// Stops at the first report without a touch so separate presses are not
+// mixed.
+//
+// Returns
+// true if at least one report had a touch and x/y were written
+//*****************************************************************************
+bool ft6x06_history_average(const ft6x06_history_t *history, uint8_t n, uint16_t *x, uint16_t *y);
+
+//*****************************************************************************
+// Movement of the first touch point from the oldest to the newest report of
+// the current press, for swipe detection.
+//
+// Returns
+// true if the newest report has a touch and dx/dy were written
+//*****************************************************************************
+bool ft6x06_history_delta(const ft6x06_history_t *history, int16_t *dx, int16_t *dy);
+
 //*****************************************************************************
 // Read the X value of last touch event
 //*****************************************************************************
@@ -33,6 +33,15 @@ typedef enum {
   CENTER
 } lcd_justify_t;
 
+//*****************************************************************************
+// Receives a copy of every window and pixel sent to the LCD, see
+// lcd_set_mirror.  Pixels fill the last window row by row.
+//*****************************************************************************
+typedef struct {
+  void (*window)(uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1);
+  void (*pixel)(uint16_t color);
+} lcd_mirror_t;
+
 #define LINE_HIGH     0xFF
 #define LINE_LOW      0x00
 
@@ -187,6 +196,20 @@ void lcd_set_pos(
   uint16_t y1     // Y coordinate for the end of the box
 );
 
+/*******************************************************************************
+* Function Name: lcd_set_mirror
+********************************************************************************
+* Summary: Copies every window set with lcd_set_pos and every pixel drawn
+*          into it to the mirror's handlers.  Pass NULL to stop.  The
+*          handlers run inside the drawing loops, so they must be short.
+*
+* Return:
+*  Nothing
+*******************************************************************************/
+void lcd_set_mirror(
+  const lcd_mirror_t *mirror
+);
+
 /*******************************************************************************
 * Function Name: lcd_clear_screen
 ********************************************************************************
@@ -199,6 +222,23 @@ void lcd_clear_screen(
   uint16_t bColor   //  Color to paint the entire screen with
 );
 
+/*******************************************************************************
+* Function Name: lcd_fill_rect
+********************************************************************************
+* Summary: fills the box from x0,y0 to x1,y1 (inclusive) with the provided
+*          color.  Used to repaint part of the screen without a full clear.
+*
+* Return:
+*  Nothing
+*******************************************************************************/
+void lcd_fill_rect(
+  uint16_t x0,      // X coordinate for the start of the box
+  uint16_t x1,      // X coordinate for the end of the box
+  uint16_t y0,      // Y coordinate for the start of the box
+  uint16_t y1,      // Y coordinate for the end of the box
+  uint16_t color    // Color to paint the box with
+);
+
 
 /*******************************************************************************
 * Function Name: lcd_draw_box
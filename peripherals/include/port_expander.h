@@ -1,5 +1,5 @@
-#ifndef __EEPROM_H__
-#define __EEPROM_H__
+#ifndef __PORT_EXPANDER_H__
+#define __PORT_EXPANDER_H__
 
 
 #include <stdint.h>
@@ -37,6 +37,23 @@
 #define		PEXP_GPIOB_DIR				0x01
 #define		PEXP_GPIOB_PU					0x0D
 #define		PEXP_GPIOB_POL				0x04
+#define		PEXP_GPINTENB					0x05
+#define		PEXP_INTCONB					0x09
+#define		PEXP_IOCON						0x0A
+#define		PEXP_INTCAPB					0x11
+
+// IOCON.ODR makes INTB open-drain so it can share a line with a launchpad switch
+#define		PEXP_IOCON_ODR				0x04
+
+//*****************************************************************************
+// Defining the interrupt line.  On our board INTB is jumpered to PF0, the
+// launchpad's SW2 pin, and uses SW2's pull-up (GPIOA of the expander and
+// INTA are not connected).  While INTB is asserted SW2 reads as pressed, so
+// input.c keeps SW2 at its last level until the expander has been read and
+// INTB released.
+//*****************************************************************************
+#define		PEXP_IRQ_GPIO_BASE		GPIOF_BASE
+#define		PEXP_IRQ_PIN_NUM			PF0
 
 //*****************************************************************************
 // Reads a single byte of data from the  MCP24LC32AT EEPROM.  
@@ -62,11 +79,47 @@ i2c_status_t pexp_read_buttons
 
 
 
+//*****************************************************************************
+// Queues a read of the push buttons without waiting on the bus.
+//
+// Paramters
+//    i2c_base:   a valid base address of an I2C peripheral
+//
+//    xfer:       descriptor owned by the caller until the callback runs
+//
+//    data:       raw GPIOB value.  Unlike pexp_read_buttons it is not
+//                inverted, so a pressed button reads as 0.
+//
+//    callback:   called from the I2C ISR when the read finishes
+//
+// Returns
+// I2C_OK if the read was queued.
+//*****************************************************************************
+i2c_status_t pexp_read_buttons_async
+(
+	uint32_t  			i2c_base,
+	i2c_xfer_t			*xfer,
+	uint8_t   			*data,
+	i2c_callback_t	callback
+);
+
 //*****************************************************************************
 // Initialize the Port Expander peripheral
 //*****************************************************************************
 bool port_expander_init(void);
 i2c_status_t pexp_button_config ( uint32_t  i2c_base );
 
+//*****************************************************************************
+// Enables interrupt-on-change for the push buttons.  INTB is pulled low on any
+// change and stays low until GPIOB or INTCAPB is read.
+//
+// Paramters
+//    i2c_base:   a valid base address of an I2C peripheral
+//
+// Returns
+// I2C_OK if completed without error.
+//*****************************************************************************
+i2c_status_t pexp_irq_config ( uint32_t  i2c_base );
+
 
 #endif
@@ -17,11 +17,26 @@
  #define __SERIAL_DEBUG_H__
 
 #include "gpio_port.h"
-#include "pc_buffer.h"
+#include "ring_buffer.h"
 #include "uart.h"
+#include "udma.h"
 #include "driver_defines.h"
 
-#define UART_BUFFER_SIZE 80
+// Must be powers of 2.  TX is deep enough to hold a burst of LCD mirror
+// records drawn in one frame while the UART drains it.
+#define UART_TX_BUFFER_SIZE 1024
+#define UART_RX_BUFFER_SIZE 128
+
+// Depth of the UART's hardware FIFOs
+#define UART_HW_FIFO_SIZE 16
+
+// When TX interrupts are enabled, the uDMA controller moves the TX buffer
+// to the UART in place, up to a contiguous run of the ring per interrupt
+// instead of one interrupt per 16 bytes.  Define SERIAL_DEBUG_TX_IRQ in the
+// build to refill the FIFO from the TX interrupt instead.
+#ifndef SERIAL_DEBUG_TX_IRQ
+#define SERIAL_DEBUG_TX_DMA
+#endif
 
 struct __FILE 
 {
@@ -43,10 +58,8 @@ extern FILE *BLUETOOTH;
 extern void DisableInterrupts(void);
 extern void EnableInterrupts(void);
 
-extern PC_Buffer UART0_Tx_Buffer;
-extern PC_Buffer UART0_Rx_Buffer;
-extern PC_Buffer UART5_Tx_Buffer;
-extern PC_Buffer UART5_Rx_Buffer;
+extern ring_t UART0_Tx_Buffer;
+extern ring_t UART0_Rx_Buffer;
 
 
 //*****************************************************************************
@@ -71,11 +84,27 @@ bool init_serial_debug(bool enable_rx_irq, bool enable_tx_irq);
 /****************************************************************************
  *
  ****************************************************************************/
-int serial_debug_rx(PC_Buffer *rx_buffer, bool block);
+int serial_debug_rx(ring_t *rx_buffer, bool block);
 
 /****************************************************************************
+ * Sends one character, waiting for room in tx_buffer if it is full.
+ ****************************************************************************/
+void serial_debug_tx(uint32_t uart_base, ring_t *tx_buffer, int data);
+
+/****************************************************************************
+ * Queues up to len bytes for the TX interrupt to send and returns at once.
+ * Safe to call from the frame loop: a full buffer drops what does not fit
+ * instead of waiting.
  *
+ * Returns the number of bytes accepted.
+ ****************************************************************************/
+uint32_t serial_debug_write(uint32_t uart_base, ring_t *tx_buffer, const char *data, uint32_t len);
+
+/****************************************************************************
+ * Waits until everything in tx_buffer has been handed to the UART.  Works
+ * with interrupts disabled, so code that then writes the UART directly
+ * does not get ahead of earlier output.
  ****************************************************************************/
-void serial_debug_tx(uint32_t uart_base, PC_Buffer *tx_buffer, int data);
+void serial_debug_tx_drain(uint32_t uart_base, ring_t *tx_buffer);
 
 #endif
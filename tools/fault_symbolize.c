@@ -0,0 +1,211 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Symbolises a fault report against the Keil linker map file.
+//
+// Build on Linux from the repository root:
+//   cc -O2 -IHW4 -o fault_symbolize tools/fault_symbolize.c tools/tlm_stream.c HW4/crc16.c
+//
+// Usage:
+//   ./fault_symbolize HW4/Objects/HW4.map < capture.bin
+//       reads the telemetry stream the board sends at boot after a fault, or
+//       from the fault handler itself, and prints each TLM_FAULT record
+//   ./fault_symbolize HW4/Objects/HW4.map 0x00001234 ...
+//       looks up addresses given on the command line
+//
+// The map file needs the Image Symbol Table, which Keil writes by default.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tlm_stream.h"
+
+typedef struct {
+	char name[64];
+	char object[64];
+	uint32_t addr;
+	uint32_t size;
+} symbol_t;
+
+static symbol_t *symbols = NULL;
+static int num_symbols = 0;
+
+// Fault status bits, CFSR then HFSR
+typedef struct {
+	uint32_t mask;
+	const char *name;
+} status_bit_t;
+
+static const status_bit_t cfsr_bits[] = {
+	{ 1UL << 0,		"IACCVIOL: instruction fetch from a no-execute region" },
+	{ 1UL << 1,		"DACCVIOL: data access violation" },
+	{ 1UL << 3,		"MUNSTKERR: MPU fault on exception return" },
+	{ 1UL << 4,		"MSTKERR: MPU fault on exception entry" },
+	{ 1UL << 5,		"MLSPERR: MPU fault saving FP state" },
+	{ 1UL << 7,		"MMARVALID: mmfar holds the address" },
+	{ 1UL << 8,		"IBUSERR: bus error on instruction fetch" },
+	{ 1UL << 9,		"PRECISERR: precise data bus error" },
+	{ 1UL << 10,	"IMPRECISERR: imprecise data bus error, pc is after the access" },
+	{ 1UL << 11,	"UNSTKERR: bus error on exception return" },
+	{ 1UL << 12,	"STKERR: bus error on exception entry, likely stack overflow" },
+	{ 1UL << 13,	"LSPERR: bus error saving FP state" },
+	{ 1UL << 15,	"BFARVALID: bfar holds the address" },
+	{ 1UL << 16,	"UNDEFINSTR: undefined instruction" },
+	{ 1UL << 17,	"INVSTATE: invalid state, a call through a bad function pointer" },
+	{ 1UL << 18,	"INVPC: bad EXC_RETURN" },
+	{ 1UL << 19,	"NOCP: coprocessor used while disabled" },
+	{ 1UL << 24,	"UNALIGNED: unaligned access" },
+	{ 1UL << 25,	"DIVBYZERO: divide by zero" },
+};
+
+static const status_bit_t hfsr_bits[] = {
+	{ 1UL << 1,		"VECTTBL: bus error reading the vector table" },
+	{ 1UL << 30,	"FORCED: escalated from a configurable fault, see cfsr" },
+	{ 1UL << 31,	"DEBUGEVT: debug event" },
+};
+
+//*****************************************************************************
+// Function Name: load_map
+//*****************************************************************************
+//	Summary: Reads the code symbols out of the map file's Image Symbol Table.
+//					 The lines look like
+//					   main    0x00000a15   Thumb Code   560  main.o(.text)
+//
+//*****************************************************************************
+static bool load_map(const char *path){
+	FILE *f = fopen(path, "r");
+	char line[512], name[64], kind1[32], kind2[32], object[64];
+	unsigned long addr, size;
+	int capacity = 0;
+	
+	if(f == NULL) return false;
+	while(fgets(line, sizeof(line), f)){
+		if(sscanf(line, " %63s 0x%lx %31s %31s %lu %63s", name, &addr, kind1, kind2, &size, object) != 6) continue;
+		if(strcmp(kind2, "Code") != 0) continue;
+		
+		if(num_symbols == capacity){
+			capacity = capacity ? capacity * 2 : 256;
+			symbols = realloc(symbols, capacity * sizeof(symbol_t));
+			if(symbols == NULL) return false;
+		}
+		strcpy(symbols[num_symbols].name, name);
+		strcpy(symbols[num_symbols].object, object);
+		// Thumb symbols have bit 0 set
+		symbols[num_symbols].addr = addr & ~1UL;
+		symbols[num_symbols].size = size;
+		num_symbols++;
+	}
+	fclose(f);
+	return num_symbols > 0;
+}
+
+//*****************************************************************************
+// Function Name: print_addr
+//*****************************************************************************
+//	Summary: Prints an address and the function it falls in
+//
+//*****************************************************************************
+static void print_addr(const char *label, uint32_t addr){
+	const symbol_t *best = NULL;
+	uint32_t code = addr & ~1UL;
+	int i;
+	
+	for(i = 0; i < num_symbols; i++){
+		if(symbols[i].addr <= code && code < symbols[i].addr + symbols[i].size){
+			best = &symbols[i];
+			break;
+		}
+	}
+	printf("%-6s 0x%08lx", label, (unsigned long)addr);
+	if(best) printf("  %s+0x%lx  %s", best->name, (unsigned long)(code - best->addr), best->object);
+	printf("\n");
+}
+
+//*****************************************************************************
+// Function Name: print_bits
+//*****************************************************************************
+//	Summary: Prints the names of the status bits that are set
+//
+//*****************************************************************************
+static void print_bits(const char *label, uint32_t value, const status_bit_t *bits, int num_bits){
+	int i;
+	
+	printf("%-6s 0x%08lx\n", label, (unsigned long)value);
+	for(i = 0; i < num_bits; i++){
+		if(value & bits[i].mask) printf("         %s\n", bits[i].name);
+	}
+}
+
+//*****************************************************************************
+// Function Name: print_fault
+//*****************************************************************************
+//	Summary: Prints one TLM_FAULT record
+//
+//*****************************************************************************
+static void print_fault(const uint8_t *p){
+	uint32_t cfsr = tlm_get32(p + 16);
+	
+	printf("HARD FAULT\n");
+	print_addr("pc", tlm_get32(p));
+	print_addr("lr", tlm_get32(p + 4));
+	printf("%-6s 0x%08lx\n", "xpsr", (unsigned long)tlm_get32(p + 8));
+	printf("%-6s 0x%08lx\n", "sp", (unsigned long)tlm_get32(p + 12));
+	print_bits("cfsr", cfsr, cfsr_bits, sizeof(cfsr_bits) / sizeof(cfsr_bits[0]));
+	print_bits("hfsr", tlm_get32(p + 20), hfsr_bits, sizeof(hfsr_bits) / sizeof(hfsr_bits[0]));
+	if(cfsr & (1UL << 7)) printf("%-6s 0x%08lx\n", "mmfar", (unsigned long)tlm_get32(p + 24));
+	if(cfsr & (1UL << 15)) printf("%-6s 0x%08lx\n", "bfar", (unsigned long)tlm_get32(p + 28));
+	printf("%-6s 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n", "r0-r3", (unsigned long)tlm_get32(p + 32),
+				 (unsigned long)tlm_get32(p + 36), (unsigned long)tlm_get32(p + 40), (unsigned long)tlm_get32(p + 44));
+	printf("%-6s 0x%08lx\n", "r12", (unsigned long)tlm_get32(p + 48));
+	printf("%-6s 0x%08lx (%s stack)\n", "exc", (unsigned long)tlm_get32(p + 52),
+				 (tlm_get32(p + 52) & 4) ? "process" : "main");
+	printf("%-6s %lu\n\n", "state", (unsigned long)tlm_get32(p + 56));
+}
+
+int main(int argc, char **argv){
+	tlm_stream_t stream;
+	uint8_t rec[TLM_STREAM_MAX_ENCODED];
+	int size, i;
+	
+	if(argc < 2){
+		fprintf(stderr, "usage: fault_symbolize map_file [address...] < stream\n");
+		return 1;
+	}
+	if(!load_map(argv[1])){
+		fprintf(stderr, "no code symbols in %s\n", argv[1]);
+		return 1;
+	}
+	
+	if(argc > 2){
+		for(i = 2; i < argc; i++) print_addr("addr", strtoul(argv[i], NULL, 0));
+		return 0;
+	}
+	
+	tlm_stream_init(&stream, stdin);
+	while((size = tlm_stream_read(&stream, rec)) >= 0){
+		if(rec[0] == TLM_FAULT && size == TLM_FAULT_SIZE) print_fault(rec + TLM_HEADER_SIZE);
+	}
+	return 0;
+}
@@ -0,0 +1,301 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Host viewer for the LCD mirror records, see HW4/lcd_mirror.h.  Rebuilds
+// the 240x320 frame from the TLM_RECT records and saves it as a PNG each
+// game frame that changed it.
+//
+// Build on Linux from the repository root:
+//   cc -O2 -IHW4 -o mirror_view tools/mirror_view.c tools/tlm_stream.c HW4/crc16.c
+//
+// Usage:
+//   stty -F /dev/ttyACM0 115200 raw -echo
+//   ./mirror_view [-f] frames/run < /dev/ttyACM0
+//
+// writes frames/run_00000.png, frames/run_00001.png, ...  -f flips the image
+// vertically, the game draws with y = 0 at the bottom of the screen.
+// Areas the board reports as stale, because their records were dropped,
+// are listed on stderr and left showing their last known pixels.  A stale
+// area with no dropped records was on the screen before mirroring started,
+// so its pixels were never known; it is hatched until it is drawn.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tlm_stream.h"
+
+#define LCD_W		240
+#define LCD_H		320
+
+// Hatch for areas whose pixels were never sent, magenta on black
+#define UNKNOWN_COLOR		0xF81F
+
+static uint16_t frame[LCD_H][LCD_W];
+static bool changed = false;
+static bool flip = false;
+
+static uint32_t crc_table[256];
+
+//*****************************************************************************
+// Function Name: png_crc
+//*****************************************************************************
+//	Summary: CRC-32 of len bytes as used by PNG chunks, continuing from crc
+//
+//*****************************************************************************
+static uint32_t png_crc(uint32_t crc, const uint8_t *data, size_t len){
+	uint32_t c;
+	int n, k;
+	
+	if(crc_table[1] == 0){
+		for(n = 0; n < 256; n++){
+			c = n;
+			for(k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+			crc_table[n] = c;
+		}
+	}
+	crc ^= 0xFFFFFFFF;
+	while(len--) crc = crc_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+	return crc ^ 0xFFFFFFFF;
+}
+
+//*****************************************************************************
+// Function Name: put_be32
+//*****************************************************************************
+//	Summary: Stores a big endian 32-bit value
+//
+//*****************************************************************************
+static void put_be32(uint8_t *p, uint32_t v){
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+//*****************************************************************************
+// Function Name: png_chunk
+//*****************************************************************************
+//	Summary: Writes one PNG chunk with its length and CRC
+//
+//*****************************************************************************
+static void png_chunk(FILE *f, const char *type, const uint8_t *data, uint32_t len){
+	uint8_t word[4];
+	uint32_t crc;
+	
+	put_be32(word, len);
+	fwrite(word, 1, 4, f);
+	fwrite(type, 1, 4, f);
+	fwrite(data, 1, len, f);
+	crc = png_crc(0, (const uint8_t *)type, 4);
+	crc = png_crc(crc, data, len);
+	put_be32(word, crc);
+	fwrite(word, 1, 4, f);
+}
+
+//*****************************************************************************
+// Function Name: save_png
+//*****************************************************************************
+//	Summary: Saves the frame as an 8-bit RGB PNG.  The image data is stored
+//					 in uncompressed deflate blocks so no zlib is needed.
+//
+//*****************************************************************************
+static bool save_png(const char *path){
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	const uint32_t row_bytes = 1 + LCD_W * 3;
+	const uint32_t raw_len = row_bytes * LCD_H;
+	uint8_t ihdr[13] = { 0 };
+	uint8_t *raw, *z, *p;
+	uint32_t i, block, a = 1, b = 0, z_len;
+	int x, y, src_y;
+	uint16_t c;
+	FILE *f;
+	
+	raw = malloc(raw_len);
+	z = malloc(raw_len + raw_len / 65535 * 5 + 16);
+	if(raw == NULL || z == NULL) return false;
+	
+	// RGB565 to RGB888, filter type 0 on every row
+	p = raw;
+	for(y = 0; y < LCD_H; y++){
+		src_y = flip ? LCD_H - 1 - y : y;
+		*p++ = 0;
+		for(x = 0; x < LCD_W; x++){
+			c = frame[src_y][x];
+			*p++ = ((c >> 11) & 0x1F) * 255 / 31;
+			*p++ = ((c >> 5) & 0x3F) * 255 / 63;
+			*p++ = (c & 0x1F) * 255 / 31;
+		}
+	}
+	
+	// zlib header, stored blocks, adler32
+	p = z;
+	*p++ = 0x78;
+	*p++ = 0x01;
+	for(i = 0; i < raw_len; i += block){
+		block = raw_len - i > 65535 ? 65535 : raw_len - i;
+		*p++ = (i + block == raw_len);
+		*p++ = block & 0xFF;
+		*p++ = block >> 8;
+		*p++ = ~block & 0xFF;
+		*p++ = (~block >> 8) & 0xFF;
+		memcpy(p, raw + i, block);
+		p += block;
+	}
+	for(i = 0; i < raw_len; i++){
+		a = (a + raw[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	put_be32(p, (b << 16) | a);
+	p += 4;
+	z_len = p - z;
+	
+	f = fopen(path, "wb");
+	if(f){
+		put_be32(ihdr, LCD_W);
+		put_be32(ihdr + 4, LCD_H);
+		ihdr[8] = 8;					// bit depth
+		ihdr[9] = 2;					// truecolor
+		fwrite(signature, 1, sizeof(signature), f);
+		png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+		png_chunk(f, "IDAT", z, z_len);
+		png_chunk(f, "IEND", NULL, 0);
+		fclose(f);
+	}
+	free(raw);
+	free(z);
+	return f != NULL;
+}
+
+//*****************************************************************************
+// Function Name: draw_rect
+//*****************************************************************************
+//	Summary: Paints the runs of one TLM_RECT record into the frame
+//
+//*****************************************************************************
+static void draw_rect(const uint8_t *p, int size){
+	uint16_t x0 = tlm_get16(p), x1 = tlm_get16(p + 2);
+	uint16_t y0 = tlm_get16(p + 4), y1 = tlm_get16(p + 6);
+	uint32_t pos = tlm_get16(p + 8);
+	uint32_t width, count, x, y;
+	uint16_t color;
+	int i = TLM_RECT_HEADER_SIZE;
+	
+	if(x1 < x0 || y1 < y0) return;
+	width = x1 - x0 + 1;
+	
+	while(i < size){
+		count = p[i++];
+		if(count & 0x80){
+			if(i >= size) return;
+			count = ((count & 0x7F) << 8) | p[i++];
+		}
+		if(i + 2 > size) return;
+		color = tlm_get16(p + i);
+		i += 2;
+		
+		while(count--){
+			x = x0 + pos % width;
+			y = y0 + pos / width;
+			if(x < LCD_W && y < LCD_H) frame[y][x] = color;
+			pos++;
+		}
+	}
+	changed = true;
+}
+
+//*****************************************************************************
+// Function Name: hatch_unknown
+//*****************************************************************************
+//	Summary: Fills an area with a checkerboard so it cannot be mistaken for
+//					 what the LCD shows
+//
+//*****************************************************************************
+static void hatch_unknown(uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1){
+	uint32_t x, y;
+	
+	for(y = y0; y <= y1 && y < LCD_H; y++){
+		for(x = x0; x <= x1 && x < LCD_W; x++){
+			frame[y][x] = ((x / 8 + y / 8) & 1) ? UNKNOWN_COLOR : 0;
+		}
+	}
+	changed = true;
+}
+
+int main(int argc, char **argv){
+	tlm_stream_t stream;
+	uint8_t rec[TLM_STREAM_MAX_ENCODED];
+	const char *prefix;
+	char path[512];
+	uint32_t saved = 0;
+	int size;
+	
+	if(argc > 1 && strcmp(argv[1], "-f") == 0){
+		flip = true;
+		argc--;
+		argv++;
+	}
+	if(argc != 2){
+		fprintf(stderr, "usage: mirror_view [-f] prefix < stream\n");
+		return 1;
+	}
+	prefix = argv[1];
+	
+	tlm_stream_init(&stream, stdin);
+	while((size = tlm_stream_read(&stream, rec)) >= 0){
+		switch(rec[0]){
+			case TLM_RECT:
+				if(size >= TLM_RECT_HEADER_SIZE) draw_rect(rec + TLM_HEADER_SIZE, size);
+				break;
+			case TLM_STALE:
+				if(size != TLM_STALE_SIZE) break;
+				if(tlm_get16(rec + 10) == 0){
+					fprintf(stderr, "unknown x %u-%u y %u-%u, drawn before mirroring started\n",
+									tlm_get16(rec + 2), tlm_get16(rec + 4), tlm_get16(rec + 6), tlm_get16(rec + 8));
+					hatch_unknown(tlm_get16(rec + 2), tlm_get16(rec + 4), tlm_get16(rec + 6), tlm_get16(rec + 8));
+					break;
+				}
+				fprintf(stderr, "stale x %u-%u y %u-%u, %u records dropped\n",
+								tlm_get16(rec + 2), tlm_get16(rec + 4), tlm_get16(rec + 6),
+								tlm_get16(rec + 8), tlm_get16(rec + 10));
+				break;
+			case TLM_FRAME:
+				// The board sends a frame record after each game frame is drawn
+				if(!changed) break;
+				snprintf(path, sizeof(path), "%s_%05lu.png", prefix, (unsigned long)saved++);
+				if(!save_png(path)) fprintf(stderr, "could not write %s\n", path);
+				changed = false;
+				break;
+			default:
+				break;
+		}
+	}
+	
+	// The last frame may not have been followed by a frame record
+	if(changed){
+		snprintf(path, sizeof(path), "%s_%05lu.png", prefix, (unsigned long)saved++);
+		save_png(path);
+	}
+	fprintf(stderr, "%lu frames, %lu bad records\n", (unsigned long)saved, (unsigned long)stream.bad_records);
+	return 0;
+}
@@ -0,0 +1,312 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Host stand-in for the CMSIS device header, used by the simulator in this
+// directory.  It declares only what the serial stack, the I2C1
+// peripherals, the joystick's ADC and the trace timer use, with the
+// registers at their real offsets.  The peripheral space is mapped at its
+// real address by sim_init, and the core functions below go to the
+// simulated NVIC in sim_hw.c.
+
+#ifndef __TM4C123GH6PM_H__
+#define __TM4C123GH6PM_H__
+
+#include <stdint.h>
+
+#define __I		volatile const
+#define __O		volatile
+#define __IO	volatile
+#define __INLINE	inline
+#define __weak		__attribute__((weak))
+
+typedef enum {
+	HardFault_IRQn		= -13,
+	GPIOA_IRQn				= 0,
+	GPIOB_IRQn				= 1,
+	GPIOC_IRQn				= 2,
+	GPIOD_IRQn				= 3,
+	GPIOE_IRQn				= 4,
+	UART0_IRQn				= 5,
+	UART1_IRQn				= 6,
+	I2C0_IRQn					= 8,
+	ADC0SS0_IRQn			= 14,
+	ADC0SS1_IRQn			= 15,
+	ADC0SS2_IRQn			= 16,
+	ADC0SS3_IRQn			= 17,
+	TIMER0A_IRQn			= 19,
+	TIMER0B_IRQn			= 20,
+	TIMER1A_IRQn			= 21,
+	TIMER1B_IRQn			= 22,
+	GPIOF_IRQn				= 30,
+	UART2_IRQn				= 33,
+	I2C1_IRQn					= 37,
+	UART3_IRQn				= 59,
+	UART4_IRQn				= 60,
+	UART5_IRQn				= 61,
+	UART6_IRQn				= 62,
+	UART7_IRQn				= 63,
+	I2C2_IRQn					= 68,
+	I2C3_IRQn					= 69
+} IRQn_Type;
+
+typedef struct {
+	__IO uint32_t	DR;
+	__IO uint32_t	RSR;
+	__I  uint32_t	RESERVED0[4];
+	__IO uint32_t	FR;
+	__I  uint32_t	RESERVED1;
+	__IO uint32_t	ILPR;
+	__IO uint32_t	IBRD;
+	__IO uint32_t	FBRD;
+	__IO uint32_t	LCRH;
+	__IO uint32_t	CTL;
+	__IO uint32_t	IFLS;
+	__IO uint32_t	IM;
+	__IO uint32_t	RIS;
+	__IO uint32_t	MIS;
+	__O  uint32_t	ICR;
+	__IO uint32_t	DMACTL;
+} UART0_Type;
+
+typedef struct {
+	__I  uint32_t	RESERVED0[255];
+	__IO uint32_t	DATA;
+	__IO uint32_t	DIR;
+	__IO uint32_t	IS;
+	__IO uint32_t	IBE;
+	__IO uint32_t	IEV;
+	__IO uint32_t	IM;
+	__IO uint32_t	RIS;
+	__IO uint32_t	MIS;
+	__O  uint32_t	ICR;
+	__IO uint32_t	AFSEL;
+	__I  uint32_t	RESERVED1[55];
+	__IO uint32_t	DR2R;
+	__IO uint32_t	DR4R;
+	__IO uint32_t	DR8R;
+	__IO uint32_t	ODR;
+	__IO uint32_t	PUR;
+	__IO uint32_t	PDR;
+	__IO uint32_t	SLR;
+	__IO uint32_t	DEN;
+	__IO uint32_t	LOCK;
+	__IO uint32_t	CR;
+	__IO uint32_t	AMSEL;
+	__IO uint32_t	PCTL;
+	__IO uint32_t	ADCCTL;
+	__IO uint32_t	DMACTL;
+} GPIOA_Type;
+
+// Only the master registers
+typedef struct {
+	__IO uint32_t	MSA;
+	__IO uint32_t	MCS;
+	__IO uint32_t	MDR;
+	__IO uint32_t	MTPR;
+	__IO uint32_t	MIMR;
+	__I  uint32_t	MRIS;
+	__I  uint32_t	MMIS;
+	__O  uint32_t	MICR;
+	__IO uint32_t	MCR;
+} I2C0_Type;
+
+typedef struct {
+	__I  uint32_t	STAT;
+	__O  uint32_t	CFG;
+	__IO uint32_t	CTLBASE;
+	__I  uint32_t	ALTBASE;
+	__I  uint32_t	WAITSTAT;
+	__O  uint32_t	SWREQ;
+	__IO uint32_t	USEBURSTSET;
+	__O  uint32_t	USEBURSTCLR;
+	__IO uint32_t	REQMASKSET;
+	__O  uint32_t	REQMASKCLR;
+	__IO uint32_t	ENASET;
+	__O  uint32_t	ENACLR;
+	__IO uint32_t	ALTSET;
+	__O  uint32_t	ALTCLR;
+	__IO uint32_t	PRIOSET;
+	__O  uint32_t	PRIOCLR;
+	__I  uint32_t	RESERVED0[3];
+	__IO uint32_t	ERRCLR;
+	__I  uint32_t	RESERVED1[300];
+	__IO uint32_t	CHASGN;
+	__IO uint32_t	CHIS;
+	__I  uint32_t	RESERVED2[2];
+	__IO uint32_t	CHMAP0;
+	__IO uint32_t	CHMAP1;
+	__IO uint32_t	CHMAP2;
+	__IO uint32_t	CHMAP3;
+} UDMA_Type;
+
+typedef struct {
+	__IO uint32_t	CFG;
+	__IO uint32_t	TAMR;
+	__IO uint32_t	TBMR;
+	__IO uint32_t	CTL;
+	__IO uint32_t	SYNC;
+	__I  uint32_t	RESERVED0;
+	__IO uint32_t	IMR;
+	__IO uint32_t	RIS;
+	__IO uint32_t	MIS;
+	__O  uint32_t	ICR;
+	__IO uint32_t	TAILR;
+	__IO uint32_t	TBILR;
+	__IO uint32_t	TAMATCHR;
+	__IO uint32_t	TBMATCHR;
+	__IO uint32_t	TAPR;
+	__IO uint32_t	TBPR;
+	__IO uint32_t	TAPMR;
+	__IO uint32_t	TBPMR;
+	__IO uint32_t	TAR;
+	__IO uint32_t	TBR;
+	__IO uint32_t	TAV;
+	__IO uint32_t	TBV;
+} TIMER0_Type;
+
+// Only the sample sequencers
+typedef struct {
+	__IO uint32_t	ACTSS;
+	__IO uint32_t	RIS;
+	__IO uint32_t	IM;
+	__IO uint32_t	ISC;
+	__IO uint32_t	OSTAT;
+	__IO uint32_t	EMUX;
+	__IO uint32_t	USTAT;
+	__IO uint32_t	TSSEL;
+	__IO uint32_t	SSPRI;
+	__IO uint32_t	SPC;
+	__IO uint32_t	PSSI;
+	__I  uint32_t	RESERVED0;
+	__IO uint32_t	SAC;
+	__IO uint32_t	DCISC;
+	__IO uint32_t	CTL;
+	__I  uint32_t	RESERVED1;
+	__IO uint32_t	SSMUX0;
+	__IO uint32_t	SSCTL0;
+	__IO uint32_t	SSFIFO0;
+	__IO uint32_t	SSFSTAT0;
+	__IO uint32_t	SSOP0;
+	__IO uint32_t	SSDC0;
+	__I  uint32_t	RESERVED2[2];
+	__IO uint32_t	SSMUX1;
+	__IO uint32_t	SSCTL1;
+	__IO uint32_t	SSFIFO1;
+	__IO uint32_t	SSFSTAT1;
+	__IO uint32_t	SSOP1;
+	__IO uint32_t	SSDC1;
+	__I  uint32_t	RESERVED3[2];
+	__IO uint32_t	SSMUX2;
+	__IO uint32_t	SSCTL2;
+	__IO uint32_t	SSFIFO2;
+	__IO uint32_t	SSFSTAT2;
+	__IO uint32_t	SSOP2;
+	__IO uint32_t	SSDC2;
+	__I  uint32_t	RESERVED4[2];
+	__IO uint32_t	SSMUX3;
+	__IO uint32_t	SSCTL3;
+	__IO uint32_t	SSFIFO3;
+	__IO uint32_t	SSFSTAT3;
+	__IO uint32_t	SSOP3;
+	__IO uint32_t	SSDC3;
+} ADC0_Type;
+
+// Only the clock gating and peripheral ready registers
+typedef struct {
+	__I  uint32_t	RESERVED0[385];
+	__IO uint32_t	RCGCTIMER;
+	__IO uint32_t	RCGCGPIO;
+	__IO uint32_t	RCGCDMA;
+	__I  uint32_t	RESERVED1[2];
+	__IO uint32_t	RCGCUART;
+	__IO uint32_t	RCGCSSI;
+	__IO uint32_t	RCGCI2C;
+	__I  uint32_t	RESERVED2[5];
+	__IO uint32_t	RCGCADC;
+	__I  uint32_t	RESERVED3[242];
+	__IO uint32_t	PRTIMER;
+	__IO uint32_t	PRGPIO;
+	__IO uint32_t	PRDMA;
+	__I  uint32_t	RESERVED4[2];
+	__IO uint32_t	PRUART;
+	__IO uint32_t	PRSSI;
+	__IO uint32_t	PRI2C;
+	__I  uint32_t	RESERVED5[5];
+	__IO uint32_t	PRADC;
+} SYSCTL_Type;
+
+#define GPIOA_BASE	0x40004000UL
+#define GPIOB_BASE	0x40005000UL
+#define GPIOC_BASE	0x40006000UL
+#define GPIOD_BASE	0x40007000UL
+#define GPIOE_BASE	0x40024000UL
+#define GPIOF_BASE	0x40025000UL
+#define UART0_BASE	0x4000C000UL
+#define UART1_BASE	0x4000D000UL
+#define UART2_BASE	0x4000E000UL
+#define UART3_BASE	0x4000F000UL
+#define UART4_BASE	0x40010000UL
+#define UART5_BASE	0x40011000UL
+#define UART6_BASE	0x40012000UL
+#define UART7_BASE	0x40013000UL
+#define I2C0_BASE		0x40020000UL
+#define I2C1_BASE		0x40021000UL
+#define I2C2_BASE		0x40022000UL
+#define I2C3_BASE		0x40023000UL
+#define TIMER0_BASE	0x40030000UL
+#define TIMER1_BASE	0x40031000UL
+#define TIMER2_BASE	0x40032000UL
+#define TIMER3_BASE	0x40033000UL
+#define TIMER4_BASE	0x40034000UL
+#define TIMER5_BASE	0x40035000UL
+#define ADC0_BASE		0x40038000UL
+#define ADC1_BASE		0x40039000UL
+#define SYSCTL_BASE	0x400FE000UL
+#define UDMA_BASE		0x400FF000UL
+
+#define GPIOA		((GPIOA_Type *)GPIOA_BASE)
+#define GPIOB		((GPIOA_Type *)GPIOB_BASE)
+#define GPIOC		((GPIOA_Type *)GPIOC_BASE)
+#define GPIOF		((GPIOA_Type *)GPIOF_BASE)
+#define UART0		((UART0_Type *)UART0_BASE)
+#define TIMER0	((TIMER0_Type *)TIMER0_BASE)
+#define TIMER1	((TIMER0_Type *)TIMER1_BASE)
+#define ADC0		((ADC0_Type *)ADC0_BASE)
+#define SYSCTL	((SYSCTL_Type *)SYSCTL_BASE)
+#define UDMA		((UDMA_Type *)UDMA_BASE)
+
+// Simulated core, see sim_hw.c
+extern volatile uint32_t sim_primask;
+void sim_set_primask(uint32_t primask);
+void sim_nvic_enable(IRQn_Type irq, int enable);
+
+static __INLINE void NVIC_EnableIRQ(IRQn_Type irq)	{ sim_nvic_enable(irq, 1); }
+static __INLINE void NVIC_DisableIRQ(IRQn_Type irq)	{ sim_nvic_enable(irq, 0); }
+static __INLINE void NVIC_SetPriority(IRQn_Type irq, uint32_t priority)	{ (void)irq; (void)priority; }
+
+static __INLINE uint32_t __get_PRIMASK(void)		{ return sim_primask; }
+static __INLINE void __set_PRIMASK(uint32_t primask)	{ sim_set_primask(primask); }
+static __INLINE void __disable_irq(void)				{ sim_primask = 1; }
+static __INLINE void __enable_irq(void)					{ sim_set_primask(0); }
+static __INLINE void __DMB(void)								{ __sync_synchronize(); }
+
+#endif
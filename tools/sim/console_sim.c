@@ -0,0 +1,294 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Runs the serial console and the telemetry stream, HW4/console.c and
+// HW4/telemetry.c, on the host over the UART0 model in sim_hw.c.  A
+// stand-in for the game keeps the tunables, ticks every 10ms like Timer A
+// and moves a few entities, so every command has something to act on.  A
+// high score name is always wanted; each one entered is reported on stderr.
+//
+// Built by the Makefile in this directory, "make check" replays
+// console_script.txt and compares the replies with console_expected.txt.
+//
+// Usage:
+//   ./console_sim [-q]
+//       bridges UART0 to a new pty and prints its name.  Use it as if it
+//       were the board's serial port:
+//         screen /dev/pts/5 115200
+//         ./telemetry_decode < /dev/pts/5
+//   ./console_sim [-q] -
+//       bridges UART0 to stdin and stdout instead, and exits once stdin has
+//       been read and the replies have gone out.  For scripted runs:
+//         printf 'tlm off\rget step\rset step 9\rget step\r' | ./console_sim -
+//
+// -q starts with telemetry off, so the output is only the console's text.
+// What the serial stack did is summed up on stderr at exit, Ctrl-C in pty
+// mode.  Exits with 1 if a received byte was overrun or a byte written to
+// the TX FIFO was lost.
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "sim_hw.h"
+#include "serial_debug.h"
+#include "main.h"
+#include "galaga.h"
+#include "console.h"
+#include "telemetry.h"
+#include "lcd_mirror.h"
+#include "i2c.h"
+#include "name_entry.h"
+#include "high_scores.h"
+
+// Timer A period
+#define TICK_NS						10000000ULL
+
+// How long the pipe mode keeps running after the last command, for
+// replies that go out over several polls
+#define LINGER_NS					200000000ULL
+
+#define NUM_SIM_UNITS			4
+#define NUM_SIM_BULLETS		2
+
+// Stand-ins for the game's globals
+int32_t bullet_speed = BULLET_SPEED;
+int32_t tracking_speed = TRACKING_SPEED;
+int32_t enemy_step = STEP;
+int32_t fire_base = FIRE_BASE;
+int32_t fire_level_step = FIRE_LEVEL_STEP;
+int32_t delay_small = DELAY_SMALL;
+int32_t delay_large = DELAY_LARGE;
+int32_t timer_a_cycles = TIMER_A_CYCLES;
+
+static entity_info_t entities[NUM_SIM_UNITS + NUM_SIM_BULLETS];
+static bool mirror_on = false;
+static uint32_t lcd_prints = 0;
+static int line_fd = -1;
+static volatile sig_atomic_t stop = 0;
+
+//*****************************************************************************
+// Function Name: get_entity
+//*****************************************************************************
+//	Summary: Same contract as the game's, over the stand-in table
+//
+//*****************************************************************************
+bool get_entity(uint8_t index, entity_info_t *info){
+	if(index >= NUM_SIM_UNITS + NUM_SIM_BULLETS) return false;
+	*info = entities[index];
+	return true;
+}
+
+void lcd_mirror_enable(bool enable){
+	mirror_on = enable;
+}
+
+void lcd_print_stringXY(char *msg, int8_t X, int8_t Y, uint16_t fg_color, uint16_t bg_color){
+	lcd_prints++;
+}
+
+bool hs_flush(void){
+	return true;
+}
+
+const i2c_stats_t *i2cGetStats(uint32_t base_addr){
+	static i2c_stats_t stats;
+	
+	return &stats;
+}
+
+//*****************************************************************************
+// Function Name: sim_game_tick
+//*****************************************************************************
+//	Summary: Sweeps the units across the screen by enemy_step and fires the
+//					 player's bullets up by bullet_speed, so the tunables show
+//
+//*****************************************************************************
+static void sim_game_tick(void){
+	int i;
+	
+	for(i = 0; i < NUM_SIM_UNITS; i++){
+		entities[i].x = (entities[i].x + enemy_step) % 240;
+	}
+	for(i = NUM_SIM_UNITS; i < NUM_SIM_UNITS + NUM_SIM_BULLETS; i++){
+		entities[i].y += bullet_speed;
+		if(entities[i].y > BOUNDRY_Y_TOP) entities[i].y = PLAYER_START_Y;
+	}
+}
+
+static void sim_game_init(void){
+	int i;
+	
+	for(i = 0; i < NUM_SIM_UNITS; i++){
+		entities[i] = (entity_info_t){ 'U', i, true, i * SPACING, ROW_1_START, 1, 0 };
+	}
+	for(i = 0; i < NUM_SIM_BULLETS; i++){
+		entities[NUM_SIM_UNITS + i] = (entity_info_t){ 'P', i, true, PLAYER_START_X, PLAYER_START_Y + i * 40, 0, 0 };
+	}
+}
+
+void count_entities(tlm_entities_t *counts){
+	counts->units = NUM_SIM_UNITS;
+	counts->player_bullets = NUM_SIM_BULLETS;
+	counts->enemy_bullets = 0;
+	counts->lives = PLAYER_START_LIVES;
+	counts->level = 1;
+}
+
+static void send_line(uint8_t data){
+	if(write(line_fd, &data, 1) < 0){
+		// Nobody on the other end of the pty, the byte is lost as on a
+		// disconnected cable
+	}
+}
+
+static void on_sigint(int sig){
+	stop = 1;
+}
+
+//*****************************************************************************
+// Function Name: open_pty
+//*****************************************************************************
+//	Summary: Creates a pty in raw mode, so bytes pass through unchanged.
+//					 The slave side is held open so the line stays up while no
+//					 terminal is connected.
+//
+//	Returns: the master side, or -1
+//
+//*****************************************************************************
+static int open_pty(void){
+	struct termios tio;
+	int master, slave;
+	
+	master = posix_openpt(O_RDWR | O_NOCTTY);
+	if(master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) return -1;
+	slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+	if(slave < 0) return -1;
+	
+	tcgetattr(slave, &tio);
+	cfmakeraw(&tio);
+	cfsetspeed(&tio, B115200);
+	tcsetattr(slave, TCSANOW, &tio);
+	
+	fprintf(stderr, "UART0 is on %s\n", ptsname(master));
+	return master;
+}
+
+static void print_summary(void){
+	const sim_stats_t *stats = sim_get_stats();
+	
+	fprintf(stderr, "rx %llu bytes, %llu overruns; tx %llu bytes, %llu by uDMA in %llu buffers\n",
+					(unsigned long long)stats->rx_bytes, (unsigned long long)stats->rx_overruns,
+					(unsigned long long)stats->tx_bytes, (unsigned long long)stats->dma_tx_bytes,
+					(unsigned long long)stats->dma_buffers);
+	fprintf(stderr, "UART0_Handler: %llu entries, %llu register accesses; %llu in total\n",
+					(unsigned long long)stats->isr_entries, (unsigned long long)stats->isr_reg_accesses,
+					(unsigned long long)(stats->reg_reads + stats->reg_writes));
+}
+
+int main(int argc, char **argv){
+	tlm_entities_t counts;
+	const sim_stats_t *stats;
+	bool piped;
+	uint64_t next_tick, rx_done_at = 0, now;
+	int counter = 0;
+	int in_fd, opt;
+	
+	while((opt = getopt(argc, argv, "q")) != -1){
+		switch(opt){
+			case 'q':	telemetry_enabled = false; break;
+			default:
+				fprintf(stderr, "usage: console_sim [-q] [-]\n");
+				return 2;
+		}
+	}
+	piped = (optind < argc && strcmp(argv[optind], "-") == 0);
+	
+	if(piped){
+		in_fd = STDIN_FILENO;
+		line_fd = STDOUT_FILENO;
+	}
+	else{
+		in_fd = line_fd = open_pty();
+		if(line_fd < 0){
+			perror("console_sim: pty");
+			return 1;
+		}
+		signal(SIGINT, on_sigint);
+	}
+	fcntl(in_fd, F_SETFL, fcntl(in_fd, F_GETFL) | O_NONBLOCK);
+	
+	sim_init();
+	sim_set_tx_sink(send_line);
+	sim_set_rx_source(in_fd);
+	init_serial_debug(true, true);
+	sim_game_init();
+	name_entry_start();
+	
+	next_tick = sim_now();
+	while(!stop){
+		console_poll();
+		
+		now = sim_now();
+		if(now >= next_tick){
+			next_tick += TICK_NS;
+			counter = (counter + 1) % timer_a_cycles;
+			if(!console_hold()){
+				telemetry_tick_begin();
+				sim_game_tick();
+				telemetry_tick_end(false);
+			}
+			name_entry_draw();
+			if(name_entry_done()){
+				fprintf(stderr, "name \"%s\" after %u LCD prints\n", name_entry_text(), lcd_prints);
+				name_entry_start();
+			}
+			if(counter % 5 == 4){
+				count_entities(&counts);
+				telemetry_frame(&counts);
+			}
+		}
+		
+		if(piped && sim_rx_done() && ring_empty(&UART0_Rx_Buffer)){
+			if(rx_done_at == 0) rx_done_at = now;
+			if(now - rx_done_at > LINGER_NS) break;
+		}
+		sim_wait();
+	}
+	
+	serial_debug_tx_drain(UART0_BASE, &UART0_Tx_Buffer);
+	while(!sim_tx_idle()) sim_wait();
+	print_summary();
+	
+	stats = sim_get_stats();
+	if(stats->rx_overruns != 0 || stats->tx_overflows != 0){
+		fprintf(stderr, "FAIL: %llu bytes overrun, %llu TX FIFO overflows\n",
+						(unsigned long long)stats->rx_overruns, (unsigned long long)stats->tx_overflows);
+		return 1;
+	}
+	return 0;
+}
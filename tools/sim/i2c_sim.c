@@ -0,0 +1,567 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Runs the I2C1 stack, drivers/c/i2c.c and the EEPROM, touch and port
+// expander drivers on it, against the I2C1 model in sim_hw.c with the
+// slaves in sim_i2c_dev.c on the bus.
+//
+// Writes a block to the EEPROM and reads it back, both directly and
+// through the write queue, then replays scripts of touches and button
+// presses and reads each one when its INT pin goes low, as the frame loop
+// does.  Last, times the same touch report read through the blocking
+// i2c_transfer and through the queued engine, one at a time and with the
+// queue full.  Checks what the drivers return against what the models
+// hold and reports the bus time and CPU cost of each part.
+//
+// Usage:
+//   ./i2c_sim [-q] [-n bytes] [-a address] [-r reads]
+//
+// -q reads the scripted inputs through the queued engine, as input.c does,
+// instead of blocking.  -n is the size of the EEPROM block, 1024 by
+// default, and -a where it starts, 0x123 by default so the first and last
+// pages are partial.  -r is the number of reports each way in the engine
+// comparison, 64 by default.
+// Exits with 1 if any read returns something other than what the models
+// hold, an input is missed or a transaction times out.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim_hw.h"
+#include "sim_i2c_dev.h"
+#include "eeprom.h"
+#include "ft6x06.h"
+#include "port_expander.h"
+
+// Addresses the board straps the parts to
+#define EEPROM_ADDR					0x50
+#define FT6X06_ADDR					0x38
+#define MCP23017_ADDR				0x27
+
+// The board's 50MHz core clock, as latency.c times transactions in
+#define NS_PER_TICK					20
+
+// Time left after the last scripted input for it to be read
+#define SETTLE_US						5000
+
+// Deepest queue the engine comparison builds
+#define MAX_QUEUED					64
+
+#define ARRAY_LEN(a)				(sizeof(a) / sizeof((a)[0]))
+
+static const sim_touch_t touch_script[] = {
+	{  2000, 1,  40,  60 },
+	{  6000, 1,  42,  63 },
+	{ 11000, 1,  47,  70 },
+	{ 15000, 0,   0,   0 },
+	{ 24000, 1, 200, 300 },
+	{ 27000, 1, 201, 296 },
+	{ 33000, 0,   0,   0 },
+	{ 40000, 1, 119, 159 },
+	{ 48000, 0,   0,   0 },
+	{ 55000, 1, 239, 319 },
+	{ 59000, 1,   0,   0 },
+	{ 66000, 0,   0,   0 },
+};
+
+static const sim_buttons_t button_script[] = {
+	{  3000, PEXP_BUTTON_UP },
+	{  9000, 0 },
+	{ 17000, PEXP_BUTTON_LEFT },
+	{ 21000, PEXP_BUTTON_LEFT | PEXP_BUTTON_UP },
+	{ 29000, PEXP_BUTTON_UP },
+	{ 36000, 0 },
+	{ 44000, PEXP_BUTTON_RIGHT },
+	{ 52000, PEXP_BUTTON_RIGHT | PEXP_BUTTON_DOWN },
+	{ 62000, PEXP_BUTTON_M },
+	{ 70000, 0 },
+};
+
+static sim_24lc32_t eeprom;
+static sim_ft6x06_t touch;
+static sim_mcp23017_t pexp;
+
+static uint32_t failures = 0;
+static bool queued = false;
+
+typedef struct {
+	uint32_t	reads;
+	uint32_t	seen;							// script steps read back
+	uint64_t	latency_ns;				// from each step to the read that saw it
+	uint64_t	max_latency_ns;
+	
+	// A queued read in flight.  step and posted are the script step whose
+	// INT started it.
+	i2c_xfer_t	xfer;
+	volatile bool	busy;
+	volatile bool	ready;
+	uint64_t	done_at;
+	uint32_t	step;
+	uint64_t	posted;
+} input_result_t;
+
+static uint32_t sim_ticks(void){
+	return sim_now() / NS_PER_TICK;
+}
+
+static void fail(const char *what, uint32_t n){
+	fprintf(stderr, "FAIL: %s at %u\n", what, n);
+	failures++;
+}
+
+//*****************************************************************************
+// Function Name: pattern
+//*****************************************************************************
+//	Summary: Byte n of a block written from seed.  Not periodic in the page
+//					 size, so a page written to the wrong place shows up.
+//
+//*****************************************************************************
+static uint8_t pattern(uint32_t n, uint32_t seed){
+	n += seed;
+	return (uint8_t)(n ^ (n >> 5) ^ (n >> 11) ^ seed);
+}
+
+static void report_i2c(const char *name, uint64_t ns, uint32_t bytes, const sim_stats_t *before){
+	const sim_stats_t *stats = sim_get_stats();
+	const i2c_stats_t *i2c = i2cGetStats(I2C1_BASE);
+	
+	fprintf(stderr, "%s: %u bytes in %.2f ms, %.0f bytes/s, bus busy %.0f%%\n", name, bytes, ns / 1e6,
+					ns ? bytes * 1e9 / ns : 0.0, ns ? (stats->i2c_bus_ns - before->i2c_bus_ns) * 100.0 / ns : 0.0);
+	fprintf(stderr, "  %u transfers, %u NACKed, %u timed out, longest %.0f us\n",
+					i2c->transfers + i2c->async_xfers, i2c->nacks, i2c->timeouts, i2c->max_ticks * NS_PER_TICK / 1e3);
+	fprintf(stderr, "  %llu bytes on the bus, %llu register accesses, %u busy polls\n",
+					(unsigned long long)(stats->i2c_bytes - before->i2c_bytes),
+					(unsigned long long)(stats->i2c_reg_accesses - before->i2c_reg_accesses), i2c->wait_polls);
+	if(i2c->timeouts != 0) fail("I2C timeout", i2c->timeouts);
+}
+
+//*****************************************************************************
+// Function Name: check_eeprom
+//*****************************************************************************
+//	Summary: Checks that the model holds len bytes of seed's pattern from
+//					 address and the erased value on either side of them
+//
+//*****************************************************************************
+static void check_eeprom(uint16_t address, uint16_t len, uint32_t seed){
+	uint32_t i;
+	
+	for(i = 0; i < len; i++){
+		if(eeprom.mem[address + i] != pattern(i, seed)){
+			fail("EEPROM model differs", address + i);
+			return;
+		}
+	}
+	if((address > 0 && eeprom.mem[address - 1] != 0xFF) ||
+		 (address + len < SIM_24LC32_SIZE && eeprom.mem[address + len] != 0xFF)){
+		fail("EEPROM written outside the block", address);
+	}
+}
+
+//*****************************************************************************
+// Function Name: test_eeprom
+//*****************************************************************************
+//	Summary: Writes and reads back a block with eeprom_write and eeprom_read,
+//					 then queues another one, reads it back before and after the
+//					 queue drains and checks both against the model
+//
+//*****************************************************************************
+static void test_eeprom(uint16_t address, uint16_t len){
+	uint8_t *data = malloc(len);
+	uint8_t *back = malloc(len);
+	sim_stats_t before;
+	uint64_t start, ns;
+	uint32_t cycles, nacks, steps, i;
+	uint16_t queued = (SIM_24LC32_SIZE - 256 > address + len) ? SIM_24LC32_SIZE - 256 : 0;
+	i2c_status_t status;
+	
+	for(i = 0; i < len; i++) data[i] = pattern(i, 1);
+	
+	// Blocking page writes, each ACK polled until the write cycle is over
+	i2cStatsReset(I2C1_BASE);
+	before = *sim_get_stats();
+	cycles = eeprom.write_cycles;
+	nacks = eeprom.busy_nacks;
+	start = sim_now();
+	status = eeprom_write(I2C1_BASE, address, data, len);
+	ns = sim_now() - start;
+	if(status != I2C_OK) fail("eeprom_write", status);
+	report_i2c("eeprom_write", ns, len, &before);
+	fprintf(stderr, "  %u write cycles, %u ACK polls NACKed\n", eeprom.write_cycles - cycles, eeprom.busy_nacks - nacks);
+	if(eeprom.write_cycles - cycles != (address + len - 1) / SIM_24LC32_PAGE - address / SIM_24LC32_PAGE + 1){
+		fail("eeprom_write did not write page by page", eeprom.write_cycles - cycles);
+	}
+	check_eeprom(address, len, 1);
+	
+	i2cStatsReset(I2C1_BASE);
+	before = *sim_get_stats();
+	start = sim_now();
+	status = eeprom_read(I2C1_BASE, address, back, len);
+	ns = sim_now() - start;
+	if(status != I2C_OK) fail("eeprom_read", status);
+	report_i2c("eeprom_read", ns, len, &before);
+	if(memcmp(data, back, len) != 0) fail("eeprom_read returned other bytes", address);
+	
+	// The queue, drained a step at a time as the frame loop does.  A read
+	// sees queued bytes before they reach the part.
+	if(queued == 0) goto done;
+	for(i = 0; i < 200; i++) data[i] = pattern(i, 2);
+	status = eeprom_queue_write(I2C1_BASE, queued + 3, data, 200);
+	if(status != I2C_OK) fail("eeprom_queue_write", status);
+	memset(back, 0, 200);
+	status = eeprom_queue_read(I2C1_BASE, queued + 3, back, 200);
+	if(status != I2C_OK || memcmp(data, back, 200) != 0) fail("eeprom_queue_read before the drain", status);
+	
+	i2cStatsReset(I2C1_BASE);
+	before = *sim_get_stats();
+	cycles = eeprom.write_cycles;
+	start = sim_now();
+	for(steps = 0; eeprom_queue_step() != 0; steps++){
+		while(sim_now() - start < (steps + 1) * 1000000ULL) sim_wait();
+	}
+	ns = sim_now() - start;
+	report_i2c("eeprom_queue_step", ns, 200, &before);
+	fprintf(stderr, "  %u steps a millisecond apart, %u write cycles\n", steps + 1, eeprom.write_cycles - cycles);
+	check_eeprom(queued + 3, 200, 2);
+	
+	memset(back, 0, 200);
+	status = eeprom_queue_read(I2C1_BASE, queued + 3, back, 200);
+	if(status != I2C_OK || memcmp(data, back, 200) != 0) fail("eeprom_queue_read after the drain", status);
+	
+done:
+	free(data);
+	free(back);
+}
+
+static void add_latency(input_result_t *result, uint64_t posted, uint64_t done_at){
+	uint64_t ns = done_at - posted;
+	
+	result->latency_ns += ns;
+	if(ns > result->max_latency_ns) result->max_latency_ns = ns;
+}
+
+// Called from I2C1_Handler when a queued read finishes
+static void input_read_done(i2c_xfer_t *xfer){
+	input_result_t *result = xfer->context;
+	
+	result->done_at = sim_now();
+	result->busy = false;
+	result->ready = true;
+}
+
+//*****************************************************************************
+// Function Name: check_touch
+//*****************************************************************************
+//	Summary: Checks a report against the touch script step that raised INT.
+//					 The event follows from the step before it.
+//
+//*****************************************************************************
+static void check_touch(const ft6x06_touch_t *report, uint32_t step){
+	const sim_touch_t *expect = &touch_script[step];
+	const sim_touch_t *last = NULL;
+	uint8_t event;
+	uint32_t i;
+	
+	// The point a lift is reported at is the last one seen down
+	for(i = step; i-- > 0; ){
+		if(touch_script[i].touches != 0){
+			last = &touch_script[i];
+			break;
+		}
+	}
+	if(expect->touches == 0) event = FT6X06_EVENT_LIFT_UP;
+	else if(step == 0 || touch_script[step - 1].touches == 0) event = FT6X06_EVENT_PRESS_DOWN;
+	else event = FT6X06_EVENT_CONTACT;
+	if(expect->touches != 0) last = expect;
+	
+	if(report->touches != expect->touches || report->point[0].event != event ||
+		 (last != NULL && (report->point[0].x != last->x || report->point[0].y != last->y))){
+		fail("touch report differs from the script", step);
+	}
+}
+
+static void finish_touch(input_result_t *result, i2c_status_t status, const ft6x06_touch_t *report){
+	result->reads++;
+	if(status != I2C_OK) fail("touch read", status);
+	else check_touch(report, result->step);
+	if(result->step != result->seen) fail("touch step missed", result->seen);
+	result->seen = result->step + 1;
+	add_latency(result, result->posted, result->done_at);
+}
+
+static void finish_buttons(input_result_t *result, i2c_status_t status, uint8_t down){
+	result->reads++;
+	if(status != I2C_OK) fail("button read", status);
+	else if((down & PEXP_BUTTON_M) != button_script[result->step].down) fail("buttons differ from the script", result->step);
+	if(result->step != result->seen) fail("button step missed", result->seen);
+	result->seen = result->step + 1;
+	add_latency(result, result->posted, result->done_at);
+}
+
+//*****************************************************************************
+// Function Name: test_inputs
+//*****************************************************************************
+//	Summary: Plays the touch and button scripts and reads each device when
+//					 its INT pin is low, checking every read against the step
+//					 that raised it.  With -q the reads are queued and both can be
+//					 in flight at once.
+//
+//*****************************************************************************
+static void test_inputs(void){
+	static input_result_t touches, buttons;
+	uint8_t touch_buf[FT6X06_TOUCH_BYTES];
+	ft6x06_touch_t report;
+	sim_stats_t before;
+	uint64_t start, end, ns;
+	uint8_t down;
+	i2c_status_t status;
+	
+	i2cStatsReset(I2C1_BASE);
+	before = *sim_get_stats();
+	sim_ft6x06_play(&touch, touch_script, ARRAY_LEN(touch_script));
+	sim_mcp23017_play(&pexp, button_script, ARRAY_LEN(button_script));
+	start = sim_now();
+	end = start + (touch_script[ARRAY_LEN(touch_script) - 1].at_us + SETTLE_US) * 1000ULL;
+	if(button_script[ARRAY_LEN(button_script) - 1].at_us * 1000ULL + SETTLE_US * 1000ULL + start > end){
+		end = start + (button_script[ARRAY_LEN(button_script) - 1].at_us + SETTLE_US) * 1000ULL;
+	}
+	touches.xfer.context = &touches;
+	buttons.xfer.context = &buttons;
+	
+	while(sim_now() < end){
+		if(!touches.busy && !touches.ready && (GPIOF->DATA & FT6X06_IRQ_PIN_NUM) == 0){
+			touches.step = touch.next - 1;
+			touches.posted = touch.posted;
+			if(queued){
+				touches.busy = true;
+				status = ft6x06_read_touch_async(&touches.xfer, touch_buf, input_read_done);
+				if(status != I2C_OK){
+					touches.busy = false;
+					fail("ft6x06_read_touch_async", status);
+				}
+			}
+			else{
+				status = ft6x06_read_touch(&report);
+				touches.done_at = sim_now();
+				finish_touch(&touches, status, &report);
+			}
+		}
+		if(!buttons.busy && !buttons.ready && (GPIOF->DATA & PEXP_IRQ_PIN_NUM) == 0){
+			buttons.step = pexp.next - 1;
+			buttons.posted = pexp.posted;
+			if(queued){
+				buttons.busy = true;
+				status = pexp_read_buttons_async(I2C1_BASE, &buttons.xfer, &down, input_read_done);
+				if(status != I2C_OK){
+					buttons.busy = false;
+					fail("pexp_read_buttons_async", status);
+				}
+			}
+			else{
+				status = pexp_read_buttons(I2C1_BASE, &down);
+				buttons.done_at = sim_now();
+				finish_buttons(&buttons, status, down);
+			}
+		}
+		
+		if(touches.ready){
+			touches.ready = false;
+			ft6x06_decode_touch(touch_buf, &report);
+			finish_touch(&touches, touches.xfer.status, &report);
+		}
+		if(buttons.ready){
+			buttons.ready = false;
+			finish_buttons(&buttons, buttons.xfer.status, ~down);
+		}
+		sim_wait();
+	}
+	ns = sim_now() - start;
+	
+	if(touches.seen != ARRAY_LEN(touch_script)) fail("touch steps read", touches.seen);
+	if(buttons.seen != ARRAY_LEN(button_script)) fail("button steps read", buttons.seen);
+	report_i2c(queued ? "inputs, queued" : "inputs, blocking", ns, i2cGetStats(I2C1_BASE)->bytes_read, &before);
+	fprintf(stderr, "  touch: %u reads, latency mean %.0f us, max %.0f us\n", touches.reads,
+					touches.reads ? touches.latency_ns / 1e3 / touches.reads : 0.0, touches.max_latency_ns / 1e3);
+	fprintf(stderr, "  buttons: %u reads, latency mean %.0f us, max %.0f us\n", buttons.reads,
+					buttons.reads ? buttons.latency_ns / 1e3 / buttons.reads : 0.0, buttons.max_latency_ns / 1e3);
+}
+
+//*****************************************************************************
+// Function Name: report_engine
+//*****************************************************************************
+//	Summary: Prints one row of the engine comparison.  cpu_ns is the time the
+//					 caller spent in the driver, to which the time in I2C1_Handler
+//					 is added.
+//
+//*****************************************************************************
+static void report_engine(const char *name, uint32_t reads, uint64_t ns, uint64_t latency_ns,
+													uint64_t cpu_ns, const sim_stats_t *before){
+	const sim_stats_t *stats = sim_get_stats();
+	uint64_t isr_ns = stats->i2c_isr_ns - before->i2c_isr_ns;
+	uint64_t accesses = stats->i2c_reg_accesses - before->i2c_reg_accesses;
+	uint64_t isr_accesses = stats->i2c_isr_reg_accesses - before->i2c_isr_reg_accesses;
+	
+	fprintf(stderr, "  %-22s %6.0f %9.0f %8.0f %7.0f%% %8.1f %8.1f\n", name,
+					reads * FT6X06_TOUCH_BYTES * 1e9 / ns, latency_ns / 1e3 / reads,
+					(cpu_ns + isr_ns) / 1e3 / reads, (cpu_ns + isr_ns) * 100.0 / ns,
+					(double)(accesses - isr_accesses) / reads, (double)isr_accesses / reads);
+}
+
+static void check_report(const uint8_t *buf, uint32_t n){
+	if(memcmp(buf, &touch.regs[FT6X06_TD_STATUS_R], FT6X06_TOUCH_BYTES) != 0) fail("touch report differs from the model", n);
+}
+
+// Called from I2C1_Handler, stamps when a benchmark read finished
+static void bench_read_done(i2c_xfer_t *xfer){
+	*(uint64_t *)xfer->context = sim_now();
+}
+
+//*****************************************************************************
+// Function Name: bench_queued
+//*****************************************************************************
+//	Summary: Reads the touch report reads times through the queued engine,
+//					 depth reads submitted at a time.  The caller spins on done in
+//					 between, so the CPU time charged is the submits and the
+//					 handler.
+//
+//*****************************************************************************
+static void bench_queued(const char *name, uint32_t reads, uint32_t depth){
+	static i2c_xfer_t xfers[MAX_QUEUED];
+	static uint8_t bufs[MAX_QUEUED][FT6X06_TOUCH_BYTES];
+	static uint64_t done_at[MAX_QUEUED];
+	static const uint8_t td_status = FT6X06_TD_STATUS_R;
+	sim_stats_t before = *sim_get_stats();
+	uint64_t start = sim_now(), t, latency = 0, cpu = 0;
+	uint32_t i, j, n;
+	i2c_status_t status;
+	
+	for(i = 0; i < reads; i += n){
+		n = (reads - i < depth) ? reads - i : depth;
+		for(j = 0; j < n; j++){
+			xfers[j].dev_id = FT6X06_ADDR;
+			xfers[j].wr_data = &td_status;
+			xfers[j].wr_len = 1;
+			xfers[j].rd_data = bufs[j];
+			xfers[j].rd_len = FT6X06_TOUCH_BYTES;
+			xfers[j].callback = bench_read_done;
+			xfers[j].context = &done_at[j];
+		}
+		
+		t = sim_now();
+		for(j = 0; j < n; j++){
+			status = i2cSubmit(I2C1_BASE, &xfers[j]);
+			if(status != I2C_OK) fail("i2cSubmit", status);
+		}
+		cpu += sim_now() - t;
+		while(!xfers[n - 1].done);
+		
+		for(j = 0; j < n; j++){
+			latency += done_at[j] - t;
+			if(xfers[j].status != I2C_OK) fail("queued read", xfers[j].status);
+			else check_report(bufs[j], i + j);
+		}
+	}
+	report_engine(name, reads, sim_now() - start, latency, cpu, &before);
+}
+
+//*****************************************************************************
+// Function Name: bench_engines
+//*****************************************************************************
+//	Summary: Reads the touch report reads times through i2c_transfer, then
+//					 through the queued engine one at a time and with every read
+//					 queued up front, and prints what each cost
+//
+//*****************************************************************************
+static void bench_engines(uint32_t reads){
+	static const uint8_t td_status = FT6X06_TD_STATUS_R;
+	uint8_t buf[FT6X06_TOUCH_BYTES];
+	sim_stats_t before = *sim_get_stats();
+	uint64_t start, t, latency = 0;
+	uint32_t i;
+	i2c_status_t status;
+	
+	fprintf(stderr, "touch report reads, %u of %u bytes each way:\n", reads, FT6X06_TOUCH_BYTES);
+	fprintf(stderr, "  %-22s %6s %9s %8s %8s %8s %8s\n", "", "B/s", "latency", "CPU", "CPU", "accesses", "in ISR");
+	fprintf(stderr, "  %-22s %6s %9s %8s %8s %8s %8s\n", "", "", "us", "us", "", "per read", "per read");
+	
+	// The caller waits out the whole transfer
+	start = sim_now();
+	for(i = 0; i < reads; i++){
+		t = sim_now();
+		status = i2c_transfer(I2C1_BASE, FT6X06_ADDR, &td_status, 1, buf, FT6X06_TOUCH_BYTES);
+		latency += sim_now() - t;
+		if(status != I2C_OK) fail("i2c_transfer", status);
+		else check_report(buf, i);
+	}
+	report_engine("i2c_transfer", reads, sim_now() - start, latency, latency, &before);
+	
+	bench_queued("i2cSubmit, one deep", reads, 1);
+	bench_queued("i2cSubmit, all queued", reads, reads);
+}
+
+int main(int argc, char **argv){
+	uint32_t len = 1024;
+	uint32_t address = 0x123;
+	uint32_t reads = 64;
+	int opt;
+	
+	while((opt = getopt(argc, argv, "qn:a:r:")) != -1){
+		switch(opt){
+			case 'q':	queued = true; break;
+			case 'n':	len = strtoul(optarg, NULL, 0); break;
+			case 'a':	address = strtoul(optarg, NULL, 0); break;
+			case 'r':	reads = strtoul(optarg, NULL, 0); break;
+			default:
+				fprintf(stderr, "usage: i2c_sim [-q] [-n bytes] [-a address] [-r reads]\n");
+				return 2;
+		}
+	}
+	if(reads == 0 || reads > MAX_QUEUED) reads = MAX_QUEUED;
+	if(len == 0 || address + len > SIM_24LC32_SIZE){
+		fprintf(stderr, "i2c_sim: the block must fit in the %u byte EEPROM\n", SIM_24LC32_SIZE);
+		return 2;
+	}
+	
+	sim_init();
+	sim_24lc32_init(&eeprom, EEPROM_ADDR);
+	sim_ft6x06_init(&touch, FT6X06_ADDR, GPIOF_BASE, FT6X06_IRQ_PIN_NUM);
+	sim_mcp23017_init(&pexp, MCP23017_ADDR, GPIOF_BASE, PEXP_IRQ_PIN_NUM);
+	i2cStatsSetClock(sim_ticks);
+	
+	if(!eeprom_init() || !ft6x06_init() || !port_expander_init()){
+		fprintf(stderr, "FAIL: device init\n");
+		return 1;
+	}
+	
+	test_eeprom(address, len);
+	test_inputs();
+	bench_engines(reads);
+	
+	if(failures != 0){
+		fprintf(stderr, "FAIL: %u checks failed\n", failures);
+		return 1;
+	}
+	return 0;
+}
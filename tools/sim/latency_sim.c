@@ -0,0 +1,401 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Replays a script of joystick positions through ADC0 into the game's
+// input-to-photon trace, HW4/latency.c, on the host.  The joystick's ADC
+// sequencer, ps2.c and adc.c, and the trace, timed by Timer1, run against
+// the models in sim_hw.c.  The game, galaga.c, draws through lcd.c onto
+// plain memory, with a mirror that checks each move lands on the screen.
+//
+// The game's own main_game.c runs as main.c's loop runs it in the MAIN_GAME
+// state: main_game_tick every 10ms, which moves the bullets and on every
+// fifth tick starts a joystick sample on SS2 and moves and redraws the
+// enemies.  Its ADC0SS2_Handler stamps the sample, and once the tick's work
+// is done the loop hands it to main_game_joystick, which moves the ship and
+// records the sample when the ship has been drawn.  The enemies' roll off
+// Timer0, which is not modelled, never fires, so the ship lives through
+// the whole script.
+//
+// Every recorded sample is also timed on sim_now, and the percentiles
+// latency_report prints are checked against those.  Timer1 is started
+// near the end of its count so it wraps during the run.  The times are
+// the host's for the CPU's work and the model's for the ADC's.
+//
+// Usage:
+//   ./latency_sim [-v]
+//
+// -v prints each sample as it is recorded.
+// Exits with 1 if a move is missed or not drawn, or the report differs
+// from the samples.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim_hw.h"
+#include "main.h"
+#include "ps2.h"
+#include "lcd.h"
+#include "galaga.h"
+#include "input.h"
+#include "latency.h"
+#include "main_game.h"
+
+// Timer A's period, as main.c
+#define TICK_NS							10000000ULL
+
+// The board's 50MHz core clock
+#define NS_PER_TICK					20
+
+// Timer1 is started this long before it wraps
+#define WRAP_AFTER_NS				1000000000ULL
+
+// Time the script runs for after its last step
+#define SETTLE_US						300000
+
+// How far the report may be from the samples timed on sim_now, 10us and
+// 5% of the sample.  Timer1 is read through a trap, whose host cost varies
+// while only its least is taken out of sim_now, a busy host adds a part
+// of each stall it takes out, and the report truncates to a microsecond.
+#define SLACK_US						10
+#define SLACK_PERCENT				5
+
+// The sprite lcd_print_Image draws the ship with
+#define SHIP_SIZE						24
+
+#define ARRAY_LEN(a)				(sizeof(a) / sizeof((a)[0]))
+
+typedef struct {
+	uint32_t	at_us;						// from the start of the run
+	uint16_t	x;
+	uint16_t	y;
+} joystick_t;
+
+// Each step starts halfway between two samples, so which one a sample
+// sees does not depend on how late the host runs the tick.  x at or past
+// 0xBFD moves the ship one way and at or below 0x3FF the other, as
+// main_game.h sets them, y does nothing in the game.
+static const joystick_t script[] = {
+	{       0, 0x800, 0x800 },
+	{  325000, 0xFFF, 0x800 },
+	{ 1525000, 0x800, 0x800 },
+	{ 2025000, 0x000, 0x800 },
+	{ 4025000, 0xFFF, 0x800 },
+	{ 5025000, 0x900, 0x200 },
+	{ 5525000, 0x000, 0xFFF },
+	{ 7025000, 0xBFD, 0x800 },
+	{ 7525000, 0x3FF, 0x800 },
+	{ 8025000, 0x800, 0x800 },
+};
+
+// Stand-ins for the modules galaga.c and main_game.c use
+uint32_t high_scores[NUM_HIGH_SCORES];
+uint32_t hs_initials[NUM_HIGH_SCORES];
+input_buttons_t input_buttons;
+
+void telemetry_score(uint32_t score, uint16_t points, uint8_t unit_type){
+}
+
+void trace_log(uint16_t id, uint32_t arg0, uint32_t arg1){
+}
+
+static uint64_t start_ns;
+static uint32_t failures = 0;
+static bool verbose = false;
+
+// Samples timed on sim_now, in the ring order latency.c keeps them
+static uint64_t samples_ns[LATENCY_NUM_SAMPLES];
+static uint32_t num_samples = 0;
+
+// What latency_report printed
+static char report[512];
+static uint32_t report_len = 0;
+
+// The last window drawn and the pixels written into it
+static uint16_t window_x0, window_x1, window_y0, window_y1;
+static uint32_t window_pixels;
+
+static void fail(const char *what, uint32_t n){
+	fprintf(stderr, "FAIL: %s at %u\n", what, n);
+	failures++;
+}
+
+//*****************************************************************************
+// Function Name: put_string
+//*****************************************************************************
+//	Summary: Stands in for the serial debug port, keeps the report to check
+//					 and echoes it to stderr
+//
+//*****************************************************************************
+void put_string(char *data){
+	uint32_t len = strlen(data);
+	
+	if(report_len + len < sizeof(report)){
+		memcpy(report + report_len, data, len + 1);
+		report_len += len;
+	}
+	for(; *data != '\0'; data += len){
+		len = strcspn(data, "\r");
+		fwrite(data, 1, len, stderr);
+		if(data[len] == '\r') len++;
+	}
+}
+
+static void mirror_window(uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1){
+	window_x0 = x0;
+	window_x1 = x1;
+	window_y0 = y0;
+	window_y1 = y1;
+	window_pixels = 0;
+}
+
+static void mirror_pixel(uint16_t color){
+	window_pixels++;
+}
+
+static const lcd_mirror_t mirror = { mirror_window, mirror_pixel };
+
+//*****************************************************************************
+// Function Name: joystick
+//*****************************************************************************
+//	Summary: The ADC source.  Reads the script step in effect at now on the
+//					 joystick's channels, and mid-scale on any other.
+//
+//*****************************************************************************
+static uint16_t joystick(uint32_t channel, uint64_t now){
+	uint64_t us = (now - start_ns) / 1000;
+	uint32_t i;
+	
+	for(i = 0; i + 1 < ARRAY_LEN(script) && script[i + 1].at_us <= us; i++);
+	if(channel == PS2_X_ADC_CHANNEL) return script[i].x;
+	if(channel == PS2_Y_ADC_CHANNEL) return script[i].y;
+	return 0x800;
+}
+
+//*****************************************************************************
+// Function Name: expected_moves
+//*****************************************************************************
+//	Summary: Counts the samples taken before end_us, one every
+//					 MAIN_GAME_SAMPLE_TICKS ticks, that find the stick far enough
+//					 over to move the ship
+//
+//*****************************************************************************
+static uint32_t expected_moves(uint64_t end_us){
+	uint64_t us, step = MAIN_GAME_SAMPLE_TICKS * TICK_NS / 1000;
+	uint32_t i, moves = 0;
+	
+	for(us = step; us < end_us; us += step){
+		for(i = 0; i + 1 < ARRAY_LEN(script) && script[i + 1].at_us <= us; i++);
+		if(script[i].x >= MAIN_GAME_STICK_HIGH || script[i].x <= MAIN_GAME_STICK_LOW) moves++;
+	}
+	return moves;
+}
+
+//*****************************************************************************
+// Function Name: check_drawn
+//*****************************************************************************
+//	Summary: Checks the last thing drawn is the whole ship where the game
+//					 now has it
+//
+//*****************************************************************************
+static void check_drawn(uint32_t n){
+	entity_info_t ship;
+	
+	get_entity(0, &ship);
+	if(window_x0 != ship.x || window_x1 != ship.x + SHIP_SIZE - 1 ||
+		 window_y0 != ship.y || window_y1 != ship.y + SHIP_SIZE - 1){
+		fail("ship not drawn where it is", n);
+	}
+	if(window_pixels != SHIP_SIZE * SHIP_SIZE) fail("ship drawn partly", n);
+}
+
+//*****************************************************************************
+// Function Name: play_sample
+//*****************************************************************************
+//	Summary: Hands a sample to main_game_joystick.  Each one that moves the
+//					 ship must be recorded once it has been drawn, and is timed on
+//					 sim_now from when ADC0SS2_Handler was entered.
+//
+//*****************************************************************************
+static void play_sample(uint32_t x_value, uint32_t y_value){
+	uint64_t stamp_ns = sim_get_stats()->adc_isr_at;
+	entity_info_t ship;
+	uint64_t ns;
+	
+	if(x_value < MAIN_GAME_STICK_HIGH && x_value > MAIN_GAME_STICK_LOW){
+		main_game_joystick(x_value, y_value);
+		return;
+	}
+	get_entity(0, &ship);
+	if(!ship.active){
+		fail("ship gone", x_value);
+		return;
+	}
+	
+	main_game_joystick(x_value, y_value);
+	ns = sim_now() - stamp_ns;
+	samples_ns[num_samples & (LATENCY_NUM_SAMPLES - 1)] = ns;
+	num_samples++;
+	check_drawn(num_samples);
+	if(verbose) fprintf(stderr, "  sample %u: x 0x%03x, %.1f us\n", num_samples, x_value, ns / 1e3);
+}
+
+//*****************************************************************************
+// Function Name: run_script
+//*****************************************************************************
+//	Summary: Plays the script through main_game.c as main.c's loop calls it
+//
+//*****************************************************************************
+static void run_script(void){
+	uint64_t end = (script[ARRAY_LEN(script) - 1].at_us + SETTLE_US) * 1000ULL;
+	uint64_t next_tick;
+	int counter = 0;
+	uint32_t x_value, y_value;
+	
+	start_ns = sim_now();
+	next_tick = start_ns + TICK_NS;
+	while(sim_now() - start_ns < end){
+		if(sim_now() >= next_tick){
+			next_tick += TICK_NS;
+			counter = (counter + 1) % TIMER_A_CYCLES;
+			if(!main_game_tick(counter)){
+				fail("game over", counter);
+				return;
+			}
+		}
+		
+		if(joystick_read(&x_value, &y_value)) play_sample(x_value, y_value);
+		sim_wait();
+	}
+}
+
+// Sample number p percent of the way through, as latency_report picks it
+static uint64_t percentile(const uint64_t *sorted, uint32_t n, uint32_t p){
+	return sorted[(n * p) / 100];
+}
+
+static int compare_ns(const void *a, const void *b){
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	
+	return (x > y) - (x < y);
+}
+
+//*****************************************************************************
+// Function Name: check_value
+//*****************************************************************************
+//	Summary: Finds label in the report and checks the microseconds after it
+//					 are within the slack of ns
+//
+//*****************************************************************************
+static void check_value(const char *label, uint64_t ns){
+	const char *at = strstr(report, label);
+	long us, slack = SLACK_US + (long)(ns / 1000) * SLACK_PERCENT / 100;
+	
+	if(at == NULL){
+		fail(label, 0);
+		return;
+	}
+	us = strtol(at + strlen(label), NULL, 10);
+	if(us + slack < (long)(ns / 1000) || us > (long)(ns / 1000) + slack){
+		fprintf(stderr, "FAIL: report%s%ldus, timed %.1fus\n", label, us, ns / 1e3);
+		failures++;
+	}
+}
+
+//*****************************************************************************
+// Function Name: check_report
+//*****************************************************************************
+//	Summary: Runs latency_report and checks its count and percentiles
+//					 against the samples timed here
+//
+//*****************************************************************************
+static void check_report(void){
+	uint64_t sorted[LATENCY_NUM_SAMPLES];
+	uint32_t n = num_samples < LATENCY_NUM_SAMPLES ? num_samples : LATENCY_NUM_SAMPLES;
+	const char *at;
+	
+	report_len = 0;
+	report[0] = '\0';
+	latency_report();
+	
+	at = strstr(report, "samples ");
+	if(at == NULL || strtoul(at + strlen("samples "), NULL, 10) != n) fail("report sample count", n);
+	if(n == 0) return;
+	
+	memcpy(sorted, samples_ns, n * sizeof(sorted[0]));
+	qsort(sorted, n, sizeof(sorted[0]), compare_ns);
+	check_value("  p50 ", percentile(sorted, n, 50));
+	check_value("  p90 ", percentile(sorted, n, 90));
+	check_value("  p99 ", percentile(sorted, n, 99));
+	check_value("  max ", sorted[n - 1]);
+}
+
+int main(int argc, char **argv){
+	const sim_stats_t *stats;
+	uint32_t expected, before;
+	int opt;
+	
+	while((opt = getopt(argc, argv, "v")) != -1){
+		switch(opt){
+			case 'v':	verbose = true; break;
+			default:
+				fprintf(stderr, "usage: latency_sim [-v]\n");
+				return 2;
+		}
+	}
+	
+	sim_init();
+	sim_adc_set_source(joystick);
+	
+	ps2_initialize_HW3();
+	lcd_config_gpio();
+	latency_init();
+	
+	// Close to the end of the count, so it wraps early in the script
+	TIMER1->TAV = 0 - (uint32_t)(WRAP_AFTER_NS / NS_PER_TICK);
+	before = latency_now();
+	
+	game_init();
+	lcd_set_mirror(&mirror);
+	run_script();
+	
+	if(latency_now() >= before) fail("Timer1 did not wrap", latency_now());
+	expected = expected_moves((sim_now() - start_ns) / 1000);
+	fprintf(stderr, "%u moves recorded, the script has %u\n", num_samples, expected);
+	if(num_samples != expected) fail("moves recorded", num_samples);
+	check_report();
+	
+	stats = sim_get_stats();
+	fprintf(stderr, "adc %llu samples, %llu overflows, %llu interrupts; %llu timer reads\n",
+					(unsigned long long)stats->adc_samples, (unsigned long long)stats->adc_overflows,
+					(unsigned long long)stats->adc_isr_entries, (unsigned long long)stats->timer_reads);
+	if(stats->adc_overflows != 0) fail("ADC FIFO overflow", stats->adc_overflows);
+	
+	if(failures != 0){
+		fprintf(stderr, "FAIL: %u checks failed\n", failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,246 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Stress test of the SPSC ring in drivers/c/ring_buffer.c.  A producer and
+// a consumer thread stand in for the main loop and the UART ISR and move a
+// known byte stream through a small ring, so every call meets the end of
+// the array and the other side moving at the same time.  The consumer
+// checks every byte it gets.
+//
+// The producer pushes with ring_push_bulk, ring_push and ring_push_byte.
+// The consumer takes with ring_pop_bulk, ring_pop_byte, ring_read_span and
+// ring_consume, and ring_peek_span at an offset before consuming, as the
+// uDMA TX path does.  head and tail start just short of 2^32, so the free
+// running indexes wrap as well.
+//
+// Built by the Makefile in this directory, "make check" runs it.  Races
+// show up faster with more than one CPU.
+//
+// Usage:
+//   ./ring_stress [-n bytes] [-s seed]
+//
+// -n is the number of bytes to move, 16M by default.  Exits with 1 if a
+// byte arrives out of order or a span runs past the data pushed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "ring_buffer.h"
+
+// Small, so most bulk calls split at the end of the array
+#define RING_SIZE			64
+
+// Largest single push or pop, more than the ring holds
+#define MAX_CHUNK			(RING_SIZE + RING_SIZE / 2)
+
+RING_DEFINE(ring, uint8_t, RING_SIZE);
+
+static uint32_t num_bytes = 16u << 20;
+static unsigned int seed = 1;
+
+// Written by the consumer only
+static uint32_t received = 0;
+static uint32_t mismatches = 0;
+static uint32_t bad_spans = 0;
+static uint32_t split_spans = 0;
+
+//*****************************************************************************
+// Function Name: pattern
+//*****************************************************************************
+//	Summary: Byte n of the test stream.  Not periodic in the ring size, so a
+//					 span seen twice or skipped shows up.
+//
+//*****************************************************************************
+static uint8_t pattern(uint32_t n){
+	return (uint8_t)(n ^ (n >> 8) ^ (n >> 13));
+}
+
+// Checks len bytes that should start offset bytes past the next one due
+static void check_at(const uint8_t *data, uint32_t len, uint32_t offset){
+	uint32_t i, n;
+	
+	for(i = 0; i < len; i++){
+		n = received + offset + i;
+		if(data[i] != pattern(n) && mismatches++ < 5){
+			fprintf(stderr, "byte %u is 0x%02x, expected 0x%02x\n", n, data[i], pattern(n));
+		}
+	}
+}
+
+static void check_bytes(const uint8_t *data, uint32_t len){
+	check_at(data, len, 0);
+	received += len;
+}
+
+//*****************************************************************************
+// Function Name: producer
+//*****************************************************************************
+//	Summary: Pushes the stream in random sized pieces, a third of them a byte
+//					 at a time, yielding when the ring is full
+//
+//*****************************************************************************
+static void *producer(void *arg){
+	uint8_t buf[MAX_CHUNK];
+	uint32_t sent = 0, len, i;
+	unsigned int state = seed;
+	
+	(void)arg;
+	while(sent < num_bytes){
+		len = 1 + rand_r(&state) % MAX_CHUNK;
+		if(len > num_bytes - sent) len = num_bytes - sent;
+		for(i = 0; i < len; i++) buf[i] = pattern(sent + i);
+		
+		switch(rand_r(&state) % 3){
+			case 0:
+				sent += ring_push_bulk(&ring, buf, len);
+				break;
+			case 1:
+				for(i = 0; i < len && ring_push_byte(&ring, buf[i]); i++);
+				sent += i;
+				break;
+			default:
+				for(i = 0; i < len && ring_push(&ring, &buf[i]); i++);
+				sent += i;
+				break;
+		}
+		if(ring_full(&ring)) sched_yield();
+	}
+	return NULL;
+}
+
+//*****************************************************************************
+// Function Name: consume_spans
+//*****************************************************************************
+//	Summary: Takes up to len bytes the way the uDMA TX path does: peeks at
+//					 the span after the first, then reads and consumes the first.
+//					 A span must never be longer than the ring holds past its
+//					 start, nor cross the end of the array.
+//
+//*****************************************************************************
+static uint32_t consume_spans(uint32_t len){
+	const void *span, *next;
+	uint32_t count, more;
+	
+	// The producer only ever adds, so a span longer than what the ring
+	// holds afterwards covers bytes not yet pushed
+	count = ring_read_span(&ring, &span);
+	if(count == 0) return 0;
+	if(count > ring_count(&ring)) bad_spans++;
+	if((const uint8_t *)span + count > ring_array + RING_SIZE) bad_spans++;
+	
+	// Whatever follows the first span must check out too, before it is
+	// consumed
+	more = ring_peek_span(&ring, count, &next);
+	if(more != 0){
+		split_spans++;
+		if(next != ring_array) bad_spans++;
+		if(count + more > ring_count(&ring)) bad_spans++;
+		check_at(next, more, count);
+	}
+	
+	if(count > len) count = len;
+	check_bytes(span, count);
+	ring_consume(&ring, count);
+	return count;
+}
+
+//*****************************************************************************
+// Function Name: consumer
+//*****************************************************************************
+//	Summary: Takes the stream back in random sized pieces with each of the
+//					 ways the ring offers, yielding when it is empty
+//
+//*****************************************************************************
+static void *consumer(void *arg){
+	uint8_t buf[MAX_CHUNK];
+	uint32_t len, got;
+	unsigned int state = seed * 7 + 1;
+	
+	(void)arg;
+	while(received < num_bytes){
+		len = 1 + rand_r(&state) % MAX_CHUNK;
+		
+		switch(rand_r(&state) % 3){
+			case 0:
+				got = ring_pop_bulk(&ring, buf, len);
+				check_bytes(buf, got);
+				break;
+			case 1:
+				for(got = 0; got < len && ring_pop_byte(&ring, &buf[got]); got++);
+				check_bytes(buf, got);
+				break;
+			default:
+				got = consume_spans(len);
+				break;
+		}
+		if(got == 0) sched_yield();
+	}
+	return NULL;
+}
+
+int main(int argc, char **argv){
+	pthread_t prod, cons;
+	struct timespec t0, t1;
+	double elapsed;
+	int opt;
+	
+	while((opt = getopt(argc, argv, "n:s:")) != -1){
+		switch(opt){
+			case 'n':	num_bytes = strtoul(optarg, NULL, 0); break;
+			case 's':	seed = strtoul(optarg, NULL, 0); break;
+			default:
+				fprintf(stderr, "usage: ring_stress [-n bytes] [-s seed]\n");
+				return 2;
+		}
+	}
+	
+	// Start near the top so head and tail wrap around 2^32 early on
+	ring.head = ring.tail = 0u - 1000u;
+	
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	if(pthread_create(&prod, NULL, producer, NULL) != 0 || pthread_create(&cons, NULL, consumer, NULL) != 0){
+		perror("ring_stress: pthread_create");
+		return 2;
+	}
+	pthread_join(prod, NULL);
+	pthread_join(cons, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	
+	fprintf(stderr, "moved %u bytes through a %u byte ring in %.3f s, %.1f MB/s\n",
+					received, RING_SIZE, elapsed, received / elapsed / 1e6);
+	fprintf(stderr, "%u spans split at the end of the array, %u bad spans, %u bytes out of order\n",
+					split_spans, bad_spans, mismatches);
+	
+	if(received != num_bytes || mismatches != 0 || bad_spans != 0 || !ring_empty(&ring)){
+		fprintf(stderr, "FAIL\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,517 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Power failure test of the record log, HW4/record_log.c, against an
+// in-memory 24LC32.  The EEPROM calls record_log makes are answered from a
+// 4KB array with the chip's 32 byte page wrap.  The power can be cut at
+// any write: that write is torn, each byte left old, new or garbage, and
+// every write after it is lost.  A reboot is another rlog_mount, and what
+// it recovers is compared with a copy of every value appended.  The model
+// also counts what each mount reads and the bus time that would take, the
+// boot cost the scan_ticks stat cannot show without a clock.
+//
+// The tests:
+//   torn      random appends cut at random writes, the recovery mount
+//             included, many times over
+//   compact   the append that finds a bank full cut at each write of the
+//             compaction it starts, of the mount that finishes it, and of
+//             the compaction after that
+//   wrap      many banks' worth of appends with reboots in between, and a
+//             sequence number that wraps past 2^32
+//
+// After a cut, the values must be those before the append that was cut
+// short.  The log must also go on working for several more banks, which
+// is when a record left behind in the wrong bank would be overwritten.
+//
+// Built by the Makefile in this directory, "make check" runs it.
+//
+// Usage:
+//   ./rlog_test [-s seed]
+//
+// Exits with 1 if any recovered value is wrong.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "eeprom.h"
+#include "crc16.h"
+#include "record_log.h"
+
+#define EEPROM_SIZE				4096
+#define EEPROM_PAGE				32
+
+// SCL period with MTPR = 6 at 50MHz, as initializeI2CMaster sets it
+#define I2C_BIT_NS				2800
+// A random read is START, control, two address bytes, repeated START,
+// control, the data and STOP, each byte 9 clocks
+#define I2C_READ_BITS(len)	(3 + 9 * (4 + (len)))
+
+// Indexes in use, as high_scores.c has
+#define NUM_INDEX					6
+
+static uint8_t eeprom[EEPROM_SIZE];
+static int writes_left = -1;				// writes before the power is cut, -1 never
+static bool power_off = false;
+static uint32_t page_writes = 0;
+static uint32_t cuts = 0;
+
+// Read by the model, and per mount
+static uint64_t read_bytes = 0;
+static uint64_t read_pages = 0;
+static uint64_t read_bits = 0;
+static uint32_t mounts = 0;
+static uint64_t mount_bytes = 0, mount_pages = 0, mount_bits = 0;
+static uint64_t max_mount_bytes = 0, max_mount_pages = 0, max_mount_bits = 0;
+
+// What the log should hold
+static uint8_t expect[NUM_INDEX][RLOG_DATA_SIZE];
+static uint8_t expect_found = 0;
+
+static unsigned int rng = 1;
+static uint32_t failures = 0;
+
+static uint32_t random_u32(void){
+	return (uint32_t)rand_r(&rng) << 16 ^ (uint32_t)rand_r(&rng);
+}
+
+//*****************************************************************************
+// EEPROM model
+//*****************************************************************************
+
+//*****************************************************************************
+// Function Name: page_write
+//*****************************************************************************
+//	Summary: One write cycle.  Like the chip, bytes past the end of the page
+//					 wrap to its start.  A torn write leaves each byte old, new or
+//					 garbage at random.
+//
+//*****************************************************************************
+static void page_write(uint16_t address, const uint8_t *data, uint16_t len, bool torn){
+	uint16_t page = address & ~(EEPROM_PAGE - 1);
+	uint16_t i, a;
+	
+	for(i = 0; i < len; i++){
+		a = page + ((address + i) & (EEPROM_PAGE - 1));
+		if(!torn) eeprom[a] = data[i];
+		else switch(rand_r(&rng) % 3){
+			case 0:	break;
+			case 1:	eeprom[a] = data[i]; break;
+			default: eeprom[a] = rand_r(&rng); break;
+		}
+	}
+	page_writes++;
+}
+
+//*****************************************************************************
+// Function Name: eeprom_read
+//*****************************************************************************
+//	Summary: Counts the bytes, the pages they span and the bus clocks of
+//					 one transaction per 255 bytes, as eeprom.c splits them
+//
+//*****************************************************************************
+i2c_status_t eeprom_read(uint32_t i2c_base, uint16_t address, uint8_t *data, uint16_t len){
+	uint16_t i, chunk;
+	
+	(void)i2c_base;
+	for(i = 0; i < len; i++) data[i] = eeprom[(address + i) % EEPROM_SIZE];
+	
+	if(len == 0) return I2C_OK;
+	read_bytes += len;
+	read_pages += (address + len - 1) / EEPROM_PAGE - address / EEPROM_PAGE + 1;
+	for(i = 0; i < len; i += chunk){
+		chunk = (len - i > 255) ? 255 : len - i;
+		read_bits += I2C_READ_BITS(chunk);
+	}
+	return I2C_OK;
+}
+
+//*****************************************************************************
+// Function Name: eeprom_queue_write
+//*****************************************************************************
+//	Summary: Written at once, a page at a time.  The queue on the board
+//					 writes in the same order, so cutting the power here after n
+//					 page writes is the same as cutting it with the queue part
+//					 drained.  The caller is never told.
+//
+//*****************************************************************************
+i2c_status_t eeprom_queue_write(uint32_t i2c_base, uint16_t address, const uint8_t *data, uint16_t len){
+	uint16_t chunk;
+	
+	(void)i2c_base;
+	while(len > 0 && !power_off){
+		chunk = EEPROM_PAGE - (address & (EEPROM_PAGE - 1));
+		if(chunk > len) chunk = len;
+		if(writes_left == 0){
+			page_write(address, data, chunk, true);
+			power_off = true;
+			cuts++;
+			break;
+		}
+		if(writes_left > 0) writes_left--;
+		page_write(address, data, chunk, false);
+		address += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+	return I2C_OK;
+}
+
+i2c_status_t eeprom_queue_read(uint32_t i2c_base, uint16_t address, uint8_t *data, uint16_t len){
+	return eeprom_read(i2c_base, address, data, len);
+}
+
+uint16_t eeprom_queue_pending(void){
+	return 0;
+}
+
+// rlog_report is not used here
+void put_string(char *data){
+	(void)data;
+}
+
+void itoa(uint32_t source, char *dest){
+	sprintf(dest, "%u", source % 100000000);
+}
+
+//*****************************************************************************
+// Checks
+//*****************************************************************************
+
+//*****************************************************************************
+// Function Name: mount
+//*****************************************************************************
+//	Summary: rlog_mount, adding what it read to the per mount totals
+//
+//*****************************************************************************
+static uint8_t mount(uint8_t data[][RLOG_DATA_SIZE]){
+	uint64_t bytes = read_bytes, pages = read_pages, bits = read_bits;
+	uint8_t found;
+	
+	found = rlog_mount(data, NUM_INDEX);
+	
+	bytes = read_bytes - bytes;
+	pages = read_pages - pages;
+	bits = read_bits - bits;
+	mounts++;
+	mount_bytes += bytes;
+	mount_pages += pages;
+	mount_bits += bits;
+	if(bytes > max_mount_bytes) max_mount_bytes = bytes;
+	if(pages > max_mount_pages) max_mount_pages = pages;
+	if(bits > max_mount_bits) max_mount_bits = bits;
+	return found;
+}
+
+//*****************************************************************************
+// Function Name: reboot
+//*****************************************************************************
+//	Summary: Restores the power, mounts the log and compares what it found
+//					 with what was appended.  what names the check in a failure.
+//
+//*****************************************************************************
+static void reboot(const char *what){
+	uint8_t data[NUM_INDEX][RLOG_DATA_SIZE];
+	uint8_t found;
+	int i;
+	
+	power_off = false;
+	writes_left = -1;
+	memset(data, 0, sizeof(data));
+	found = mount(data);
+	
+	if(found != expect_found){
+		if(failures++ < 10) fprintf(stderr, "%s: found 0x%02x, expected 0x%02x\n", what, found, expect_found);
+		return;
+	}
+	for(i = 0; i < NUM_INDEX; i++){
+		if((found & (1 << i)) && memcmp(data[i], expect[i], RLOG_DATA_SIZE) != 0){
+			if(failures++ < 10) fprintf(stderr, "%s: index %d does not hold the last value appended\n", what, i);
+		}
+	}
+}
+
+//*****************************************************************************
+// Function Name: append
+//*****************************************************************************
+//	Summary: Appends a random value to a random index, or to index if it is
+//					 not negative.  The copy is only updated if the power stayed on,
+//					 as the value is lost otherwise.
+//
+//*****************************************************************************
+static void append(int index){
+	uint8_t data[RLOG_DATA_SIZE];
+	int i;
+	
+	if(index < 0) index = rand_r(&rng) % NUM_INDEX;
+	for(i = 0; i < RLOG_DATA_SIZE; i++) data[i] = rand_r(&rng);
+	
+	if(rlog_append(index, data) != I2C_OK){
+		if(failures++ < 10) fprintf(stderr, "append to %d failed\n", index);
+		return;
+	}
+	if(!power_off){
+		memcpy(expect[index], data, RLOG_DATA_SIZE);
+		expect_found |= 1 << index;
+	}
+}
+
+static void erase(void){
+	memset(eeprom, 0xFF, sizeof(eeprom));
+	memset(expect, 0, sizeof(expect));
+	expect_found = 0;
+	reboot("erased");
+}
+
+//*****************************************************************************
+// Function Name: keep_going
+//*****************************************************************************
+//	Summary: Appends three banks' worth with a reboot after each, so every
+//					 slot of both banks is written again
+//
+//*****************************************************************************
+static void keep_going(const char *what){
+	int bank, i;
+	
+	for(bank = 0; bank < 3; bank++){
+		for(i = 0; i < RLOG_SLOTS_PER_BANK; i++) append(-1);
+		reboot(what);
+	}
+}
+
+//*****************************************************************************
+// Tests
+//*****************************************************************************
+
+//*****************************************************************************
+// Function Name: test_torn
+//*****************************************************************************
+//	Summary: Random runs of appends, each cut at a random write that may fall
+//					 in the recovery mount as well
+//
+//*****************************************************************************
+static void test_torn(void){
+	uint8_t data[NUM_INDEX][RLOG_DATA_SIZE];
+	int trial, cut, n;
+	
+	for(trial = 0; trial < 200; trial++){
+		erase();
+		for(cut = 0; cut < 8; cut++){
+			writes_left = rand_r(&rng) % (2 * RLOG_SLOTS_PER_BANK);
+			for(n = 0; n < 4 * RLOG_SLOTS_PER_BANK && !power_off; n++) append(-1);
+			
+			// Sometimes cut the recovery short as well
+			if(rand_r(&rng) % 4 == 0){
+				power_off = false;
+				writes_left = rand_r(&rng) % NUM_INDEX;
+				mount(data);
+			}
+			reboot("torn");
+		}
+		keep_going("torn, after");
+	}
+}
+
+//*****************************************************************************
+// Function Name: fill_bank
+//*****************************************************************************
+//	Summary: Appends to index until the next append would start a
+//					 compaction.  Each append is made on a copy of the EEPROM and
+//					 undone if it compacted, so the log is left with its active
+//					 bank full.
+//
+//*****************************************************************************
+static void fill_bank(int index){
+	static uint8_t saved[EEPROM_SIZE];
+	uint8_t saved_expect[NUM_INDEX][RLOG_DATA_SIZE];
+	uint8_t saved_found;
+	uint32_t compactions;
+	
+	while(1){
+		memcpy(saved, eeprom, sizeof(saved));
+		memcpy(saved_expect, expect, sizeof(saved_expect));
+		saved_found = expect_found;
+		compactions = rlog_stats.compactions;
+		append(index);
+		if(rlog_stats.compactions != compactions) break;
+	}
+	memcpy(eeprom, saved, sizeof(saved));
+	memcpy(expect, saved_expect, sizeof(expect));
+	expect_found = saved_found;
+	reboot("compact, bank full");
+}
+
+//*****************************************************************************
+// Function Name: cut_compaction
+//*****************************************************************************
+//	Summary: Fills the active bank with index 0, then cuts the append to
+//					 index 0 that compacts it at write at.  The compaction copies
+//					 indexes 1 to NUM_INDEX - 1 in order and then writes the new
+//					 record.  If again is not negative, the mount that finishes
+//					 the compaction is cut at its write again as well.
+//
+//*****************************************************************************
+static void cut_compaction(int at, int again){
+	uint8_t data[NUM_INDEX][RLOG_DATA_SIZE];
+	uint32_t compactions;
+	
+	fill_bank(0);
+	compactions = rlog_stats.compactions;
+	writes_left = at;
+	append(0);
+	if(rlog_stats.compactions == compactions || !power_off){
+		if(failures++ < 10) fprintf(stderr, "compact: the append did not compact\n");
+	}
+	
+	if(again >= 0){
+		power_off = false;
+		writes_left = again;
+		mount(data);
+	}
+	reboot("compact");
+}
+
+//*****************************************************************************
+// Function Name: test_compact
+//*****************************************************************************
+//	Summary: Cuts a compaction at each of its writes, with and without the
+//					 recovery cut short, then cuts the next compaction at each of
+//					 its writes.  That one overwrites the bank the first one left.
+//					 Bank 0 starts with the indexes in reverse, so the first slots
+//					 it overwrites hold the records it copies last: a live record
+//					 the mount did not copy forward would be lost.  The
+//					 compaction wrapping back from bank 1 is tried as well.
+//
+//*****************************************************************************
+static void test_compact(void){
+	int first_bank, at, again, next, i;
+	
+	for(first_bank = 0; first_bank < 2; first_bank++){
+		for(at = 0; at < NUM_INDEX; at++){
+			for(again = -1; again < NUM_INDEX; again++){
+				for(next = 0; next < NUM_INDEX; next++){
+					erase();
+					for(i = 0; i < NUM_INDEX; i++) append(NUM_INDEX - 1 - i);
+					if(first_bank == 1){
+						fill_bank(0);
+						append(0);
+					}
+					
+					cut_compaction(at, again);
+					cut_compaction(next, -1);
+					keep_going("compact, after");
+				}
+			}
+		}
+	}
+}
+
+//*****************************************************************************
+// Function Name: write_raw
+//*****************************************************************************
+//	Summary: Writes a record into the EEPROM image the way record_log.c lays
+//					 it out, for starting from a chosen sequence number
+//
+//*****************************************************************************
+static void write_raw(uint16_t addr, uint8_t index, uint32_t seq, const uint8_t *data){
+	uint8_t *rec = &eeprom[addr];
+	uint16_t crc;
+	int i;
+	
+	rec[0] = RLOG_MAGIC;
+	rec[1] = index;
+	for(i = 0; i < 4; i++) rec[2+i] = (seq >> (8*i)) & 0xFF;
+	memcpy(rec + 6, data, RLOG_DATA_SIZE);
+	crc = crc16(CRC16_INIT, rec, RLOG_RECORD_SIZE - 2);
+	rec[RLOG_RECORD_SIZE-2] = crc & 0xFF;
+	rec[RLOG_RECORD_SIZE-1] = crc >> 8;
+}
+
+//*****************************************************************************
+// Function Name: test_wrap
+//*****************************************************************************
+//	Summary: Ten banks of appends with a reboot at random points, then the
+//					 same starting from sequence numbers just short of 2^32
+//
+//*****************************************************************************
+static void test_wrap(void){
+	uint32_t compactions, i;
+	int start;
+	
+	for(start = 0; start < 2; start++){
+		erase();
+		if(start == 1){
+			for(i = 0; i < NUM_INDEX; i++){
+				append(i);
+				write_raw(RLOG_START + i * RLOG_RECORD_SIZE, i, 0xFFFFFFF0u + i, expect[i]);
+			}
+			reboot("wrap, seq");
+		}
+		
+		compactions = rlog_stats.compactions;
+		for(i = 0; i < 10 * RLOG_SLOTS_PER_BANK; i++){
+			append(-1);
+			if(random_u32() % 50 == 0) reboot("wrap");
+		}
+		reboot("wrap");
+		if(rlog_stats.compactions - compactions < 9){
+			if(failures++ < 10) fprintf(stderr, "wrap: only %u compactions\n", rlog_stats.compactions - compactions);
+		}
+	}
+}
+
+int main(int argc, char **argv){
+	int opt;
+	
+	while((opt = getopt(argc, argv, "s:")) != -1){
+		switch(opt){
+			case 's':	rng = strtoul(optarg, NULL, 0); break;
+			default:
+				fprintf(stderr, "usage: rlog_test [-s seed]\n");
+				return 2;
+		}
+	}
+	
+	test_torn();
+	test_compact();
+	test_wrap();
+	
+	fprintf(stderr, "%u power cuts, %u page writes, %u compactions, write amplification %.2f\n",
+					cuts, page_writes, rlog_stats.compactions,
+					rlog_stats.user_writes ? (double)rlog_stats.record_writes / rlog_stats.user_writes : 0.0);
+	if(mounts != 0){
+		fprintf(stderr, "%u mounts, each reads %.0f bytes in %.0f pages (max %llu in %llu), "
+						"%.2fms of I2C (max %.2fms)\n",
+						mounts, (double)mount_bytes / mounts, (double)mount_pages / mounts,
+						(unsigned long long)max_mount_bytes, (unsigned long long)max_mount_pages,
+						(double)mount_bits * I2C_BIT_NS / 1e6 / mounts, (double)max_mount_bits * I2C_BIT_NS / 1e6);
+	}
+	if(failures != 0){
+		fprintf(stderr, "FAIL: %u checks\n", failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,1205 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Register level model behind sim_hw.h.  See there for how it works.
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#include "sim_hw.h"
+#include "driver_defines.h"
+#include "udma.h"
+
+#define PERIPH_BASE					0x40000000UL
+#define PERIPH_SIZE					0x00100000UL
+#define PAGE_SIZE						0x1000UL
+
+#define UART_FIFO_SIZE			16
+
+// Host bytes read ahead of the simulated wire
+#define RX_WIRE_SIZE				256
+
+// uDMA channels 8 and 9 signal completion on the UART0 vector when they
+// are mapped to UART0 RX and TX
+#define UART0_DMA_CHANNELS	((1UL << 8) | (1UL << UDMA_CH_UART0_TX))
+
+#define UDMA_CHCTL_XFERSIZE_M	0x00003FF0
+
+// Bits of an I2C byte on the wire, with the ACK
+#define I2C_BYTE_BITS				9
+
+// SCL low and high periods in units of the MTPR timer, fixed by the part
+#define I2C_SCL_CLOCKS			10
+
+// Sample sequencers of an ADC, their FIFO depths and how long one sample
+// takes at the reset rate of 1M samples a second
+#define ADC_NUM_SS					4
+#define ADC_FIFO_MAX				8
+#define ADC_SAMPLE_NS				1000
+#define ADC_SS_STRIDE				(offsetof(ADC0_Type, SSMUX1) - offsetof(ADC0_Type, SSMUX0))
+
+// Joystick at rest, mid-scale
+#define ADC_IDLE_SAMPLE			0x800
+
+#define EFLAGS_TF						0x100			// x86 trap flag, single step
+#define PF_WRITE						0x2				// page fault error code, write access
+
+typedef struct {
+	uint8_t		tx_fifo[UART_FIFO_SIZE];
+	uint32_t	tx_out;							// index of the oldest byte
+	uint32_t	tx_count;
+	bool			tx_busy;						// a byte is in the shift register
+	uint8_t		tx_shift;
+	uint64_t	tx_done;						// time the shift register empties
+	uint64_t	byte_ns;						// one frame at the programmed baud rate
+	uint16_t	rx_fifo[UART_FIFO_SIZE];	// data and error bits, as DR reads
+	uint32_t	rx_out;
+	uint32_t	rx_count;
+	uint64_t	rx_next;						// time the next byte finishes arriving
+	bool			rx_idle;						// nothing was waiting to be sent to us
+	uint64_t	rx_last;						// time the last byte arrived
+	bool			rx_timed_out;				// RTRIS raised since the last byte
+	uint32_t	rsr, ilpr, ibrd, fbrd, lcrh, ctl, ifls, im, ris, dmactl;
+} uart_model_t;
+
+typedef struct {
+	uint32_t	cfg, ctlbase, useburst, reqmask, ena, alt, prio, chis;
+	uint32_t	chmap[4];
+	uint32_t	remaining[UDMA_NUM_CHANNELS];		// of the transfer in progress
+	const uint8_t *src[UDMA_NUM_CHANNELS];
+} udma_model_t;
+
+typedef struct {
+	uint32_t	msa, mdr, mtpr, mimr, mris, mcr;
+	uint32_t	status;							// ERROR, ADRACK and DATACK of the last command
+	bool			busy;								// a command is on the bus
+	uint64_t	done;								// time it finishes
+	uint32_t	next_status;				// what status becomes then
+	bool			next_read;					// and whether MDR takes next_mdr
+	uint8_t		next_mdr;
+	bool			held;								// START sent and no STOP yet
+	bool			reading;
+	sim_i2c_dev_t *dev;						// slave that ACKed the address, NULL if none did
+} i2c_model_t;
+
+typedef struct {
+	uint32_t	actss, ris, im, ostat, emux;
+	uint32_t	ssmux[ADC_NUM_SS], ssctl[ADC_NUM_SS];
+	uint16_t	fifo[ADC_NUM_SS][ADC_FIFO_MAX];
+	uint32_t	fifo_out[ADC_NUM_SS];
+	uint32_t	fifo_count[ADC_NUM_SS];
+	bool			busy[ADC_NUM_SS];			// a sequence is converting
+	uint32_t	step[ADC_NUM_SS];			// the step it is on
+	uint64_t	next[ADC_NUM_SS];			// time that step finishes
+} adc_model_t;
+
+// Timer A of a 32-bit timer, counting the system clock from value at
+// time at
+typedef struct {
+	uint32_t	cfg, tamr, ctl, imr, tailr;
+	uint32_t	value;
+	uint64_t	at;
+} timer_model_t;
+
+// Weak, so a build without the serial stack, the I2C driver or the
+// joystick handler still links.  None runs unless the firmware enables its
+// interrupt.
+__weak void UART0_Handler(void);
+__weak void I2C1_Handler(void);
+__weak void ADC0SS2_Handler(void);
+
+volatile uint32_t sim_primask = 0;
+
+static uart_model_t uart;
+static udma_model_t udma;
+static i2c_model_t i2c;
+static adc_model_t adc;
+static timer_model_t timer1;
+static sim_i2c_dev_t *i2c_devs = NULL;
+static sim_stats_t stats;
+
+static bool nvic_uart0 = false;
+static bool nvic_i2c1 = false;
+static bool nvic_adc0ss2 = false;
+static volatile bool in_isr = false;
+static volatile bool in_i2c_isr = false;
+
+static uint16_t adc_idle(uint32_t channel, uint64_t now){
+	return ADC_IDLE_SAMPLE;
+}
+
+// Where conversion results come from
+static uint16_t (*adc_source)(uint32_t channel, uint64_t now) = adc_idle;
+
+// The access being single stepped, and the sim_now time it was trapped at
+static uint64_t trap_start;
+static uint64_t trap_end;					// sim_now time the last trap finished
+static uintptr_t trap_addr;
+static bool trap_write;
+static bool trap_alarm_blocked;
+
+static void tx_stdout(uint8_t data){
+	if(write(STDOUT_FILENO, &data, 1) < 0) return;
+}
+
+static void (*tx_sink)(uint8_t data) = tx_stdout;
+
+// Where received bytes come from, and those read but not yet on the wire
+static int rx_fd = -1;
+static bool rx_eof = false;
+static uint8_t rx_wire[RX_WIRE_SIZE];
+static uint32_t rx_wire_out = 0;
+static uint32_t rx_wire_count = 0;
+
+// Host time last read, and the stalls taken out of it so far
+static uint64_t clock_last = 0;
+static uint64_t clock_stalled = 0;
+
+// Host time a trap takes outside the part on_segv and on_trap measure: the
+// fault, the signal deliveries and the returns.  Measured by sim_init.
+static uint64_t trap_overhead = 0;
+
+uint64_t sim_now(void){
+	struct timespec ts;
+	uint64_t now, last;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	now = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	
+	// The tick can read the clock in the middle of this, so only the caller
+	// that moves clock_last on counts a stall
+	last = __atomic_load_n(&clock_last, __ATOMIC_SEQ_CST);
+	if(now > last && __atomic_compare_exchange_n(&clock_last, &last, now, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)){
+		if(last != 0 && now - last > SIM_STALL_NS){
+			__atomic_add_fetch(&clock_stalled, now - last - SIM_TICK_US * 1000ULL, __ATOMIC_SEQ_CST);
+		}
+	}
+	return now - __atomic_load_n(&clock_stalled, __ATOMIC_SEQ_CST);
+}
+
+void sim_wake_at(uint64_t when){
+	struct itimerval timer;
+	uint64_t now = sim_now();
+	uint64_t us = (when > now) ? (when - now + 999) / 1000 : 1;
+	
+	getitimer(ITIMER_REAL, &timer);
+	if(us < timer.it_value.tv_sec * 1000000ULL + timer.it_value.tv_usec){
+		timer.it_value.tv_sec = 0;
+		timer.it_value.tv_usec = us;
+		setitimer(ITIMER_REAL, &timer, NULL);
+	}
+}
+
+//*****************************************************************************
+// UART0
+//*****************************************************************************
+static uint32_t uart_depth(void){
+	return (uart.lcrh & UART_LCRH_FEN) ? UART_FIFO_SIZE : 1;
+}
+
+// TX FIFO level the TX interrupt fires at, from IFLS
+static uint32_t uart_tx_trigger(void){
+	static const uint8_t levels[] = { 2, 4, 8, 12, 14 };
+	uint32_t sel = uart.ifls & 0x7;
+	
+	return (sel < sizeof(levels)) ? levels[sel] : 8;
+}
+
+static bool uart_tx_on(void){
+	return (uart.ctl & (UART_CTL_UARTEN | UART_CTL_TXE)) == (UART_CTL_UARTEN | UART_CTL_TXE) && uart.byte_ns != 0;
+}
+
+// Frame length from LCRH times the bit time from the baud divisors
+static void uart_set_baud(void){
+	uint64_t bits = 1 + 5 + ((uart.lcrh >> 5) & 0x3) + ((uart.lcrh & UART_LCRH_STP2) ? 2 : 1) + ((uart.lcrh & UART_LCRH_PEN) ? 1 : 0);
+	uint64_t divisor = uart.ibrd * 64 + uart.fbrd;
+	
+	uart.byte_ns = bits * 16 * divisor * 1000000000ULL / (64 * SIM_CLOCK_HZ);
+}
+
+// RX FIFO level the RX interrupt fires at, from IFLS
+static uint32_t uart_rx_trigger(void){
+	static const uint8_t levels[] = { 2, 4, 8, 12, 14 };
+	uint32_t sel = (uart.ifls >> 3) & 0x7;
+	
+	return (sel < sizeof(levels)) ? levels[sel] : 8;
+}
+
+static bool uart_rx_on(void){
+	return (uart.ctl & (UART_CTL_UARTEN | UART_CTL_RXE)) == (UART_CTL_UARTEN | UART_CTL_RXE) && uart.byte_ns != 0;
+}
+
+static void uart_push(uint8_t data){
+	if(uart.tx_count >= uart_depth()){
+		stats.tx_overflows++;
+		return;
+	}
+	uart.tx_fifo[(uart.tx_out + uart.tx_count) % UART_FIFO_SIZE] = data;
+	uart.tx_count++;
+}
+
+//*****************************************************************************
+// Function Name: dma_run
+//*****************************************************************************
+//	Summary: Moves bytes from the UART0 TX channel's control structures into
+//					 the TX FIFO while it has room, as the UART's DMA requests would.
+//					 A finished structure is written back as stopped and flags the
+//					 channel in CHIS.  Ping-pong then carries on with the other
+//					 structure, or disables the channel if that one is stopped.
+//
+//*****************************************************************************
+static void dma_run(void){
+	uint32_t ch = UDMA_CH_UART0_TX;
+	uint32_t bit = 1UL << ch;
+	udma_entry_t *table = (udma_entry_t *)(uintptr_t)udma.ctlbase;
+	udma_entry_t *entry;
+	uint32_t ctl;
+	
+	if(!(udma.cfg & UDMA_CFG_MASTEN) || (udma.reqmask & bit) || !(uart.dmactl & UART_DMACTL_TXDMAE)) return;
+	if(((udma.chmap[ch >> 3] >> ((ch & 7) * 4)) & 0xF) != UDMA_ENC_UART0_TX) return;
+	
+	while((udma.ena & bit) && uart.tx_count < uart_depth()){
+		entry = &table[ch + ((udma.alt & bit) ? UDMA_NUM_CHANNELS : 0)];
+		ctl = entry->control;
+		if(udma.remaining[ch] == 0){
+			if((ctl & UDMA_CHCTL_XFERMODE_M) == UDMA_CHCTL_XFERMODE_STOP){
+				udma.ena &= ~bit;
+				break;
+			}
+			udma.remaining[ch] = ((ctl & UDMA_CHCTL_XFERSIZE_M) >> UDMA_CHCTL_XFERSIZE_S) + 1;
+			udma.src[ch] = (const uint8_t *)entry->src_end - (udma.remaining[ch] - 1);
+		}
+		
+		uart_push(*udma.src[ch]++);
+		stats.dma_tx_bytes++;
+		if(--udma.remaining[ch] != 0) continue;
+		
+		entry->control = ctl & ~(UDMA_CHCTL_XFERSIZE_M | UDMA_CHCTL_XFERMODE_M);
+		udma.chis |= bit;
+		stats.dma_buffers++;
+		if((ctl & UDMA_CHCTL_XFERMODE_M) == UDMA_CHCTL_XFERMODE_PINGPONG){
+			udma.alt ^= bit;
+			entry = &table[ch + ((udma.alt & bit) ? UDMA_NUM_CHANNELS : 0)];
+			if((entry->control & UDMA_CHCTL_XFERMODE_M) != UDMA_CHCTL_XFERMODE_STOP) continue;
+		}
+		udma.ena &= ~bit;
+	}
+}
+
+//*****************************************************************************
+// Function Name: rx_advance
+//*****************************************************************************
+//	Summary: Moves bytes from the host into the RX FIFO no faster than the
+//					 line allows.  A byte that finds the FIFO full is lost and flags
+//					 an overrun.  A FIFO left unread for 32 bit times raises the
+//					 receive timeout.
+//
+//*****************************************************************************
+static void rx_advance(uint64_t now){
+	ssize_t n;
+	uint32_t in;
+	
+	if(!uart_rx_on()) return;
+	
+	while(1){
+		if(rx_wire_count == 0){
+			n = (rx_fd >= 0 && !rx_eof) ? read(rx_fd, rx_wire, RX_WIRE_SIZE) : -1;
+			if(n == 0) rx_eof = true;
+			if(n <= 0){
+				uart.rx_idle = true;
+				break;
+			}
+			rx_wire_out = 0;
+			rx_wire_count = n;
+			
+			// After an idle line the first byte takes a frame from now
+			if(uart.rx_idle) uart.rx_next = now + uart.byte_ns;
+			uart.rx_idle = false;
+		}
+		if(now < uart.rx_next) break;
+		
+		uart.rx_last = uart.rx_next;
+		uart.rx_next += uart.byte_ns;
+		uart.rx_timed_out = false;
+		stats.rx_bytes++;
+		if(uart.rx_count >= uart_depth()){
+			uart.rsr |= UART_RSR_OE;
+			uart.ris |= UART_RIS_OERIS;
+			stats.rx_overruns++;
+		}
+		else{
+			in = (uart.rx_out + uart.rx_count) % UART_FIFO_SIZE;
+			uart.rx_fifo[in] = rx_wire[rx_wire_out];
+			uart.rx_count++;
+			if(uart.rx_count == uart_rx_trigger()) uart.ris |= UART_RIS_RXRIS;
+		}
+		rx_wire_out++;
+		rx_wire_count--;
+	}
+	
+	if(uart.rx_count != 0 && !uart.rx_timed_out && now - uart.rx_last >= uart.byte_ns * 32 / 10){
+		uart.ris |= UART_RIS_RTRIS;
+		uart.rx_timed_out = true;
+	}
+}
+
+static uint32_t uart_rx_pop(void){
+	uint32_t data;
+	
+	if(uart.rx_count == 0) return 0;
+	data = uart.rx_fifo[uart.rx_out];
+	uart.rx_out = (uart.rx_out + 1) % UART_FIFO_SIZE;
+	uart.rx_count--;
+	
+	// Reading below the trigger level or emptying the FIFO clears the
+	// interrupts it raised
+	if(uart.rx_count < uart_rx_trigger()) uart.ris &= ~UART_RIS_RXRIS;
+	if(uart.rx_count == 0) uart.ris &= ~UART_RIS_RTRIS;
+	return data;
+}
+
+//*****************************************************************************
+// Function Name: advance
+//*****************************************************************************
+//	Summary: Receives and shifts out every byte due by now, one frame time
+//					 apart, and refills the TX FIFO from DMA as it drains
+//
+//*****************************************************************************
+static void i2c_advance(uint64_t now);
+static void adc_advance(uint64_t now);
+
+static void advance(uint64_t now){
+	uint64_t t;
+	
+	i2c_advance(now);
+	adc_advance(now);
+	rx_advance(now);
+	dma_run();
+	while(1){
+		if(uart.tx_busy){
+			if(now < uart.tx_done) return;
+			uart.tx_busy = false;
+			stats.tx_bytes++;
+			tx_sink(uart.tx_shift);
+			t = uart.tx_done;
+		}
+		else{
+			t = now;
+		}
+		if(uart.tx_count == 0 || !uart_tx_on()) return;
+		
+		uart.tx_shift = uart.tx_fifo[uart.tx_out];
+		uart.tx_out = (uart.tx_out + 1) % UART_FIFO_SIZE;
+		uart.tx_count--;
+		uart.tx_busy = true;
+		uart.tx_done = t + uart.byte_ns;
+		if(uart.tx_count == uart_tx_trigger()) uart.ris |= UART_RIS_TXRIS;
+		dma_run();
+	}
+}
+
+//*****************************************************************************
+// Function Name: uart_read
+//*****************************************************************************
+//	Summary: What a UART0 register reads as.  pop is false for the read half
+//					 of a read-modify-write, which must not take a byte from DR.
+//
+//*****************************************************************************
+static uint32_t uart_read(uint32_t offset, bool pop){
+	uint32_t fr = 0;
+	
+	switch(offset){
+		case offsetof(UART0_Type, DR):			return pop ? uart_rx_pop() : 0;
+		case offsetof(UART0_Type, RSR):			return uart.rsr;
+		case offsetof(UART0_Type, FR):
+			if(uart.rx_count == 0) fr |= UART_FR_RXFE;
+			if(uart.rx_count >= uart_depth()) fr |= UART_FR_RXFF;
+			if(uart.tx_count >= uart_depth()) fr |= UART_FR_TXFF;
+			if(uart.tx_count == 0) fr |= UART_FR_TXFE;
+			if(uart.tx_count != 0 || uart.tx_busy) fr |= UART_FR_BUSY;
+			return fr;
+		case offsetof(UART0_Type, ILPR):		return uart.ilpr;
+		case offsetof(UART0_Type, IBRD):		return uart.ibrd;
+		case offsetof(UART0_Type, FBRD):		return uart.fbrd;
+		case offsetof(UART0_Type, LCRH):		return uart.lcrh;
+		case offsetof(UART0_Type, CTL):			return uart.ctl;
+		case offsetof(UART0_Type, IFLS):		return uart.ifls;
+		case offsetof(UART0_Type, IM):			return uart.im;
+		case offsetof(UART0_Type, RIS):			return uart.ris;
+		case offsetof(UART0_Type, MIS):			return uart.ris & uart.im;
+		case offsetof(UART0_Type, DMACTL):	return uart.dmactl;
+		default:														return 0;
+	}
+}
+
+static void uart_write(uint32_t offset, uint32_t value){
+	switch(offset){
+		case offsetof(UART0_Type, DR):
+			uart_push(value & 0xFF);
+			stats.cpu_tx_bytes++;
+			break;
+		case offsetof(UART0_Type, RSR):			uart.rsr = 0; break;
+		case offsetof(UART0_Type, ILPR):		uart.ilpr = value; break;
+		case offsetof(UART0_Type, IBRD):		uart.ibrd = value; uart_set_baud(); break;
+		case offsetof(UART0_Type, FBRD):		uart.fbrd = value; uart_set_baud(); break;
+		case offsetof(UART0_Type, LCRH):		uart.lcrh = value; uart_set_baud(); break;
+		case offsetof(UART0_Type, CTL):			uart.ctl = value; break;
+		case offsetof(UART0_Type, IFLS):		uart.ifls = value; break;
+		case offsetof(UART0_Type, IM):			uart.im = value; break;
+		case offsetof(UART0_Type, ICR):			uart.ris &= ~value; break;
+		case offsetof(UART0_Type, DMACTL):	uart.dmactl = value; break;
+		default:														break;
+	}
+}
+
+//*****************************************************************************
+// uDMA
+//*****************************************************************************
+static uint32_t udma_read(uint32_t offset){
+	switch(offset){
+		case offsetof(UDMA_Type, STAT):					return (udma.cfg & UDMA_CFG_MASTEN) | ((UDMA_NUM_CHANNELS - 1) << 16);
+		case offsetof(UDMA_Type, CTLBASE):			return udma.ctlbase;
+		case offsetof(UDMA_Type, ALTBASE):			return udma.ctlbase + UDMA_NUM_CHANNELS * 16;
+		case offsetof(UDMA_Type, USEBURSTSET):	return udma.useburst;
+		case offsetof(UDMA_Type, REQMASKSET):		return udma.reqmask;
+		case offsetof(UDMA_Type, ENASET):				return udma.ena;
+		case offsetof(UDMA_Type, ALTSET):				return udma.alt;
+		case offsetof(UDMA_Type, PRIOSET):			return udma.prio;
+		case offsetof(UDMA_Type, CHIS):					return udma.chis;
+		case offsetof(UDMA_Type, CHMAP0):				return udma.chmap[0];
+		case offsetof(UDMA_Type, CHMAP1):				return udma.chmap[1];
+		case offsetof(UDMA_Type, CHMAP2):				return udma.chmap[2];
+		case offsetof(UDMA_Type, CHMAP3):				return udma.chmap[3];
+		default:																return 0;
+	}
+}
+
+static void udma_write(uint32_t offset, uint32_t value){
+	uint32_t ch;
+	
+	switch(offset){
+		case offsetof(UDMA_Type, CFG):					udma.cfg = value; break;
+		case offsetof(UDMA_Type, CTLBASE):			udma.ctlbase = value & ~0x3FFUL; break;
+		case offsetof(UDMA_Type, USEBURSTSET):	udma.useburst |= value; break;
+		case offsetof(UDMA_Type, USEBURSTCLR):	udma.useburst &= ~value; break;
+		case offsetof(UDMA_Type, REQMASKSET):		udma.reqmask |= value; break;
+		case offsetof(UDMA_Type, REQMASKCLR):		udma.reqmask &= ~value; break;
+		case offsetof(UDMA_Type, ENASET):
+			// A newly enabled channel loads its control structure afresh
+			for(ch = 0; ch < UDMA_NUM_CHANNELS; ch++){
+				if((value & ~udma.ena) & (1UL << ch)) udma.remaining[ch] = 0;
+			}
+			udma.ena |= value;
+			break;
+		case offsetof(UDMA_Type, ENACLR):				udma.ena &= ~value; break;
+		case offsetof(UDMA_Type, ALTSET):				udma.alt |= value; break;
+		case offsetof(UDMA_Type, ALTCLR):				udma.alt &= ~value; break;
+		case offsetof(UDMA_Type, PRIOSET):			udma.prio |= value; break;
+		case offsetof(UDMA_Type, PRIOCLR):			udma.prio &= ~value; break;
+		case offsetof(UDMA_Type, CHIS):					udma.chis &= ~value; break;
+		case offsetof(UDMA_Type, CHMAP0):				udma.chmap[0] = value; break;
+		case offsetof(UDMA_Type, CHMAP1):				udma.chmap[1] = value; break;
+		case offsetof(UDMA_Type, CHMAP2):				udma.chmap[2] = value; break;
+		case offsetof(UDMA_Type, CHMAP3):				udma.chmap[3] = value; break;
+		default:																break;
+	}
+}
+
+//*****************************************************************************
+// I2C1
+//*****************************************************************************
+
+// One SCL period at the rate MTPR programs
+static uint64_t i2c_bit_ns(void){
+	return 2 * (1 + (i2c.mtpr & I2C_MTPR_TPR_M)) * I2C_SCL_CLOCKS * 1000000000ULL / SIM_CLOCK_HZ;
+}
+
+//*****************************************************************************
+// Function Name: i2c_command
+//*****************************************************************************
+//	Summary: Runs what a write to MCS asks for.  START puts the address in
+//					 MSA on the bus and RUN one data byte, in the direction MSA
+//					 gives.  An address no slave ACKs fails the command and every
+//					 RUN after it until the STOP.  STOP ends the transaction, and
+//					 is sent whether or not the bytes before it were ACKed.
+//
+//					 The slaves see each part at the time it finishes on the wire,
+//					 but MCS stays BUSY, and MDR and the status bits keep their
+//					 old values, until the whole command has gone out.
+//
+//*****************************************************************************
+static void i2c_command(uint32_t value, uint64_t now){
+	uint64_t bit_ns = i2c_bit_ns();
+	uint64_t t = now;
+	sim_i2c_dev_t *dev;
+	
+	if(!(i2c.mcr & I2C_MCR_MFE) || i2c.busy) return;
+	
+	i2c.next_status = 0;
+	i2c.next_read = false;
+	if(value & I2C_MCS_RUN){
+		if(value & I2C_MCS_START){
+			t += bit_ns + I2C_BYTE_BITS * bit_ns;
+			stats.i2c_bytes++;
+			i2c.held = true;
+			i2c.reading = (i2c.msa & I2C_MSA_RS) != 0;
+			for(dev = i2c_devs; dev != NULL && dev->addr != (i2c.msa >> I2C_MSA_SA_S); dev = dev->next);
+			i2c.dev = (dev != NULL && dev->start(dev, i2c.reading, t)) ? dev : NULL;
+		}
+		else if(!i2c.held){
+			return;
+		}
+		
+		if(i2c.dev == NULL){
+			i2c.next_status = I2C_MCS_ERROR | I2C_MCS_ADRACK;
+		}
+		else{
+			t += I2C_BYTE_BITS * bit_ns;
+			stats.i2c_bytes++;
+			if(i2c.reading){
+				i2c.next_mdr = i2c.dev->read(i2c.dev, t);
+				i2c.next_read = true;
+			}
+			else if(!i2c.dev->write(i2c.dev, i2c.mdr & 0xFF, t)){
+				i2c.next_status = I2C_MCS_ERROR | I2C_MCS_DATACK;
+			}
+		}
+		if(i2c.next_status != 0) stats.i2c_nacks++;
+	}
+	
+	// A STOP on its own always completes and interrupts, even with the bus
+	// already released
+	if(value & I2C_MCS_STOP){
+		t += bit_ns;
+		if(i2c.dev != NULL) i2c.dev->stop(i2c.dev, t);
+		i2c.dev = NULL;
+		i2c.held = false;
+	}
+	if(t == now) return;
+	
+	i2c.busy = true;
+	i2c.done = t;
+	stats.i2c_bus_ns += t - now;
+	sim_wake_at(t);
+}
+
+//*****************************************************************************
+// Function Name: i2c_advance
+//*****************************************************************************
+//	Summary: Finishes the command on the bus once its time is up, raising
+//					 the master interrupt, and lets the slaves run their scripts
+//
+//*****************************************************************************
+static void i2c_advance(uint64_t now){
+	sim_i2c_dev_t *dev;
+	
+	if(i2c.busy){
+		if(now >= i2c.done){
+			i2c.busy = false;
+			i2c.status = i2c.next_status;
+			if(i2c.next_read) i2c.mdr = i2c.next_mdr;
+			i2c.mris |= I2C_MRIS_RIS;
+		}
+		else{
+			sim_wake_at(i2c.done);
+		}
+	}
+	for(dev = i2c_devs; dev != NULL; dev = dev->next){
+		if(dev->tick != NULL) dev->tick(dev, now);
+	}
+}
+
+static uint32_t i2c_read(uint32_t offset){
+	uint32_t mcs = i2c.status;
+	
+	switch(offset){
+		case offsetof(I2C0_Type, MSA):		return i2c.msa;
+		case offsetof(I2C0_Type, MCS):
+			if(i2c.busy) mcs |= I2C_MCS_BUSY;
+			mcs |= (i2c.busy || i2c.held) ? I2C_MCS_BUSBSY : I2C_MCS_IDLE;
+			return mcs;
+		case offsetof(I2C0_Type, MDR):		return i2c.mdr;
+		case offsetof(I2C0_Type, MTPR):		return i2c.mtpr;
+		case offsetof(I2C0_Type, MIMR):		return i2c.mimr;
+		case offsetof(I2C0_Type, MRIS):		return i2c.mris;
+		case offsetof(I2C0_Type, MMIS):		return i2c.mris & i2c.mimr;
+		case offsetof(I2C0_Type, MCR):		return i2c.mcr;
+		default:													return 0;
+	}
+}
+
+static void i2c_write(uint32_t offset, uint32_t value){
+	switch(offset){
+		case offsetof(I2C0_Type, MSA):		i2c.msa = value & 0xFF; break;
+		case offsetof(I2C0_Type, MCS):		i2c_command(value, sim_now()); break;
+		case offsetof(I2C0_Type, MDR):		i2c.mdr = value & 0xFF; break;
+		case offsetof(I2C0_Type, MTPR):		i2c.mtpr = value; break;
+		case offsetof(I2C0_Type, MIMR):		i2c.mimr = value; break;
+		case offsetof(I2C0_Type, MICR):		i2c.mris &= ~value; break;
+		case offsetof(I2C0_Type, MCR):		i2c.mcr = value; break;
+		default:													break;
+	}
+}
+
+//*****************************************************************************
+// ADC0
+//*****************************************************************************
+
+// Steps in a sequencer and the depth of its FIFO
+static uint32_t adc_depth(uint32_t ss){
+	static const uint8_t depths[ADC_NUM_SS] = { 8, 4, 4, 1 };
+	
+	return depths[ss];
+}
+
+//*****************************************************************************
+// Function Name: adc_start
+//*****************************************************************************
+//	Summary: Starts each sequencer set in a PSSI write that is enabled, set
+//					 to the processor trigger and not already converting
+//
+//*****************************************************************************
+static void adc_start(uint32_t pssi, uint64_t now){
+	uint32_t ss;
+	
+	for(ss = 0; ss < ADC_NUM_SS; ss++){
+		if(!(pssi & (1UL << ss)) || !(adc.actss & (1UL << ss)) || adc.busy[ss]) continue;
+		if(((adc.emux >> (ss * 4)) & 0xF) != ADC_EMUX_EM0_PROCESSOR) continue;
+		
+		adc.busy[ss] = true;
+		adc.step[ss] = 0;
+		adc.next[ss] = now + ADC_SAMPLE_NS;
+		sim_wake_at(adc.next[ss]);
+	}
+}
+
+//*****************************************************************************
+// Function Name: adc_advance
+//*****************************************************************************
+//	Summary: Finishes every step due by now, one sample time apart.  Each
+//					 takes a sample of the channel its SSMUX nibble selects into the
+//					 FIFO, or flags an overflow if it is full, and raises the
+//					 sequencer's interrupt if its IE bit is set.  The sequence ends
+//					 at the step with END set, or after the last one.
+//
+//*****************************************************************************
+static void adc_advance(uint64_t now){
+	uint32_t ss, step, ctl;
+	
+	for(ss = 0; ss < ADC_NUM_SS; ss++){
+		while(adc.busy[ss] && now >= adc.next[ss]){
+			step = adc.step[ss];
+			ctl = (adc.ssctl[ss] >> (step * 4)) & 0xF;
+			
+			if(adc.fifo_count[ss] >= adc_depth(ss)){
+				adc.ostat |= 1UL << ss;
+				stats.adc_overflows++;
+			}
+			else{
+				adc.fifo[ss][(adc.fifo_out[ss] + adc.fifo_count[ss]) % adc_depth(ss)] =
+					adc_source((adc.ssmux[ss] >> (step * 4)) & 0xF, adc.next[ss]) & 0xFFF;
+				adc.fifo_count[ss]++;
+				stats.adc_samples++;
+			}
+			if(ctl & ADC_SSCTL0_IE0) adc.ris |= 1UL << ss;
+			
+			if((ctl & ADC_SSCTL0_END0) || step + 1 >= adc_depth(ss)){
+				adc.busy[ss] = false;
+			}
+			else{
+				adc.step[ss]++;
+				adc.next[ss] += ADC_SAMPLE_NS;
+			}
+		}
+		if(adc.busy[ss]) sim_wake_at(adc.next[ss]);
+	}
+}
+
+// Which sequencer's block of registers offset is in, ADC_NUM_SS if none
+static uint32_t adc_ss(uint32_t offset){
+	if(offset < offsetof(ADC0_Type, SSMUX0) || offset > offsetof(ADC0_Type, SSDC3)) return ADC_NUM_SS;
+	return (offset - offsetof(ADC0_Type, SSMUX0)) / ADC_SS_STRIDE;
+}
+
+static uint32_t adc_fifo_pop(uint32_t ss){
+	uint32_t data;
+	
+	if(adc.fifo_count[ss] == 0) return 0;
+	data = adc.fifo[ss][adc.fifo_out[ss]];
+	adc.fifo_out[ss] = (adc.fifo_out[ss] + 1) % adc_depth(ss);
+	adc.fifo_count[ss]--;
+	return data;
+}
+
+//*****************************************************************************
+// Function Name: adc_read
+//*****************************************************************************
+//	Summary: What an ADC0 register reads as.  pop is false for the read half
+//					 of a read-modify-write, which must not take a sample from a
+//					 FIFO.
+//
+//*****************************************************************************
+static uint32_t adc_read(uint32_t offset, bool pop){
+	uint32_t ss = adc_ss(offset);
+	uint32_t fstat = 0;
+	
+	// Each sequencer's registers read as SS0's do, at the same place in
+	// its block
+	if(ss < ADC_NUM_SS) offset -= ss * ADC_SS_STRIDE;
+	
+	switch(offset){
+		case offsetof(ADC0_Type, ACTSS):		return adc.actss;
+		case offsetof(ADC0_Type, RIS):			return adc.ris;
+		case offsetof(ADC0_Type, IM):				return adc.im;
+		case offsetof(ADC0_Type, ISC):			return adc.ris & adc.im;
+		case offsetof(ADC0_Type, OSTAT):		return adc.ostat;
+		case offsetof(ADC0_Type, EMUX):			return adc.emux;
+		case offsetof(ADC0_Type, SSMUX0):		return adc.ssmux[ss];
+		case offsetof(ADC0_Type, SSCTL0):		return adc.ssctl[ss];
+		case offsetof(ADC0_Type, SSFIFO0):	return pop ? adc_fifo_pop(ss) : 0;
+		case offsetof(ADC0_Type, SSFSTAT0):
+			if(adc.fifo_count[ss] == 0) fstat |= ADC_SSFSTAT0_EMPTY;
+			if(adc.fifo_count[ss] >= adc_depth(ss)) fstat |= ADC_SSFSTAT0_FULL;
+			return fstat;
+		default:														return 0;
+	}
+}
+
+static void adc_write(uint32_t offset, uint32_t value){
+	uint32_t ss = adc_ss(offset);
+	
+	if(ss < ADC_NUM_SS) offset -= ss * ADC_SS_STRIDE;
+	
+	switch(offset){
+		case offsetof(ADC0_Type, ACTSS):		adc.actss = value & 0xF; break;
+		case offsetof(ADC0_Type, IM):				adc.im = value & 0xF; break;
+		case offsetof(ADC0_Type, ISC):			adc.ris &= ~(value & 0xF); break;
+		case offsetof(ADC0_Type, OSTAT):		adc.ostat &= ~value; break;
+		case offsetof(ADC0_Type, EMUX):			adc.emux = value; break;
+		case offsetof(ADC0_Type, PSSI):			adc_start(value, sim_now()); break;
+		case offsetof(ADC0_Type, SSMUX0):		adc.ssmux[ss] = value; break;
+		case offsetof(ADC0_Type, SSCTL0):		adc.ssctl[ss] = value; break;
+		default:														break;
+	}
+}
+
+//*****************************************************************************
+// Timer1
+//*****************************************************************************
+
+//*****************************************************************************
+// Function Name: timer_value
+//*****************************************************************************
+//	Summary: Where Timer A has counted to by now.  Only the 32-bit periodic
+//					 mode is modelled.  It counts up from 0 or down from TAILR,
+//					 reloading at the end of each period.
+//
+//*****************************************************************************
+static uint32_t timer_value(uint64_t now){
+	uint64_t period = (uint64_t)timer1.tailr + 1;
+	uint64_t ticks;
+	
+	if(!(timer1.ctl & TIMER_CTL_TAEN)) return timer1.value;
+	ticks = (now - timer1.at) * SIM_CLOCK_HZ / 1000000000ULL % period;
+	if(timer1.tamr & TIMER_TAMR_TACDIR) return (timer1.value + ticks) % period;
+	return (timer1.value + period - ticks) % period;
+}
+
+static uint32_t timer_read(uint32_t offset){
+	switch(offset){
+		case offsetof(TIMER0_Type, CFG):		return timer1.cfg;
+		case offsetof(TIMER0_Type, TAMR):		return timer1.tamr;
+		case offsetof(TIMER0_Type, CTL):		return timer1.ctl;
+		case offsetof(TIMER0_Type, IMR):		return timer1.imr;
+		case offsetof(TIMER0_Type, TAILR):	return timer1.tailr;
+		case offsetof(TIMER0_Type, TAR):
+		case offsetof(TIMER0_Type, TAV):
+			stats.timer_reads++;
+			return timer_value(sim_now());
+		default:														return 0;
+	}
+}
+
+//*****************************************************************************
+// Function Name: timer_write
+//*****************************************************************************
+//	Summary: Applies a write to Timer1.  Enabling Timer A starts it from 0
+//					 counting up or TAILR counting down, and disabling it holds
+//					 the count.  A write to TAV loads the counter.
+//
+//*****************************************************************************
+static void timer_write(uint32_t offset, uint32_t value){
+	uint64_t now = sim_now();
+	
+	switch(offset){
+		case offsetof(TIMER0_Type, CFG):		timer1.cfg = value; break;
+		case offsetof(TIMER0_Type, TAMR):		timer1.tamr = value; break;
+		case offsetof(TIMER0_Type, IMR):		timer1.imr = value; break;
+		case offsetof(TIMER0_Type, TAILR):	timer1.tailr = value; break;
+		case offsetof(TIMER0_Type, TAV):
+			timer1.value = value;
+			timer1.at = now;
+			break;
+		case offsetof(TIMER0_Type, CTL):
+			if((value & TIMER_CTL_TAEN) && !(timer1.ctl & TIMER_CTL_TAEN)){
+				timer1.value = (timer1.tamr & TIMER_TAMR_TACDIR) ? 0 : timer1.tailr;
+				timer1.at = now;
+			}
+			else if(!(value & TIMER_CTL_TAEN) && (timer1.ctl & TIMER_CTL_TAEN)){
+				timer1.value = timer_value(now);
+			}
+			timer1.ctl = value;
+			break;
+		default:														break;
+	}
+}
+
+//*****************************************************************************
+// NVIC
+//*****************************************************************************
+static bool uart0_irq_line(void){
+	return (uart.ris & uart.im) != 0 || (udma.chis & UART0_DMA_CHANNELS) != 0;
+}
+
+static bool i2c1_irq_line(void){
+	return (i2c.mris & i2c.mimr) != 0;
+}
+
+static bool adc0ss2_irq_line(void){
+	return (adc.ris & adc.im & ADC_RIS_INR2) != 0;
+}
+
+//*****************************************************************************
+// Function Name: irq_check
+//*****************************************************************************
+//	Summary: Runs UART0_Handler, I2C1_Handler and ADC0SS2_Handler for as
+//					 long as their lines are raised, unless they are disabled,
+//					 masked or a handler is already running.  The lower IRQ number
+//					 goes first when several are raised.  The caller keeps the
+//					 tick blocked.
+//
+//*****************************************************************************
+static void irq_check(void){
+	uint64_t start;
+	
+	while(!sim_primask && !in_isr){
+		if(nvic_uart0 && uart0_irq_line()){
+			in_isr = true;
+			stats.isr_entries++;
+			start = sim_now();
+			UART0_Handler();
+			stats.isr_ns += sim_now() - start;
+			in_isr = false;
+		}
+		else if(nvic_adc0ss2 && adc0ss2_irq_line()){
+			in_isr = true;
+			stats.adc_isr_entries++;
+			stats.adc_isr_at = sim_now();
+			ADC0SS2_Handler();
+			in_isr = false;
+		}
+		else if(nvic_i2c1 && i2c1_irq_line()){
+			in_isr = true;
+			in_i2c_isr = true;
+			stats.i2c_isr_entries++;
+			start = sim_now();
+			I2C1_Handler();
+			stats.i2c_isr_ns += sim_now() - start;
+			in_i2c_isr = false;
+			in_isr = false;
+		}
+		else{
+			break;
+		}
+	}
+}
+
+static void block_tick(bool block){
+	sigset_t set;
+	
+	sigemptyset(&set);
+	sigaddset(&set, SIGALRM);
+	sigprocmask(block ? SIG_BLOCK : SIG_UNBLOCK, &set, NULL);
+}
+
+void sim_set_primask(uint32_t primask){
+	sim_primask = primask;
+	if(primask == 0){
+		block_tick(true);
+		irq_check();
+		block_tick(false);
+	}
+}
+
+void sim_nvic_enable(IRQn_Type irq, int enable){
+	if(irq != UART0_IRQn && irq != I2C1_IRQn && irq != ADC0SS2_IRQn) return;
+	block_tick(true);
+	if(irq == UART0_IRQn) nvic_uart0 = enable;
+	else if(irq == I2C1_IRQn) nvic_i2c1 = enable;
+	else nvic_adc0ss2 = enable;
+	irq_check();
+	block_tick(false);
+}
+
+//*****************************************************************************
+// Traps
+//*****************************************************************************
+
+//*****************************************************************************
+// Function Name: on_segv
+//*****************************************************************************
+//	Summary: First half of a register access.  Brings the model up to date,
+//					 stores the value the register reads as, opens the page and
+//					 single steps the access with the tick held off.
+//
+//*****************************************************************************
+static void on_segv(int sig, siginfo_t *info, void *context){
+	ucontext_t *uc = context;
+	uintptr_t addr = (uintptr_t)info->si_addr & ~3UL;
+	uintptr_t page = addr & ~(PAGE_SIZE - 1);
+	uint32_t value;
+	
+	if(page != UART0_BASE && page != UDMA_BASE && page != I2C1_BASE && page != ADC0_BASE && page != TIMER1_BASE){
+		// A real crash, let it happen
+		signal(SIGSEGV, SIG_DFL);
+		return;
+	}
+	
+	trap_addr = addr;
+	trap_write = (uc->uc_mcontext.gregs[REG_ERR] & PF_WRITE) != 0;
+	if(page == I2C1_BASE){
+		stats.i2c_reg_accesses++;
+		if(in_i2c_isr) stats.i2c_isr_reg_accesses++;
+	}
+	else if(page == UART0_BASE || page == UDMA_BASE){
+		trap_write ? stats.reg_writes++ : stats.reg_reads++;
+		if(in_isr && !in_i2c_isr) stats.isr_reg_accesses++;
+	}
+	
+	// Take the last trap's overhead out too, as far as it fits in the time
+	// since, so the clock never runs backwards
+	trap_start = sim_now();
+	if(trap_start > trap_end){
+		__atomic_add_fetch(&clock_stalled, (trap_start - trap_end < trap_overhead) ? trap_start - trap_end : trap_overhead, __ATOMIC_SEQ_CST);
+		trap_start = sim_now();
+	}
+	advance(trap_start);
+	if(page == UART0_BASE) value = uart_read(addr - page, !trap_write);
+	else if(page == UDMA_BASE) value = udma_read(addr - page);
+	else if(page == ADC0_BASE) value = adc_read(addr - page, !trap_write);
+	else if(page == TIMER1_BASE) value = timer_read(addr - page);
+	else value = i2c_read(addr - page);
+	
+	mprotect((void *)page, PAGE_SIZE, PROT_READ | PROT_WRITE);
+	*(volatile uint32_t *)addr = value;
+	
+	uc->uc_mcontext.gregs[REG_EFL] |= EFLAGS_TF;
+	trap_alarm_blocked = sigismember(&uc->uc_sigmask, SIGALRM);
+	sigaddset(&uc->uc_sigmask, SIGALRM);
+}
+
+//*****************************************************************************
+// Function Name: on_trap
+//*****************************************************************************
+//	Summary: Second half, after the access has run.  Applies a write, closes
+//					 the page again and takes the UART0 interrupt if it is now due.
+//
+//*****************************************************************************
+static void on_trap(int sig, siginfo_t *info, void *context){
+	ucontext_t *uc = context;
+	uintptr_t page = trap_addr & ~(PAGE_SIZE - 1);
+	uint32_t value = *(volatile uint32_t *)trap_addr;
+	uint64_t now;
+	
+	uc->uc_mcontext.gregs[REG_EFL] &= ~EFLAGS_TF;
+	if(!trap_alarm_blocked) sigdelset(&uc->uc_sigmask, SIGALRM);
+	mprotect((void *)page, PAGE_SIZE, PROT_NONE);
+	
+	// To the model, the access took no time at all
+	now = sim_now();
+	if(now > trap_start) __atomic_add_fetch(&clock_stalled, now - trap_start, __ATOMIC_SEQ_CST);
+	trap_end = sim_now();
+	
+	if(trap_write){
+		if(page == UART0_BASE) uart_write(trap_addr - page, value);
+		else if(page == UDMA_BASE) udma_write(trap_addr - page, value);
+		else if(page == ADC0_BASE) adc_write(trap_addr - page, value);
+		else if(page == TIMER1_BASE) timer_write(trap_addr - page, value);
+		else i2c_write(trap_addr - page, value);
+		advance(sim_now());
+	}
+	irq_check();
+}
+
+static void on_tick(int sig, siginfo_t *info, void *context){
+	uint64_t start = sim_now(), now;
+	
+	// Like a trap, the model's own work takes no time.  The handlers it
+	// runs are the firmware's and do.
+	advance(start);
+	now = sim_now();
+	if(now > start) __atomic_add_fetch(&clock_stalled, now - start, __ATOMIC_SEQ_CST);
+	irq_check();
+}
+
+//*****************************************************************************
+// Function Name: trap_calibrate
+//*****************************************************************************
+//	Summary: Times a run of register reads to find trap_overhead.  The
+//					 fastest batch is the one the host interrupted least.
+//
+//*****************************************************************************
+static void trap_calibrate(void){
+	uint64_t start, ns, best = ~0ULL;
+	int batch, i;
+	
+	for(batch = 0; batch < 10; batch++){
+		start = sim_now();
+		for(i = 0; i < 100; i++) (void)UART0->FR;
+		ns = (sim_now() - start) / 100;
+		if(ns < best) best = ns;
+	}
+	trap_overhead = best;
+	memset(&stats, 0, sizeof(stats));
+}
+
+void sim_init(void){
+	struct sigaction sa;
+	struct itimerval timer;
+	void *mem;
+	
+	mem = mmap((void *)PERIPH_BASE, PERIPH_SIZE, PROT_READ | PROT_WRITE,
+						 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	if(mem != (void *)PERIPH_BASE){
+		perror("sim_init: mmap of the peripheral space");
+		exit(1);
+	}
+	
+	// Every peripheral reports ready at once
+	SYSCTL->PRGPIO = 0xFFFFFFFF;
+	SYSCTL->PRDMA = 0xFFFFFFFF;
+	SYSCTL->PRUART = 0xFFFFFFFF;
+	SYSCTL->PRI2C = 0xFFFFFFFF;
+	SYSCTL->PRTIMER = 0xFFFFFFFF;
+	SYSCTL->PRADC = 0xFFFFFFFF;
+	
+	// Reset values
+	uart.ctl = UART_CTL_RXE | UART_CTL_TXE;
+	uart.ifls = UART_IFLS_RX4_8 | UART_IFLS_TX4_8;
+	uart.rx_idle = true;
+	i2c.mtpr = 0x1;
+	timer1.tailr = 0xFFFFFFFF;
+	
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+	sigemptyset(&sa.sa_mask);
+	sigaddset(&sa.sa_mask, SIGALRM);
+	sa.sa_sigaction = on_segv;
+	sigaction(SIGSEGV, &sa, NULL);
+	sa.sa_sigaction = on_trap;
+	sigaction(SIGTRAP, &sa, NULL);
+	
+	sa.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_sigaction = on_tick;
+	sigaction(SIGALRM, &sa, NULL);
+	
+	mprotect((void *)UART0_BASE, PAGE_SIZE, PROT_NONE);
+	mprotect((void *)UDMA_BASE, PAGE_SIZE, PROT_NONE);
+	mprotect((void *)I2C1_BASE, PAGE_SIZE, PROT_NONE);
+	mprotect((void *)ADC0_BASE, PAGE_SIZE, PROT_NONE);
+	mprotect((void *)TIMER1_BASE, PAGE_SIZE, PROT_NONE);
+	trap_calibrate();
+	
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = SIM_TICK_US;
+	timer.it_value = timer.it_interval;
+	setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+void sim_set_tx_sink(void (*sink)(uint8_t data)){
+	tx_sink = sink;
+}
+
+void sim_set_rx_source(int fd){
+	block_tick(true);
+	rx_fd = fd;
+	rx_eof = false;
+	block_tick(false);
+}
+
+bool sim_rx_done(void){
+	bool done;
+	
+	block_tick(true);
+	done = rx_eof && rx_wire_count == 0 && uart.rx_count == 0;
+	block_tick(false);
+	return done;
+}
+
+bool sim_tx_idle(void){
+	bool idle;
+	
+	block_tick(true);
+	idle = uart.tx_count == 0 && !uart.tx_busy;
+	block_tick(false);
+	return idle;
+}
+
+void sim_i2c_attach(sim_i2c_dev_t *dev){
+	block_tick(true);
+	dev->next = i2c_devs;
+	i2c_devs = dev;
+	block_tick(false);
+}
+
+void sim_adc_set_source(uint16_t (*source)(uint32_t channel, uint64_t now)){
+	block_tick(true);
+	adc_source = source;
+	block_tick(false);
+}
+
+bool sim_i2c_idle(void){
+	bool idle;
+	
+	block_tick(true);
+	idle = !i2c.busy && !i2c.held;
+	block_tick(false);
+	return idle;
+}
+
+void sim_wait(void){
+	pause();
+}
+
+const sim_stats_t *sim_get_stats(void){
+	return &stats;
+}
@@ -0,0 +1,221 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Host model of the parts of the TM4C123 the serial stack drives: UART0
+// with its FIFOs, FIFO level and receive timeout interrupts and baud rate,
+// the uDMA channels mapped to it, and the NVIC line between them and
+// UART0_Handler.  The UART's line can be bridged to any file descriptor,
+// such as a pty or a pipe.
+//
+// I2C1's master is modelled too, with its interrupt to I2C1_Handler.  Each
+// command on MCS takes the bus time MTPR gives it and the slaves on the bus
+// are models attached with sim_i2c_attach, see sim_i2c_dev.h.
+//
+// ADC0's sample sequencers convert on a processor trigger, one sample a
+// microsecond, with the samples taken from a source set by
+// sim_adc_set_source.  SS2's interrupt goes to ADC0SS2_Handler, as the
+// joystick uses it.  Timer1's Timer A counts the system clock in 32-bit
+// periodic mode, as the latency trace's timebase.
+//
+// The firmware sources are compiled unchanged against the header in this
+// directory.  The peripheral space is mapped at its real address and the
+// UART0, uDMA, I2C1, ADC0 and Timer1 pages are kept inaccessible.  Each register access traps,
+// the model computes what the register reads as or applies what was
+// written, and the access is single stepped.  Time is the host's clock, so
+// bytes leave at the programmed baud rate.
+//
+// x86-64 Linux only.  Link with -no-pie so the firmware's 32-bit casts of
+// RAM addresses, such as the uDMA control table base, stay valid.
+
+#ifndef __SIM_HW_H__
+#define __SIM_HW_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "TM4C123GH6PM.h"
+
+// Clock the UART baud divisors are programmed for
+#define SIM_CLOCK_HZ				50000000ULL
+
+// Period of the tick that advances the model while the firmware is not
+// touching the hardware
+#define SIM_TICK_US					50
+
+// A gap this long between two readings of the clock means the host did not
+// run the process, as the tick would otherwise have read it.  It is taken
+// out of sim_now, as is the time spent trapping register accesses, so a
+// busy or slow host does not show up as overrun FIFOs.
+#define SIM_STALL_NS				200000ULL
+
+typedef struct {
+	uint64_t	reg_reads;				// UART0 and uDMA register accesses
+	uint64_t	reg_writes;
+	uint64_t	isr_reg_accesses;	// the part of those made by UART0_Handler
+	uint64_t	isr_entries;
+	uint64_t	isr_ns;						// sim_now time spent in UART0_Handler
+	uint64_t	tx_bytes;					// bytes shifted out of the UART
+	uint64_t	cpu_tx_bytes;			// bytes the CPU wrote to DR
+	uint64_t	dma_tx_bytes;			// bytes the uDMA wrote to DR
+	uint64_t	dma_buffers;			// control structures completed
+	uint64_t	tx_overflows;			// DR writes with the TX FIFO full
+	uint64_t	rx_bytes;					// bytes that arrived on the line
+	uint64_t	rx_overruns;			// of those, lost to a full RX FIFO
+	uint64_t	i2c_reg_accesses;	// I2C1 register reads and writes
+	uint64_t	i2c_isr_reg_accesses;	// the part of those made by I2C1_Handler
+	uint64_t	i2c_isr_entries;
+	uint64_t	i2c_isr_ns;				// sim_now time spent in I2C1_Handler
+	uint64_t	i2c_bytes;				// address and data bytes put on the bus
+	uint64_t	i2c_nacks;				// of those, not acknowledged
+	uint64_t	i2c_bus_ns;				// time the master was busy
+	uint64_t	adc_samples;			// conversions put in a sequencer FIFO
+	uint64_t	adc_overflows;		// conversions lost to a full FIFO
+	uint64_t	adc_isr_entries;	// of ADC0SS2_Handler
+	uint64_t	adc_isr_at;			// sim_now when the last one was entered
+	uint64_t	timer_reads;			// of Timer1's count
+} sim_stats_t;
+
+// A slave on the I2C1 bus.  The callbacks run as the master clocks each
+// part of a transaction out, with the sim_now time it happens at.  A model
+// embeds this as its first member.
+typedef struct sim_i2c_dev {
+	uint8_t		addr;							// 7-bit address
+	
+	// START or repeated START addressed to this slave, returns its ACK
+	bool			(*start)(struct sim_i2c_dev *dev, bool read, uint64_t now);
+	// A byte from the master, returns the slave's ACK
+	bool			(*write)(struct sim_i2c_dev *dev, uint8_t data, uint64_t now);
+	// The slave's next byte
+	uint8_t		(*read)(struct sim_i2c_dev *dev, uint64_t now);
+	// STOP at the end of a transaction with this slave
+	void			(*stop)(struct sim_i2c_dev *dev, uint64_t now);
+	// Called as the model advances, may be NULL
+	void			(*tick)(struct sim_i2c_dev *dev, uint64_t now);
+	
+	struct sim_i2c_dev *next;
+} sim_i2c_dev_t;
+
+//*****************************************************************************
+// Function Name: sim_init
+//*****************************************************************************
+//	Summary: Maps the peripheral space, installs the trap handlers and
+//					 starts the tick.  Call before any firmware code.
+//
+//*****************************************************************************
+void sim_init(void);
+
+//*****************************************************************************
+// Function Name: sim_set_tx_sink
+//*****************************************************************************
+//	Summary: Calls sink with each byte as it finishes shifting out of UART0.
+//					 The default writes it to stdout.
+//
+//*****************************************************************************
+void sim_set_tx_sink(void (*sink)(uint8_t data));
+
+//*****************************************************************************
+// Function Name: sim_set_rx_source
+//*****************************************************************************
+//	Summary: Feeds the bytes read from fd to UART0's RX line, one frame time
+//					 apart.  fd should be non-blocking.
+//
+//*****************************************************************************
+void sim_set_rx_source(int fd);
+
+//*****************************************************************************
+// Function Name: sim_rx_done
+//*****************************************************************************
+//	Summary: Returns true once the RX source has reached end of file and
+//					 every byte from it has been read out of the RX FIFO
+//
+//*****************************************************************************
+bool sim_rx_done(void);
+
+//*****************************************************************************
+// Function Name: sim_tx_idle
+//*****************************************************************************
+//	Summary: Returns true once the UART0 TX FIFO and shift register are empty
+//
+//*****************************************************************************
+bool sim_tx_idle(void);
+
+//*****************************************************************************
+// Function Name: sim_i2c_attach
+//*****************************************************************************
+//	Summary: Puts dev on the I2C1 bus.  Call after sim_init and before the
+//					 firmware addresses it.
+//
+//*****************************************************************************
+void sim_i2c_attach(sim_i2c_dev_t *dev);
+
+//*****************************************************************************
+// Function Name: sim_i2c_idle
+//*****************************************************************************
+//	Summary: Returns true if the I2C1 master has no command in progress and
+//					 does not hold the bus
+//
+//*****************************************************************************
+bool sim_i2c_idle(void);
+
+//*****************************************************************************
+// Function Name: sim_adc_set_source
+//*****************************************************************************
+//	Summary: Calls source for each ADC0 conversion with the channel the step
+//					 selects and the sim_now time the sample is taken at.  Its
+//					 low 12 bits are the result.  The default reads mid-scale, a
+//					 joystick at rest.
+//
+//*****************************************************************************
+void sim_adc_set_source(uint16_t (*source)(uint32_t channel, uint64_t now));
+
+//*****************************************************************************
+// Function Name: sim_wake_at
+//*****************************************************************************
+//	Summary: Brings the next tick forward to the sim_now time when, so an
+//					 event between two ticks is not late by up to a tick.  The
+//					 tick goes back to its period after that.
+//
+//*****************************************************************************
+void sim_wake_at(uint64_t when);
+
+//*****************************************************************************
+// Function Name: sim_wait
+//*****************************************************************************
+//	Summary: Sleeps until the next tick, as a main loop with nothing to do
+//
+//*****************************************************************************
+void sim_wait(void);
+
+//*****************************************************************************
+// Function Name: sim_now
+//*****************************************************************************
+//	Summary: Host time in ns, less the time the host did not run the
+//					 process, the time spent trapping register accesses and the
+//					 model's own work on each tick.  A trap costs the host
+//					 microseconds where the board takes a bus cycle.
+//
+//*****************************************************************************
+uint64_t sim_now(void);
+
+const sim_stats_t *sim_get_stats(void);
+
+#endif
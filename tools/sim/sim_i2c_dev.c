@@ -0,0 +1,398 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Slave models behind sim_i2c_dev.h.  The callbacks run from sim_hw.c's
+// traps and tick, with the tick blocked.
+
+#include <string.h>
+
+#include "sim_i2c_dev.h"
+
+// FT6x06 registers and report fields
+#define FT_TD_STATUS				0x02
+#define FT_P1_XH						0x03
+#define FT_P2_XH						0x09
+#define FT_POINT_BYTES			6
+#define FT_G_MODE						0xA4
+#define FT_CIPHER						0xA3
+#define FT_FOCALTECH_ID			0xA8
+
+#define FT_G_MODE_TRIGGER		0x01
+
+#define FT_EVENT_PRESS_DOWN	0x0
+#define FT_EVENT_LIFT_UP		0x1
+#define FT_EVENT_CONTACT		0x2
+
+// MCP23017 registers, IOCON.BANK = 0
+#define MCP_IODIRB					0x01
+#define MCP_IPOLB						0x03
+#define MCP_GPINTENB				0x05
+#define MCP_DEFVALB					0x07
+#define MCP_INTCONB					0x09
+#define MCP_IOCON						0x0A
+#define MCP_IOCON_MIRROR		0x0B
+#define MCP_GPPUB						0x0D
+#define MCP_INTFB						0x0F
+#define MCP_INTCAPB					0x11
+#define MCP_GPIOA						0x12
+#define MCP_GPIOB						0x13
+#define MCP_OLATA						0x14
+#define MCP_OLATB						0x15
+
+#define MCP_IOCON_INTPOL		0x02
+#define MCP_IOCON_ODR				0x04
+
+// Drives a pin of a GPIO port as a slave's open drain INT output with its
+// pull-up would.  GPIO ports are plain memory in the harness.
+static void pin_write(uint32_t port, uint8_t pin, bool high){
+	uint32_t *data = (uint32_t *)&((GPIOA_Type *)port)->DATA;
+	
+	if(high) __atomic_or_fetch(data, pin, __ATOMIC_SEQ_CST);
+	else __atomic_and_fetch(data, ~(uint32_t)pin, __ATOMIC_SEQ_CST);
+}
+
+//*****************************************************************************
+// 24LC32
+//*****************************************************************************
+static bool eeprom_start(sim_i2c_dev_t *dev, bool read, uint64_t now){
+	sim_24lc32_t *eeprom = (sim_24lc32_t *)dev;
+	
+	if(now < eeprom->busy_until){
+		eeprom->busy_nacks++;
+		return false;
+	}
+	eeprom->received = 0;
+	eeprom->latched = 0;
+	return true;
+}
+
+//*****************************************************************************
+// Function Name: eeprom_write
+//*****************************************************************************
+//	Summary: The first two bytes of a write set the address pointer, the
+//					 rest go to the page buffer.  The pointer wraps within the
+//					 page, so a write past its end overwrites its start.
+//
+//*****************************************************************************
+static bool eeprom_write(sim_i2c_dev_t *dev, uint8_t data, uint64_t now){
+	sim_24lc32_t *eeprom = (sim_24lc32_t *)dev;
+	uint32_t offset = eeprom->pointer & (SIM_24LC32_PAGE - 1);
+	
+	if(eeprom->received == 0){
+		eeprom->pointer = (((uint16_t)data << 8) | (eeprom->pointer & 0xFF)) & (SIM_24LC32_SIZE - 1);
+	}
+	else if(eeprom->received == 1){
+		eeprom->pointer = (eeprom->pointer & 0xF00) | data;
+	}
+	else{
+		eeprom->latch[offset] = data;
+		eeprom->latched |= 1UL << offset;
+		eeprom->pointer = (eeprom->pointer & ~(SIM_24LC32_PAGE - 1)) | ((offset + 1) & (SIM_24LC32_PAGE - 1));
+	}
+	eeprom->received++;
+	return true;
+}
+
+static uint8_t eeprom_read(sim_i2c_dev_t *dev, uint64_t now){
+	sim_24lc32_t *eeprom = (sim_24lc32_t *)dev;
+	uint8_t data = eeprom->mem[eeprom->pointer];
+	
+	eeprom->pointer = (eeprom->pointer + 1) & (SIM_24LC32_SIZE - 1);
+	return data;
+}
+
+// STOP after data bytes starts the write cycle.  The model commits the page
+// at once, since nothing can read it back until the cycle is over.
+static void eeprom_stop(sim_i2c_dev_t *dev, uint64_t now){
+	sim_24lc32_t *eeprom = (sim_24lc32_t *)dev;
+	uint32_t page = eeprom->pointer & ~(SIM_24LC32_PAGE - 1);
+	uint32_t i;
+	
+	if(eeprom->latched == 0) return;
+	for(i = 0; i < SIM_24LC32_PAGE; i++){
+		if(eeprom->latched & (1UL << i)) eeprom->mem[page | i] = eeprom->latch[i];
+	}
+	eeprom->latched = 0;
+	eeprom->busy_until = now + SIM_24LC32_TWC_NS;
+	eeprom->write_cycles++;
+}
+
+void sim_24lc32_init(sim_24lc32_t *eeprom, uint8_t addr){
+	memset(eeprom, 0, sizeof(*eeprom));
+	memset(eeprom->mem, 0xFF, sizeof(eeprom->mem));
+	eeprom->dev.addr = addr;
+	eeprom->dev.start = eeprom_start;
+	eeprom->dev.write = eeprom_write;
+	eeprom->dev.read = eeprom_read;
+	eeprom->dev.stop = eeprom_stop;
+	sim_i2c_attach(&eeprom->dev);
+}
+
+//*****************************************************************************
+// FT6x06
+//*****************************************************************************
+
+// In trigger mode INT goes low with each report, in polling mode it stays
+// low while a finger is down
+static void ft6x06_int_update(sim_ft6x06_t *ts){
+	bool low = ts->int_low;
+	
+	if(ts->regs[FT_G_MODE] != FT_G_MODE_TRIGGER) low = (ts->regs[FT_TD_STATUS] != 0);
+	pin_write(ts->int_port, ts->int_pin, !low);
+}
+
+static bool ft6x06_start(sim_i2c_dev_t *dev, bool read, uint64_t now){
+	((sim_ft6x06_t *)dev)->addressed = false;
+	return true;
+}
+
+static bool ft6x06_write(sim_i2c_dev_t *dev, uint8_t data, uint64_t now){
+	sim_ft6x06_t *ts = (sim_ft6x06_t *)dev;
+	
+	if(!ts->addressed){
+		ts->pointer = data;
+		ts->addressed = true;
+	}
+	else{
+		ts->regs[ts->pointer++] = data;
+		ft6x06_int_update(ts);
+	}
+	return true;
+}
+
+// Reading TD_STATUS takes the report and releases INT
+static uint8_t ft6x06_read(sim_i2c_dev_t *dev, uint64_t now){
+	sim_ft6x06_t *ts = (sim_ft6x06_t *)dev;
+	
+	if(ts->pointer == FT_TD_STATUS){
+		ts->int_low = false;
+		ft6x06_int_update(ts);
+	}
+	return ts->regs[ts->pointer++];
+}
+
+static void ft6x06_stop(sim_i2c_dev_t *dev, uint64_t now){
+}
+
+static void ft6x06_post(sim_ft6x06_t *ts, const sim_touch_t *step){
+	uint8_t *point = &ts->regs[FT_P1_XH];
+	uint8_t event;
+	
+	if(step->touches == 0){
+		// Lifted where it was last seen
+		point[0] = (FT_EVENT_LIFT_UP << 6) | (point[0] & 0x0F);
+	}
+	else{
+		event = (ts->regs[FT_TD_STATUS] == 0) ? FT_EVENT_PRESS_DOWN : FT_EVENT_CONTACT;
+		point[0] = (event << 6) | ((step->x >> 8) & 0x0F);
+		point[1] = step->x & 0xFF;
+		point[2] = (0 << 4) | ((step->y >> 8) & 0x0F);
+		point[3] = step->y & 0xFF;
+		point[4] = 0x40;
+		point[5] = 0x10;
+	}
+	ts->regs[FT_TD_STATUS] = step->touches;
+	ts->int_low = true;
+	ft6x06_int_update(ts);
+}
+
+static void ft6x06_tick(sim_i2c_dev_t *dev, uint64_t now){
+	sim_ft6x06_t *ts = (sim_ft6x06_t *)dev;
+	const sim_touch_t *script = ts->script;
+	uint64_t at;
+	
+	if(script == NULL) return;
+	while(ts->next < ts->script_len){
+		at = ts->start + script[ts->next].at_us * 1000ULL;
+		if(now < at){
+			sim_wake_at(at);
+			break;
+		}
+		ft6x06_post(ts, &script[ts->next]);
+		ts->posted = at;
+		ts->next++;
+	}
+}
+
+void sim_ft6x06_init(sim_ft6x06_t *ts, uint8_t addr, uint32_t int_port, uint8_t int_pin){
+	memset(ts, 0, sizeof(*ts));
+	memset(&ts->regs[FT_P1_XH], 0xFF, 2 * FT_POINT_BYTES);
+	ts->regs[FT_CIPHER] = 0x06;
+	ts->regs[FT_FOCALTECH_ID] = 0x11;
+	ts->int_port = int_port;
+	ts->int_pin = int_pin;
+	ts->dev.addr = addr;
+	ts->dev.start = ft6x06_start;
+	ts->dev.write = ft6x06_write;
+	ts->dev.read = ft6x06_read;
+	ts->dev.stop = ft6x06_stop;
+	ts->dev.tick = ft6x06_tick;
+	ft6x06_int_update(ts);
+	sim_i2c_attach(&ts->dev);
+}
+
+void sim_ft6x06_play(sim_ft6x06_t *ts, const sim_touch_t *script, uint32_t len){
+	ts->script_len = len;
+	ts->next = 0;
+	ts->start = sim_now();
+	__atomic_store_n(&ts->script, script, __ATOMIC_SEQ_CST);
+	if(len > 0) sim_wake_at(ts->start + script[0].at_us * 1000ULL);
+}
+
+//*****************************************************************************
+// MCP23017
+//*****************************************************************************
+
+// What GPIOB reads as.  An input with its pull-up off floats and reads low
+// here, so a driver that forgets the pull-ups sees every button held.
+static uint8_t pexp_gpiob(sim_mcp23017_t *pexp){
+	uint8_t in = pexp->regs[MCP_IODIRB];
+	uint8_t level = pexp->regs[MCP_GPPUB] & ~pexp->down;
+	
+	return ((level ^ pexp->regs[MCP_IPOLB]) & in) | (pexp->regs[MCP_OLATB] & ~in);
+}
+
+//*****************************************************************************
+// Function Name: pexp_update
+//*****************************************************************************
+//	Summary: Flags the GPIOB pins that interrupt, against the last value or
+//					 DEFVAL as INTCON selects, and drives INTB.  INTCAPB holds GPIOB
+//					 from the first of them until the interrupt is cleared.
+//
+//*****************************************************************************
+static void pexp_update(sim_mcp23017_t *pexp){
+	uint8_t gpio = pexp_gpiob(pexp);
+	uint8_t intcon = pexp->regs[MCP_INTCONB];
+	uint8_t fired;
+	bool active_high;
+	
+	fired = pexp->regs[MCP_GPINTENB] & ((~intcon & (gpio ^ pexp->gpiob)) | (intcon & (gpio ^ pexp->regs[MCP_DEFVALB])));
+	if(fired != 0){
+		if(pexp->regs[MCP_INTFB] == 0) pexp->regs[MCP_INTCAPB] = gpio;
+		pexp->regs[MCP_INTFB] |= fired;
+	}
+	pexp->gpiob = gpio;
+	
+	// Open drain overrides INTPOL
+	active_high = (pexp->regs[MCP_IOCON] & (MCP_IOCON_INTPOL | MCP_IOCON_ODR)) == MCP_IOCON_INTPOL;
+	pin_write(pexp->int_port, pexp->int_pin, (pexp->regs[MCP_INTFB] != 0) == active_high);
+}
+
+static bool pexp_start(sim_i2c_dev_t *dev, bool read, uint64_t now){
+	((sim_mcp23017_t *)dev)->addressed = false;
+	return true;
+}
+
+static bool pexp_write(sim_i2c_dev_t *dev, uint8_t data, uint64_t now){
+	sim_mcp23017_t *pexp = (sim_mcp23017_t *)dev;
+	uint8_t reg = pexp->pointer;
+	
+	if(!pexp->addressed){
+		pexp->pointer = data % SIM_MCP23017_REGS;
+		pexp->addressed = true;
+		return true;
+	}
+	
+	switch(reg){
+		case MCP_INTFB - 1:
+		case MCP_INTFB:
+		case MCP_INTCAPB - 1:
+		case MCP_INTCAPB:
+			break;
+		case MCP_GPIOA:
+		case MCP_GPIOB:
+			pexp->regs[reg + 2] = data;
+			break;
+		case MCP_IOCON:
+		case MCP_IOCON_MIRROR:
+			pexp->regs[MCP_IOCON] = data;
+			pexp->regs[MCP_IOCON_MIRROR] = data;
+			break;
+		default:
+			pexp->regs[reg] = data;
+			break;
+	}
+	pexp->pointer = (reg + 1) % SIM_MCP23017_REGS;
+	pexp_update(pexp);
+	return true;
+}
+
+// Reading GPIOB or INTCAPB clears the interrupt
+static uint8_t pexp_read(sim_i2c_dev_t *dev, uint64_t now){
+	sim_mcp23017_t *pexp = (sim_mcp23017_t *)dev;
+	uint8_t reg = pexp->pointer;
+	uint8_t data = (reg == MCP_GPIOB) ? pexp_gpiob(pexp) : pexp->regs[reg];
+	
+	if(reg == MCP_GPIOB || reg == MCP_INTCAPB){
+		pexp->regs[MCP_INTFB] = 0;
+		pexp_update(pexp);
+	}
+	pexp->pointer = (reg + 1) % SIM_MCP23017_REGS;
+	return data;
+}
+
+static void pexp_stop(sim_i2c_dev_t *dev, uint64_t now){
+}
+
+static void pexp_tick(sim_i2c_dev_t *dev, uint64_t now){
+	sim_mcp23017_t *pexp = (sim_mcp23017_t *)dev;
+	const sim_buttons_t *script = pexp->script;
+	uint64_t at;
+	
+	if(script == NULL) return;
+	while(pexp->next < pexp->script_len){
+		at = pexp->start + script[pexp->next].at_us * 1000ULL;
+		if(now < at){
+			sim_wake_at(at);
+			break;
+		}
+		pexp->down = script[pexp->next].down;
+		pexp_update(pexp);
+		pexp->posted = at;
+		pexp->next++;
+	}
+}
+
+void sim_mcp23017_init(sim_mcp23017_t *pexp, uint8_t addr, uint32_t int_port, uint8_t int_pin){
+	memset(pexp, 0, sizeof(*pexp));
+	pexp->regs[MCP_IODIRB - 1] = 0xFF;
+	pexp->regs[MCP_IODIRB] = 0xFF;
+	pexp->int_port = int_port;
+	pexp->int_pin = int_pin;
+	pexp->dev.addr = addr;
+	pexp->dev.start = pexp_start;
+	pexp->dev.write = pexp_write;
+	pexp->dev.read = pexp_read;
+	pexp->dev.stop = pexp_stop;
+	pexp->dev.tick = pexp_tick;
+	pexp->gpiob = pexp_gpiob(pexp);
+	pexp_update(pexp);
+	sim_i2c_attach(&pexp->dev);
+}
+
+void sim_mcp23017_play(sim_mcp23017_t *pexp, const sim_buttons_t *script, uint32_t len){
+	pexp->script_len = len;
+	pexp->next = 0;
+	pexp->start = sim_now();
+	__atomic_store_n(&pexp->script, script, __ATOMIC_SEQ_CST);
+	if(len > 0) sim_wake_at(pexp->start + script[0].at_us * 1000ULL);
+}
@@ -0,0 +1,154 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Models of the slaves on the board's I2C1 bus, to attach to the master in
+// sim_hw.c with sim_i2c_attach: the 24LC32 EEPROM, the FT6x06 touch
+// controller and the MCP23017 port expander the buttons are on.  Each is
+// built from its datasheet rather than from the drivers' defines, so a
+// driver with a wrong register address fails against it.
+//
+// The touch controller and the port expander replay a script of timed
+// inputs and drive their INT pins on GPIOF.  GPIOF is plain memory in the
+// harness, with no edge latch, so the models hold INT low until the report
+// that raised it is read rather than pulsing it.
+
+#ifndef __SIM_I2C_DEV_H__
+#define __SIM_I2C_DEV_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sim_hw.h"
+
+#define SIM_24LC32_SIZE				4096
+#define SIM_24LC32_PAGE				32
+
+// Longest write cycle the 24LC32A datasheet allows.  The part NACKs its
+// address until the cycle is over.
+#define SIM_24LC32_TWC_NS			5000000ULL
+
+#define SIM_MCP23017_REGS			0x16
+
+typedef struct {
+	sim_i2c_dev_t	dev;
+	uint8_t		mem[SIM_24LC32_SIZE];
+	uint16_t	pointer;					// address the next byte is read from or written to
+	uint32_t	received;					// bytes written since the START
+	uint8_t		latch[SIM_24LC32_PAGE];	// page buffer
+	uint32_t	latched;					// bits of the page buffer written since the START
+	uint64_t	busy_until;				// end of the write cycle in progress
+	uint32_t	write_cycles;
+	uint32_t	busy_nacks;				// addresses NACKed during a write cycle
+} sim_24lc32_t;
+
+// One step of a touch script: from at_us after sim_ft6x06_play, touches
+// fingers are down and the first is at (x, y)
+typedef struct {
+	uint32_t	at_us;
+	uint8_t		touches;
+	uint16_t	x;
+	uint16_t	y;
+} sim_touch_t;
+
+typedef struct {
+	sim_i2c_dev_t	dev;
+	uint8_t		regs[256];
+	uint8_t		pointer;
+	bool			addressed;				// the register pointer was written since the START
+	uint32_t	int_port;
+	uint8_t		int_pin;
+	bool			int_low;
+	const sim_touch_t * volatile script;
+	uint32_t	script_len;
+	volatile uint32_t	next;			// script steps reported so far
+	uint64_t	start;						// sim_now time the script started at
+	uint64_t	posted;						// sim_now time of the last report
+} sim_ft6x06_t;
+
+// One step of a button script: from at_us after sim_mcp23017_play, the
+// buttons on the GPIOB pins set in down are held, pulling the pins low
+typedef struct {
+	uint32_t	at_us;
+	uint8_t		down;
+} sim_buttons_t;
+
+typedef struct {
+	sim_i2c_dev_t	dev;
+	uint8_t		regs[SIM_MCP23017_REGS];
+	uint8_t		pointer;
+	bool			addressed;
+	uint8_t		down;							// GPIOB pins held low by a button
+	uint8_t		gpiob;						// GPIOB as last compared for interrupt on change
+	uint32_t	int_port;
+	uint8_t		int_pin;
+	const sim_buttons_t * volatile script;
+	uint32_t	script_len;
+	volatile uint32_t	next;
+	uint64_t	start;
+	uint64_t	posted;						// sim_now time of the last change on GPIOB
+} sim_mcp23017_t;
+
+//*****************************************************************************
+// Function Name: sim_24lc32_init
+//*****************************************************************************
+//	Summary: Erases the EEPROM to 0xFF and attaches it at addr
+//
+//*****************************************************************************
+void sim_24lc32_init(sim_24lc32_t *eeprom, uint8_t addr);
+
+//*****************************************************************************
+// Function Name: sim_ft6x06_init
+//*****************************************************************************
+//	Summary: Attaches a touch controller with nothing touching it at addr.
+//					 INT is pin int_pin of the GPIO port at int_port.
+//
+//*****************************************************************************
+void sim_ft6x06_init(sim_ft6x06_t *ts, uint8_t addr, uint32_t int_port, uint8_t int_pin);
+
+//*****************************************************************************
+// Function Name: sim_ft6x06_play
+//*****************************************************************************
+//	Summary: Starts the touch script.  Each step posts a report when its time
+//					 comes: PRESS_DOWN for the first touch, CONTACT while it is
+//					 held and LIFT_UP at the point it left when it is released.
+//
+//*****************************************************************************
+void sim_ft6x06_play(sim_ft6x06_t *ts, const sim_touch_t *script, uint32_t len);
+
+//*****************************************************************************
+// Function Name: sim_mcp23017_init
+//*****************************************************************************
+//	Summary: Attaches a port expander in its reset state with no button held
+//					 at addr.  INTB is pin int_pin of the GPIO port at int_port.
+//
+//*****************************************************************************
+void sim_mcp23017_init(sim_mcp23017_t *pexp, uint8_t addr, uint32_t int_port, uint8_t int_pin);
+
+//*****************************************************************************
+// Function Name: sim_mcp23017_play
+//*****************************************************************************
+//	Summary: Starts the button script
+//
+//*****************************************************************************
+void sim_mcp23017_play(sim_mcp23017_t *pexp, const sim_buttons_t *script, uint32_t len);
+
+#endif
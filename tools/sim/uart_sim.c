@@ -0,0 +1,140 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Runs the UART0 serial stack, peripherals/c/serial_debug.c and the drivers
+// under it, against the register model in sim_hw.c.  Queues a known byte
+// stream the way the frame loop does, checks what leaves the UART and
+// reports what it cost the CPU.
+//
+// Built by the Makefile in this directory: uart_sim uses the uDMA TX path
+// and uart_sim_irq, built with -DSERIAL_DEBUG_TX_IRQ, the interrupt driven
+// one.  "make check" runs both.
+//
+// Usage:
+//   ./uart_sim [-m] [-n bytes] [-c chunk]
+//
+// -n is the number of bytes to send, 16384 by default, and -c the size of
+// each serial_debug_write, 64 by default.  -m sends them one at a time with
+// serial_debug_tx and interrupts masked instead, as the fault handler does.
+// Exits with 1 if the bytes sent do not match the bytes queued or a byte
+// was written to a full TX FIFO.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "sim_hw.h"
+#include "serial_debug.h"
+
+static uint32_t num_bytes = 16384;
+static uint32_t chunk = 64;
+static bool masked = false;
+
+static uint32_t received = 0;
+static uint32_t mismatches = 0;
+
+//*****************************************************************************
+// Function Name: pattern
+//*****************************************************************************
+//	Summary: Byte n of the test stream.  Not periodic in the ring size, so a
+//					 span sent twice or skipped shows up.
+//
+//*****************************************************************************
+static uint8_t pattern(uint32_t n){
+	return (uint8_t)(n ^ (n >> 8) ^ (n >> 13));
+}
+
+static void check_byte(uint8_t data){
+	if(data != pattern(received)) mismatches++;
+	received++;
+}
+
+int main(int argc, char **argv){
+	char buf[UART_TX_BUFFER_SIZE];
+	const sim_stats_t *stats;
+	uint32_t queued = 0, accepted, len, i;
+	uint64_t start, elapsed, write_ns = 0, t;
+	int opt;
+	
+	while((opt = getopt(argc, argv, "mn:c:")) != -1){
+		switch(opt){
+			case 'm':	masked = true; break;
+			case 'n':	num_bytes = strtoul(optarg, NULL, 0); break;
+			case 'c':	chunk = strtoul(optarg, NULL, 0); break;
+			default:
+				fprintf(stderr, "usage: uart_sim [-m] [-n bytes] [-c chunk]\n");
+				return 2;
+		}
+	}
+	if(chunk == 0 || chunk > sizeof(buf)) chunk = sizeof(buf);
+	
+	sim_init();
+	sim_set_tx_sink(check_byte);
+	init_serial_debug(true, true);
+	
+	start = sim_now();
+	if(masked){
+		__disable_irq();
+		for(queued = 0; queued < num_bytes; queued++){
+			serial_debug_tx(UART0_BASE, &UART0_Tx_Buffer, pattern(queued));
+		}
+		serial_debug_tx_drain(UART0_BASE, &UART0_Tx_Buffer);
+		__enable_irq();
+	}
+	while(queued < num_bytes){
+		len = (num_bytes - queued < chunk) ? num_bytes - queued : chunk;
+		for(i = 0; i < len; i++) buf[i] = pattern(queued + i);
+		
+		t = sim_now();
+		accepted = serial_debug_write(UART0_BASE, &UART0_Tx_Buffer, buf, len);
+		write_ns += sim_now() - t;
+		
+		queued += accepted;
+		if(accepted < len) sim_wait();
+	}
+	while(!ring_empty(&UART0_Tx_Buffer) || !sim_tx_idle()) sim_wait();
+	elapsed = sim_now() - start;
+	
+	stats = sim_get_stats();
+	fprintf(stderr, "sent %u of %u bytes in %.3f s, %.0f bytes/s\n", received, num_bytes,
+					elapsed / 1e9, received * 1e9 / elapsed);
+	fprintf(stderr, "UART0_Handler: %llu entries, %.1f bytes per entry, %.1f register accesses per KB\n",
+					(unsigned long long)stats->isr_entries,
+					stats->isr_entries ? (double)received / stats->isr_entries : 0.0,
+					received ? stats->isr_reg_accesses * 1024.0 / received : 0.0);
+	fprintf(stderr, "register accesses: %llu reads, %llu writes\n",
+					(unsigned long long)stats->reg_reads, (unsigned long long)stats->reg_writes);
+	fprintf(stderr, "DR writes: %llu by the CPU, %llu by uDMA in %llu buffers, %llu overflowed\n",
+					(unsigned long long)stats->cpu_tx_bytes, (unsigned long long)stats->dma_tx_bytes,
+					(unsigned long long)stats->dma_buffers, (unsigned long long)stats->tx_overflows);
+	fprintf(stderr, "time in serial_debug_write %.1f ms, in UART0_Handler %.1f ms\n",
+					write_ns / 1e6, stats->isr_ns / 1e6);
+	
+	if(received != num_bytes || mismatches != 0 || stats->tx_overflows != 0){
+		fprintf(stderr, "FAIL: %u of %u bytes received, %u out of order, %llu TX FIFO overflows\n",
+						received, num_bytes, mismatches, (unsigned long long)stats->tx_overflows);
+		return 1;
+	}
+	return 0;
+}
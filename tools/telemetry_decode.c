@@ -0,0 +1,136 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Host decoder for the UART0 telemetry stream, see HW4/telemetry.h.
+//
+// Build on Linux from the repository root:
+//   cc -O2 -IHW4 -o telemetry_decode tools/telemetry_decode.c tools/tlm_stream.c HW4/crc16.c
+//
+// Usage:
+//   stty -F /dev/ttyACM0 115200 raw -echo
+//   ./telemetry_decode < /dev/ttyACM0 > run.csv
+//
+// Each record becomes one CSV row, the first column is the record type and
+// the rest are that type's fields.  A header row is printed the first time
+// each type is seen.  Text from put_string and damaged records fail the CRC
+// and are counted on stderr instead of printed.
+//
+// Trace records are expanded with the format strings in HW4/trace_msgs.h,
+// so rebuild this tool whenever that table changes.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tlm_stream.h"
+#include "trace.h"
+
+// Format strings indexed by trace message ID
+static const char *trace_formats[TRACE_NUM_MSGS] = {
+#define TRACE_MSG(name, format)	format,
+#include "trace_msgs.h"
+#undef TRACE_MSG
+};
+
+static uint32_t unknown_records = 0;
+static bool header_done[256];
+
+//*****************************************************************************
+// Function Name: header
+//*****************************************************************************
+//	Summary: Prints the column names of a record type once
+//
+//*****************************************************************************
+static void header(uint8_t type, const char *columns){
+	if(header_done[type]) return;
+	header_done[type] = true;
+	printf("%s\n", columns);
+}
+
+//*****************************************************************************
+// Function Name: print_record
+//*****************************************************************************
+//	Summary: Prints one checked record as a CSV row
+//
+//*****************************************************************************
+static void print_record(const uint8_t *rec, int size){
+	const uint8_t *p = rec + TLM_HEADER_SIZE;
+	uint8_t type = rec[0];
+	uint8_t seq = rec[1];
+	char message[160];
+	uint16_t id;
+	
+	switch(type){
+		case TLM_FRAME:
+			if(size != TLM_FRAME_SIZE) break;
+			header(type, "frame,seq,frame,ticks,busy_us,max_us,lag_us,overruns,drops");
+			printf("frame,%u,%u,%u,%u,%u,%u,%u,%u\n", seq, tlm_get16(p), p[2], tlm_get16(p + 3),
+						 tlm_get16(p + 5), tlm_get16(p + 7), p[9], p[10]);
+			return;
+		case TLM_ENTITIES:
+			if(size != TLM_ENTITIES_SIZE) break;
+			header(type, "entities,seq,units,player_bullets,enemy_bullets,lives,level");
+			printf("entities,%u,%u,%u,%u,%u,%u\n", seq, p[0], p[1], p[2], p[3], p[4]);
+			return;
+		case TLM_I2C:
+			if(size != TLM_I2C_SIZE) break;
+			header(type, "i2c,seq,transfers,async_xfers,bytes,nacks,timeouts,max_us");
+			printf("i2c,%u,%u,%u,%u,%u,%u,%u\n", seq, tlm_get16(p), tlm_get16(p + 2), tlm_get16(p + 4),
+						 p[6], p[7], tlm_get16(p + 8));
+			return;
+		case TLM_SCORE:
+			if(size != TLM_SCORE_SIZE) break;
+			header(type, "score,seq,score,points,unit_type");
+			printf("score,%u,%lu,%u,%u\n", seq, (unsigned long)tlm_get32(p), tlm_get16(p + 4), p[6]);
+			return;
+		case TLM_TRACE:
+			if(size != TLM_TRACE_SIZE) break;
+			header(type, "trace,seq,tick,id,message");
+			id = tlm_get16(p);
+			if(id < TRACE_NUM_MSGS) snprintf(message, sizeof(message), trace_formats[id], tlm_get32(p + 4), tlm_get32(p + 8));
+			else snprintf(message, sizeof(message), "unknown message %u", id);
+			printf("trace,%u,%u,%u,\"%s\"\n", seq, tlm_get16(p + 2), id, message);
+			return;
+		case TLM_RECT:
+		case TLM_STALE:
+			// LCD mirror records are for mirror_view
+			return;
+		default:
+			break;
+	}
+	unknown_records++;
+}
+
+int main(void){
+	tlm_stream_t stream;
+	uint8_t rec[TLM_STREAM_MAX_ENCODED];
+	int size;
+	
+	tlm_stream_init(&stream, stdin);
+	while((size = tlm_stream_read(&stream, rec)) >= 0){
+		print_record(rec, size);
+		fflush(stdout);
+	}
+	fprintf(stderr, "%lu bad records, %lu lost records, %lu unknown records\n", (unsigned long)stream.bad_records,
+					(unsigned long)stream.lost_records, (unsigned long)unknown_records);
+	return 0;
+}
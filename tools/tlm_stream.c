@@ -0,0 +1,110 @@
+// Copyright (c) 2015-16, Joe Krachey
+// All rights reserved.
+//
+// Redistribution and use in source or binary form, with or without modification, 
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions in source form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in 
+//    the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR 
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR 
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; 
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "crc16.h"
+#include "tlm_stream.h"
+
+//*****************************************************************************
+// Function Name: tlm_get16 / tlm_get32
+//*****************************************************************************
+//	Summary: Read little endian fields
+//
+//*****************************************************************************
+uint16_t tlm_get16(const uint8_t *p){
+	return p[0] | (p[1] << 8);
+}
+
+uint32_t tlm_get32(const uint8_t *p){
+	return tlm_get16(p) | ((uint32_t)tlm_get16(p + 2) << 16);
+}
+
+//*****************************************************************************
+// Function Name: cobs_decode
+//*****************************************************************************
+//	Summary: Decodes len bytes of src into dst.  Returns the decoded length,
+//					 or -1 if a code byte points past the end of the record.
+//
+//*****************************************************************************
+static int cobs_decode(const uint8_t *src, int len, uint8_t *dst){
+	int in = 0, out = 0, i, code;
+	
+	while(in < len){
+		code = src[in++];
+		if(code == 0 || in + code - 1 > len) return -1;
+		for(i = 1; i < code; i++) dst[out++] = src[in++];
+		if(code != 0xFF && in < len) dst[out++] = 0;
+	}
+	return out;
+}
+
+//*****************************************************************************
+// Function Name: tlm_stream_init
+//*****************************************************************************
+//	Summary: Starts reading records from file
+//
+//*****************************************************************************
+void tlm_stream_init(tlm_stream_t *stream, FILE *file){
+	stream->file = file;
+	stream->len = 0;
+	stream->overflow = false;
+	stream->last_seq = -1;
+	stream->bad_records = 0;
+	stream->lost_records = 0;
+}
+
+//*****************************************************************************
+// Function Name: tlm_stream_read
+//*****************************************************************************
+//	Summary: Reads until one record passes its checks and copies its type,
+//					 sequence number and payload into rec.  rec must hold
+//					 TLM_STREAM_MAX_ENCODED bytes.
+//
+//	Returns: the payload size, or -1 at the end of the file
+//
+//*****************************************************************************
+int tlm_stream_read(tlm_stream_t *stream, uint8_t *rec){
+	int c, n;
+	
+	while((c = getc(stream->file)) != EOF){
+		if(c != 0){
+			// A record this long is text or noise, skip to the next delimiter
+			if(stream->len < TLM_STREAM_MAX_ENCODED) stream->encoded[stream->len++] = c;
+			else stream->overflow = true;
+			continue;
+		}
+		
+		// Back to back delimiters are empty, not bad
+		if(stream->len == 0) continue;
+		n = stream->overflow ? -1 : cobs_decode(stream->encoded, stream->len, rec);
+		stream->len = 0;
+		stream->overflow = false;
+		
+		if(n < TLM_HEADER_SIZE + TLM_CRC_SIZE ||
+			 crc16(CRC16_INIT, rec, n - TLM_CRC_SIZE) != tlm_get16(rec + n - TLM_CRC_SIZE)){
+			stream->bad_records++;
+			continue;
+		}
+		if(stream->last_seq >= 0) stream->lost_records += (uint8_t)(rec[1] - stream->last_seq - 1);
+		stream->last_seq = rec[1];
+		return n - TLM_HEADER_SIZE - TLM_CRC_SIZE;
+	}
+	return -1;
+}
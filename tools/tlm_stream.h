@@ -1,4 +1,4 @@
-// Copyright (c) 2015, Joe Krachey
+// Copyright (c) 2015-16, Joe Krachey
 // All rights reserved.
 //
 // Redistribution and use in source or binary form, with or without modification, 
@@ -20,62 +20,56 @@
 // NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
-#ifndef __PC_BUFFER_H__
-#define __PC_BUFFER_H__
+// Reads COBS framed telemetry records, see HW4/telemetry.h, for the host
+// tools in this directory.
 
-#include <stdbool.h>
+#ifndef __TLM_STREAM_H__
+#define __TLM_STREAM_H__
+
+#include <stdio.h>
 #include <stdint.h>
-#include <stdlib.h>
+#include <stdbool.h>
 
-typedef __packed struct {
-	volatile uint32_t	produce_count;		// volatile unsigned 32-bit integer that holds the number of characters added to the circular buffer
-	volatile uint32_t	consume_count;		// volatile unsigned 32-bit integer that holds the number of characters removed from the circular buffer       
-	uint16_t					BUFFER_SIZE;			// unsigned 16-bit integer that holds the size of the circular buffer.
-	volatile char*		array;						// volatile char pointer that holds the address of SRAM used to store data in the circular buffer.
-} PC_Buffer ;
+#include "telemetry.h"
 
-//*****************************************************************************
-// Initializes a Producer-Consumer circular buffer.  Be sure to allocate 
-// memory using malloc for the array field.
-// 
-// Parameters
-//    buffer  :   The address of the circular buffer.
-//    size:       Number of entries in the circular buffer.
-//*****************************************************************************
-void pc_buffer_init(PC_Buffer *buffer, uint16_t buffer_size);
+#define TLM_STREAM_MAX_ENCODED		256
 
-//*****************************************************************************
-// Adds a character to the circular buffer.
-// 
-// Parameters
-//    buffer  :   The address of the circular buffer.
-//    data    :   Character to add.
-//*******************************************************************************
-void pc_buffer_add(PC_Buffer *buffer, char data);
+typedef struct {
+	FILE *file;
+	uint8_t encoded[TLM_STREAM_MAX_ENCODED];
+	int len;
+	bool overflow;
+	int last_seq;
+	uint32_t bad_records;						// failed COBS or CRC checks, including text
+	uint32_t lost_records;					// gaps in the sequence numbers
+} tlm_stream_t;
 
 //*****************************************************************************
-// Removes the oldest character from the circular buffer.
-// 
-// Parameters
-//    buffer  :   The address of the circular buffer.
-//    data    :   Address to place the oldest character.
+// Function Name: tlm_stream_init
 //*****************************************************************************
-void pc_buffer_remove(PC_Buffer *buffer, char *data);
+//	Summary: Starts reading records from file
+//
+//*****************************************************************************
+void tlm_stream_init(tlm_stream_t *stream, FILE *file);
 
 //*****************************************************************************
-// Returns true if the circular buffer is empty.  Returns false if it is not.
-// 
-// Parameters
-//    buffer  :   The address of the circular buffer.
+// Function Name: tlm_stream_read
+//*****************************************************************************
+//	Summary: Reads until one record passes its checks and copies its type,
+//					 sequence number and payload into rec
+//
+//	Returns: the payload size, or -1 at the end of the file
+//
 //*****************************************************************************
-bool pc_buffer_empty(PC_Buffer *buffer);
+int tlm_stream_read(tlm_stream_t *stream, uint8_t *rec);
 
 //*****************************************************************************
-// Returns true if the circular buffer is full.  Returns false if it is not.
-// 
-// Parameters
-//    buffer  :   The address of the circular buffer.
+// Function Name: tlm_get16 / tlm_get32
+//*****************************************************************************
+//	Summary: Read little endian fields
+//
 //*****************************************************************************
-bool pc_buffer_full(PC_Buffer *buffer);
+uint16_t tlm_get16(const uint8_t *p);
+uint32_t tlm_get32(const uint8_t *p);
 
 #endif